@@ -0,0 +1,7 @@
+#pragma once
+#include "command_line.h"
+#include "alns.h"
+
+// solves every instance of the manifest options.batch on options.threads threads with parameters, and prints a tab
+// separated line per instance as it finishes. returns the exit code of the program
+int batch(const program_options &options, const vrp::alns_parameters &parameters);
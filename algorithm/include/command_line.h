@@ -1,10 +1,26 @@
 #pragma once
 #include <string>
+#include <vector>
 
 struct program_options
 {
 	std::string instance;
+	std::string graph_cache;
+	std::string batch;
+	std::vector<std::string> tune;
+	std::size_t tune_budget;
 	std::size_t seed;
+	double time_limit;
+	std::size_t iteration_limit;
+	std::string checkpoint;
+	std::size_t checkpoint_interval;
+	bool resume;
+	std::size_t threads;
+	std::size_t migration_interval;
+	std::string topology;
+	bool merge_weights;
+	std::size_t regret_k;
+	std::size_t repair_threads;
 	int weight1, weight2, weight3, weight4;
 	double rf, dod, W, d_param;
 	bool CI, II, RD, WD, CD, GR, RR;
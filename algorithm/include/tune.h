@@ -0,0 +1,7 @@
+#pragma once
+#include "command_line.h"
+#include "alns.h"
+
+// races ALNS configurations on the instances of options.tune, starting from parameters, and prints the best ones as
+// command line options. returns the exit code of the program
+int tune(const program_options &options, const vrp::alns_parameters &parameters);
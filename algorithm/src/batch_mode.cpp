@@ -0,0 +1,33 @@
+#include "batch_mode.h"
+#include "batch.h"
+
+#include <chrono>
+#include <iostream>
+
+int batch(const program_options &options, const vrp::alns_parameters &parameters)
+{
+	std::vector<vrp::batch_job> jobs;
+	try
+	{
+		jobs = vrp::read_manifest(options.batch, options.time_limit);
+	}
+	catch (const std::exception &e)
+	{
+		std::cout << e.what() << '\n';
+		return 1;
+	}
+
+	std::size_t failed = 0;
+	auto start = std::chrono::steady_clock::now();
+	std::cout << "instance\tname\tcustomers\tcost\tunrouted\titerations\tseconds\terror\n" << std::flush;
+	vrp::solve_batch(jobs, parameters, options.threads, [&](const vrp::batch_result &result)
+	{
+		failed += !result.error.empty();
+		std::cout << jobs[result.job].instance.c_str() << '\t' << result.name.c_str() << '\t' << result.customers << '\t' << result.cost << '\t'
+			<< result.unrouted << '\t' << result.statistics.iterations << '\t' << result.statistics.seconds << '\t' << result.error.c_str() << '\n' << std::flush;
+	});
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cerr << jobs.size() << " instances, " << failed << " failed, in " << seconds << "s\n";
+	return failed ? 1 : 0;
+}
@@ -12,7 +12,22 @@ program_options get_command_line(int argc, char **argv)
 	desc.add_options()
 		("help,h", "produce help message")
 		("instance,i", po::value<std::string>(), "Instance file")
+		("batch", po::value<std::string>(), "Manifest of instances to solve, one per line with an optional time limit in seconds, instead of solving one")
+		("tune", po::value<std::vector<std::string>>()->multitoken(), "Race ALNS parameters on these instance files instead of solving, each run limited by the time and iteration limits")
+		("tune-budget", po::value<std::size_t>()->default_value(1000), "ALNS runs the tuning may use")
+		("graph-cache", po::value<std::string>(), "Graph file mapped instead of computing the distances, written first if missing or stale")
 		("seed,s", po::value<std::size_t>(), "Random number generator seed")
+		("time-limit", po::value<double>()->default_value(0), "Wall clock seconds the search may take (0 for no limit)")
+		("iteration-limit", po::value<std::size_t>()->default_value(25000), "Iterations per search")
+		("checkpoint", po::value<std::string>(), "File the searches are periodically saved to")
+		("checkpoint-interval", po::value<std::size_t>()->default_value(1000), "Iterations between checkpoints of a search")
+		("resume", po::value<std::string>()->default_value("false"), "Continue from the checkpoint file if it exists (true/false)")
+		("threads,t", po::value<std::size_t>()->default_value(1), "Number of searches run in parallel (0 for one per core)")
+		("migration-interval", po::value<std::size_t>()->default_value(0), "Iterations between solution migrations between searches (0 for independent searches)")
+		("topology", po::value<std::string>()->default_value("ring"), "Migration topology (ring/broadcast)")
+		("regret-k", po::value<std::size_t>()->default_value(2), "Number of cheapest routes compared by regret repair")
+		("repair-threads", po::value<std::size_t>()->default_value(1), "Threads per search for greedy and regret repair (0 for one per core)")
+		("merge-weights", po::value<std::string>()->default_value("false"), "Merge operator weights on migration (true/false)")
 		("weight1", po::value<int>()->default_value(24), "Weight 1")
 		("weight2", po::value<int>()->default_value(22), "Weight 2")
 		("weight3", po::value<int>()->default_value(20), "Weight 3")
@@ -46,11 +61,39 @@ program_options get_command_line(int argc, char **argv)
 		if (vm.count("instance"))
 			res.instance = vm["instance"].as<std::string>();
 
+		if (vm.count("batch"))
+			res.batch = vm["batch"].as<std::string>();
+
+		if (vm.count("tune"))
+			res.tune = vm["tune"].as<std::vector<std::string>>();
+		res.tune_budget = vm["tune-budget"].as<std::size_t>();
+
+		if (vm.count("graph-cache"))
+			res.graph_cache = vm["graph-cache"].as<std::string>();
+
 		if (vm.count("seed"))
 			res.seed = vm["seed"].as<std::size_t>();
 		else
 			res.seed = static_cast<std::size_t>(-1);
 
+		res.time_limit = vm["time-limit"].as<double>();
+		if (res.time_limit < 0)
+			throw std::runtime_error("Invalid time limit");
+		res.iteration_limit = vm["iteration-limit"].as<std::size_t>();
+		if (vm.count("checkpoint"))
+			res.checkpoint = vm["checkpoint"].as<std::string>();
+		res.checkpoint_interval = vm["checkpoint-interval"].as<std::size_t>();
+		if (res.checkpoint_interval == 0)
+			throw std::runtime_error("Invalid checkpoint interval");
+
+		res.threads = vm["threads"].as<std::size_t>();
+		res.migration_interval = vm["migration-interval"].as<std::size_t>();
+		res.regret_k = vm["regret-k"].as<std::size_t>();
+		res.repair_threads = vm["repair-threads"].as<std::size_t>();
+		res.topology = boost::to_lower_copy(vm["topology"].as<std::string>());
+		if (res.topology != "ring" && res.topology != "broadcast")
+			throw std::runtime_error("Invalid topology, \"" + res.topology + '"');
+
 		res.weight1 = vm["weight1"].as<int>();
 		res.weight2 = vm["weight2"].as<int>();
 		res.weight3 = vm["weight3"].as<int>();
@@ -78,6 +121,10 @@ program_options get_command_line(int argc, char **argv)
 		res.CD = get_bool(vm["CD"].as<std::string>());
 		res.GR = get_bool(vm["GR"].as<std::string>());
 		res.RR = get_bool(vm["RR"].as<std::string>());
+		res.merge_weights = get_bool(vm["merge-weights"].as<std::string>());
+		res.resume = get_bool(vm["resume"].as<std::string>());
+		if (res.resume && res.checkpoint.empty())
+			throw std::runtime_error("--resume needs a --checkpoint file");
 
 		return res;
 	}
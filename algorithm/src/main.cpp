@@ -1,17 +1,52 @@
 #include "info.h"
+#include "instance.h"
+#include "graph_cache.h"
+#include "multistart.h"
+#include "island.h"
 #include "command_line.h"
+#include "tune.h"
+#include "batch_mode.h"
 
 #include "utility.h"
 
 #include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+static bool same_customers(const vrp::customer_info &a, const vrp::customer_info &b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (std::size_t i = 0; i < a.size(); ++i)
+		if (a.node(i).pos().x != b.node(i).pos().x || a.node(i).pos().y != b.node(i).pos().y || a.node(i).demand() != b.node(i).demand())
+			return false;
+	return true;
+}
 
 int main(int argc, char **argv)
 {
 	program_options options = get_command_line(argc, argv);
 	
 	vrp::fleet_info vehicles;
+	vrp::customer_info customers;
+	if (!options.instance.empty())
+	{
+		try
+		{
+			vrp::instance instance = vrp::read_instance(options.instance);
+			std::cout << "instance " << instance.name.c_str() << ": " << instance.customers.size() - 1 << " customers, " << instance.fleet.fleet_count() << " vehicles\n";
+			customers = std::move(instance.customers);
+			vehicles = instance.fleet;
+		}
+		catch (const std::exception &e)
+		{
+			std::cout << e.what() << '\n';
+			return 1;
+		}
+	}
+	else
 	{
-		// TODO: read from file
 		std::size_t auto_count = 3;
 		std::size_t van_count = 4;
 		std::size_t drone_count = 2;
@@ -26,10 +61,147 @@ int main(int argc, char **argv)
 		vrp::vehicle truck_drone_data{.capacity = 2000, .max_range = 200, .cost = 30};
 
 		vehicles = vrp::fleet_info(auto_count, van_count, drone_count, truck_drone_count, labor_cost, electric_cost, fuel_cost, emmision_cost, auto_data, van_data, drone_data, truck_drone_data);
+
+		vrp::geographic_vec2 knoxville{35.9606, 83.9207};
+		customers = vrp::random_customers(100, knoxville, 10, 1, 6, options.seed);
 	}
+	vrp::alns_parameters parameters{
+		.scores = {static_cast<double>(options.weight1), static_cast<double>(options.weight2), static_cast<double>(options.weight3), static_cast<double>(options.weight4)},
+		.reaction_factor = options.rf,
+		.degree_of_destruction = options.dod,
+		.start_worse = options.W,
+		.determinism = options.d_param,
+		.iterations = options.iteration_limit,
+		.time_limit = options.time_limit,
+		.checkpoint_interval = options.checkpoint_interval,
+		.regret_k = options.regret_k,
+		.repair_threads = options.repair_threads,
+		.destroy = {options.II, options.RD, options.WD, options.CD},
+		.repair = {options.CI, options.GR, options.RR},
+		.seed = options.seed == static_cast<std::size_t>(-1) ? std::random_device{}() : options.seed,
+	};
+
+	if (!options.batch.empty())
+		return batch(options, parameters);
+	if (!options.tune.empty())
+		return tune(options, parameters);
+
+	// runs the searches on graph, computed or mapped from the graph cache
+	auto solve = [&](const auto &graph)
+	{
+		using Graph = std::remove_cvref_t<decltype(graph)>;
+
+		auto report = [](const auto &search, double seconds)
+		{
+			std::size_t iterations = 0;
+			for (std::size_t i = 0; i < search.thread_count(); ++i)
+			{
+				const vrp::search_report &report = search.reports()[i];
+				iterations += report.statistics.iterations;
+				std::cout << "thread " << i << ": " << report.statistics.iterations << " iterations (" << report.statistics.iterations_per_second() << " iterations/s, " << report.statistics.duplicates << " revisits), best " << report.best_objective << '\n';
+			}
+
+			std::cout << "best cost: " << search.best().cost() << '\n';
+			std::cout << "unrouted customers: " << vrp::basic_alns<Graph>::unrouted(search.best()) << '\n';
+			std::cout << "iterations: " << iterations << " in " << seconds << "s (" << iterations / seconds << " iterations/s)\n";
+		};
+
+		// resumes search from the checkpoint file if asked to and it exists, and saves the search to it while it runs
+		std::optional<vrp::checkpoint_writer> writer;
+		auto checkpoint = [&](auto &search)
+		{
+			if (options.checkpoint.empty())
+				return;
+			try
+			{
+				if (options.resume && std::filesystem::exists(options.checkpoint))
+				{
+					search.resume(vrp::load_checkpoint(options.checkpoint));
+					std::cout << "resuming from " << options.checkpoint.c_str() << '\n';
+				}
+			}
+			catch (const std::exception &e)
+			{
+				std::cout << e.what() << '\n';
+				std::exit(1);
+			}
+			writer.emplace(options.checkpoint, graph.size(), search.thread_count());
+			search.checkpoint_to(*writer);
+		};
+		auto finish = [&]()
+		{
+			if (!writer)
+				return;
+			try
+			{
+				writer->flush();
+				std::cout << "checkpoint: " << options.checkpoint.c_str() << '\n';
+			}
+			catch (const std::exception &e)
+			{
+				std::cout << e.what() << '\n';
+			}
+		};
 
-	vrp::geographic_vec2 knoxville{35.9606, 83.9207};
-	vrp::customer_info customers = vrp::random_customers(5, knoxville, 10, 1, 6, options.seed);
+		auto start = std::chrono::steady_clock::now();
+		if (options.migration_interval)
+		{
+			vrp::island_parameters islands{
+				.migration_interval = options.migration_interval,
+				.topology = options.topology == "ring" ? vrp::migration_topology::ring : vrp::migration_topology::broadcast_best,
+				.merge_weights = options.merge_weights,
+			};
+			vrp::basic_islands<Graph> search(graph, vehicles, parameters, islands, options.threads);
+			checkpoint(search);
+			search.run();
+			finish();
+			report(search, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			std::cout << "migrants: " << search.sent() << " sent, " << search.received() << " received, " << search.adopted() << " adopted\n";
+		}
+		else
+		{
+			vrp::basic_multistart<Graph> search(graph, vehicles, parameters, options.threads);
+			checkpoint(search);
+			search.run();
+			finish();
+			report(search, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+	};
 
-	std::cout << std::ranges::transform_view(customers.nodes(), [](const vrp::customer &c) { return c.pos(); }) << '\n';
-}
\ No newline at end of file
+	if (options.graph_cache.empty())
+	{
+		solve(vrp::graph(customers));
+		return 0;
+	}
+
+	// a missing, unreadable or stale cache is rewritten, so it follows the instance
+	std::optional<vrp::mapped_graph> cached;
+	try
+	{
+		cached.emplace(options.graph_cache);
+		if (!same_customers(cached->customers(), customers))
+			cached.reset();
+	}
+	catch (const std::runtime_error &)
+	{
+		cached.reset();
+	}
+
+	if (!cached)
+	{
+		try
+		{
+			vrp::graph graph(customers);
+			graph.build_neighbors(parameters.local_search_k);
+			vrp::save_graph(options.graph_cache, graph);
+			cached.emplace(options.graph_cache);
+			std::cout << "graph cache written: " << options.graph_cache.c_str() << '\n';
+		}
+		catch (const std::exception &e)
+		{
+			std::cout << e.what() << '\n';
+			return 1;
+		}
+	}
+	solve(*cached);
+}
@@ -0,0 +1,53 @@
+#include "tune.h"
+#include "alns_tuning.h"
+#include "instance.h"
+
+#include <chrono>
+#include <iostream>
+
+int tune(const program_options &options, const vrp::alns_parameters &parameters)
+{
+	// every run is a single search, the race runs options.threads of them at once
+	vrp::tuning_set instances(parameters);
+	try
+	{
+		for (const std::string &path : options.tune)
+		{
+			vrp::instance instance = vrp::read_instance(path);
+			std::cout << "instance " << instance.name.c_str() << ": " << instance.customers.size() - 1 << " customers\n";
+			instances.add(std::move(instance.customers), instance.fleet, options.threads);
+		}
+	}
+	catch (const std::exception &e)
+	{
+		std::cout << e.what() << '\n';
+		return 1;
+	}
+
+	tuning::race_settings settings{
+		.budget = options.tune_budget,
+		.thread_count = options.threads,
+		.seed = parameters.seed,
+	};
+	std::vector<tuning::parameter> space = vrp::alns_space();
+
+	auto start = std::chrono::steady_clock::now();
+	tuning::race_result result = tuning::race(space, instances.size(), instances.evaluator(), settings, {vrp::alns_configuration(parameters)}, vrp::alns_allowed);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << result.evaluations << " runs of " << result.configurations << " configurations in " << result.rounds << " rounds, " << seconds << "s\n";
+	for (std::size_t i = 0; i < result.elites.size(); ++i)
+	{
+		std::cout << "mean objective " << result.mean_costs[i] << ':';
+		for (std::size_t p = 0; p < space.size(); ++p)
+		{
+			std::cout << " --" << space[p].name.c_str() << ' ';
+			if (space[p].kind == tuning::parameter_kind::boolean)
+				std::cout << (result.elites[i][p] != 0 ? "true" : "false");
+			else
+				std::cout << result.elites[i][p];
+		}
+		std::cout << '\n';
+	}
+	return 0;
+}
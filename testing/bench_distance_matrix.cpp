@@ -0,0 +1,145 @@
+#include "info.h"
+#include "kernels.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cmath>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+// the dense double matrix the graph was first built on, so the baseline and the kernels fill the same storage
+using storage = vrp::matrix;
+
+// the baseline construction: array of structures, std::hypot and every pair computed twice, each written to both
+// halves of the dense matrix
+template <vrp::distance_type type>
+storage baseline_matrix(const vrp::customer_info &customers)
+{
+	auto size = customers.size();
+	storage res(size, size);
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		for (std::size_t j = 0; j < size; ++j)
+		{
+			vrp::vec2 a = customers.node(i).pos(), b = customers.node(j).pos();
+			double d = type == vrp::distance_type::euclidean ? std::hypot(a.x - b.x, a.y - b.y) : std::abs(a.x - b.x) + std::abs(a.y - b.y);
+			res[i][j] = res[j][i] = d;
+		}
+	}
+
+	return res;
+}
+
+double max_difference(const storage &a, const storage &b)
+{
+	double res = 0;
+	for (std::size_t i = 0; i < a.rows(); ++i)
+		for (std::size_t j = 0; j < a.cols(); ++j)
+			res = std::max(res, std::abs(a(i, j) - b(i, j)));
+	return res;
+}
+
+template <typename Fn>
+double time_ms(Fn &&fn)
+{
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::size_t available_memory()
+{
+	#ifdef __unix__
+	return static_cast<std::size_t>(sysconf(_SC_AVPHYS_PAGES)) * static_cast<std::size_t>(sysconf(_SC_PAGE_SIZE));
+	#else
+	return static_cast<std::size_t>(-1);
+	#endif
+}
+
+const char *name(vrp::simd_level level)
+{
+	switch (level)
+	{
+	case vrp::simd_level::avx512: return "avx512";
+	case vrp::simd_level::avx2: return "avx2";
+	default: return "scalar";
+	}
+}
+
+// usage: distance_matrix_benchmark [n...]
+// times the construction of both distance matrices (manhattan and euclidean) as dense double storage, by the baseline
+// loop and by the kernels
+int main(int argc, char **argv)
+{
+	std::vector<std::size_t> sizes;
+	for (int i = 1; i < argc; ++i)
+		sizes.push_back(std::stoull(argv[i]));
+	if (sizes.empty())
+		sizes = {1000, 10000, 50000};
+
+	const vrp::simd_level detected = vrp::detected_simd_level();
+	const std::size_t threads = vrp::default_thread_count();
+
+	std::cout << "simd: " << name(detected) << ", threads: " << threads << "\n\n";
+	std::cout << std::left << std::setw(8) << "n" << std::setw(28) << "path" << std::setw(12) << "ms" << std::setw(10) << "speedup" << "max error\n";
+
+	for (std::size_t n : sizes)
+	{
+		vrp::customer_info customers = vrp::random_customers(n - 1, {}, 20, 1, 6, 0);
+
+		// the baseline pair is kept alive to check each new pair against it
+		std::size_t required = 4 * n * n * sizeof(storage::value_type);
+		if (required > available_memory())
+		{
+			std::cout << std::setw(8) << n << "skipped, needs " << required / (1 << 20) << " MiB\n";
+			continue;
+		}
+
+		auto build = [&]<vrp::distance_type type>(std::size_t thread_count)
+		{
+			return customers.distance_matrix<type, storage>(thread_count);
+		};
+
+		auto report = [&](const std::string &path, double ms, double baseline_ms, double error)
+		{
+			std::cout << std::setw(8) << n << std::setw(28) << path << std::setw(12) << std::fixed << std::setprecision(2) << ms
+					  << std::setw(10) << baseline_ms / ms << std::scientific << std::setprecision(2) << error << '\n' << std::defaultfloat;
+		};
+
+		storage manhattan, euclidean;
+		double baseline_ms = time_ms([&]()
+		{
+			manhattan = baseline_matrix<vrp::distance_type::manhattan>(customers);
+			euclidean = baseline_matrix<vrp::distance_type::euclidean>(customers);
+		});
+		report("baseline", baseline_ms, baseline_ms, 0);
+
+		auto run = [&](vrp::simd_level level, std::size_t thread_count)
+		{
+			vrp::set_simd_level(level);
+			storage m, e;
+			double ms = time_ms([&]()
+			{
+				m = build.template operator()<vrp::distance_type::manhattan>(thread_count);
+				e = build.template operator()<vrp::distance_type::euclidean>(thread_count);
+			});
+			report(std::string(name(vrp::active_simd_level())) + ", " + std::to_string(thread_count) + " thread(s)", ms, baseline_ms,
+				   std::max(max_difference(manhattan, m), max_difference(euclidean, e)));
+		};
+
+		run(vrp::simd_level::scalar, 1);
+		if (detected != vrp::simd_level::scalar)
+		{
+			if (detected == vrp::simd_level::avx512)
+				run(vrp::simd_level::avx2, 1);
+			run(detected, 1);
+		}
+		if (threads > 1)
+			run(detected, threads);
+	}
+}
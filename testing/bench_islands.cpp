@@ -0,0 +1,67 @@
+#include "island.h"
+#include "fleet.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+
+template <typename Fn>
+double time_s(Fn &&fn)
+{
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// usage: island_benchmark [customers] [threads] [iterations] [runs]
+// runs the same number of iterations per thread as independent searches and as islands, averaged over runs seeds
+int main(int argc, char **argv)
+{
+	std::size_t customer_count = argc > 1 ? std::stoull(argv[1]) : 200;
+	std::size_t threads = argc > 2 ? std::stoull(argv[2]) : std::max<std::size_t>(vrp::default_thread_count(), 4);
+	std::size_t iterations = argc > 3 ? std::stoull(argv[3]) : 5000;
+	std::size_t runs = argc > 4 ? std::stoull(argv[4]) : 3;
+
+	vrp::customer_info customers = vrp::random_customers(customer_count, {}, 20, 1, 6, 0);
+	vrp::graph graph(customers);
+	vrp::fleet_info fleet = test_fleet();
+
+	std::cout << "customers: " << customer_count << ", threads: " << threads << ", iterations per thread: " << iterations << ", runs: " << runs << "\n\n";
+	std::cout << std::left << std::setw(28) << "mode" << std::setw(14) << "best" << std::setw(10) << "s" << "adopted\n";
+
+	auto report = [&](const std::string &mode, double best, double seconds, double adopted)
+	{
+		std::cout << std::setw(28) << mode << std::setw(14) << std::fixed << std::setprecision(3) << best / runs
+				  << std::setw(10) << std::setprecision(2) << seconds / runs << std::setprecision(1) << adopted / runs << '\n' << std::defaultfloat;
+	};
+
+	{
+		double best = 0, seconds = 0;
+		for (std::size_t run = 0; run < runs; ++run)
+		{
+			vrp::multistart search(graph, fleet, {.iterations = iterations, .seed = run}, threads);
+			seconds += time_s([&]() { search.run(); });
+			best += search.best_objective();
+		}
+		report("independent", best, seconds, 0);
+	}
+
+	auto islands = [&](const std::string &mode, vrp::island_parameters parameters)
+	{
+		double best = 0, seconds = 0, adopted = 0;
+		for (std::size_t run = 0; run < runs; ++run)
+		{
+			vrp::islands search(graph, fleet, {.iterations = iterations, .seed = run}, parameters, threads);
+			seconds += time_s([&]() { search.run(); });
+			best += search.best_objective();
+			adopted += static_cast<double>(search.adopted());
+		}
+		report(mode, best, seconds, adopted);
+	};
+
+	islands("ring", {.topology = vrp::migration_topology::ring});
+	islands("ring, merged weights", {.topology = vrp::migration_topology::ring, .merge_weights = true});
+	islands("broadcast best", {.topology = vrp::migration_topology::broadcast_best});
+	islands("broadcast best, merged", {.topology = vrp::migration_topology::broadcast_best, .merge_weights = true});
+}
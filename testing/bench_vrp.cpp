@@ -0,0 +1,275 @@
+#include "graph.h"
+#include "multistart.h"
+#include "fleet.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <random>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+// least wall clock time a measurement repeats its body for, so short operations are not lost in the clock resolution
+constexpr double min_seconds = .25;
+
+// one measurement, printed as a JSON object on its own line so runs of two commits can be compared line by line
+struct record
+{
+	std::string_view benchmark;
+	std::string_view variant;
+	std::size_t n;
+	std::size_t threads;
+	std::size_t operations;
+	double seconds;
+	std::size_t bytes; // bytes held by the measured data structure
+};
+
+// bytes resident in memory of this process, 0 where it cannot be read
+std::size_t resident_memory()
+{
+	#ifdef __unix__
+	std::ifstream statm("/proc/self/statm");
+	std::size_t pages = 0, resident = 0;
+	if (statm >> pages >> resident)
+		return resident * static_cast<std::size_t>(sysconf(_SC_PAGE_SIZE));
+	#endif
+	return 0;
+}
+
+void print(const record &r)
+{
+	double ns = r.operations ? r.seconds * 1e9 / static_cast<double>(r.operations) : 0;
+	double per_second = r.seconds > 0 ? static_cast<double>(r.operations) / r.seconds : 0;
+	std::cout << "{\"benchmark\":\"" << r.benchmark << "\",\"variant\":\"" << r.variant << "\",\"n\":" << r.n << ",\"threads\":" << r.threads
+			  << ",\"operations\":" << r.operations << ",\"seconds\":" << r.seconds << ",\"ns_per_op\":" << ns << ",\"ops_per_second\":" << per_second
+			  << ",\"bytes\":" << r.bytes << ",\"resident_bytes\":" << resident_memory() << "}\n" << std::flush;
+}
+
+// runs body, which returns the number of operations it did, until min_seconds have passed
+// returns the operations done and the seconds they took
+template <typename Fn>
+std::pair<std::size_t, double> measure(Fn &&body)
+{
+	std::size_t operations = 0;
+	auto start = std::chrono::steady_clock::now();
+	double seconds = 0;
+	do
+	{
+		operations += body();
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (seconds < min_seconds);
+	return {operations, seconds};
+}
+
+// 1, 2, 4, ... and every core
+std::vector<std::size_t> thread_counts()
+{
+	std::vector<std::size_t> res;
+	std::size_t cores = vrp::default_thread_count();
+	for (std::size_t t = 1; t < cores; t *= 2)
+		res.push_back(t);
+	res.push_back(cores);
+	return res;
+}
+
+// both distance matrices of n nodes in each storage, on every thread count, one operation is one matrix
+void bench_distance_matrix(const std::vector<std::size_t> &sizes)
+{
+	for (std::size_t n : sizes)
+	{
+		vrp::customer_info customers = vrp::random_customers(n - 1, {}, 20, 1, 6, 0);
+
+		auto run = [&]<typename Matrix>(std::string_view variant)
+		{
+			for (std::size_t threads : thread_counts())
+			{
+				std::size_t bytes = 0;
+				auto [operations, seconds] = measure([&]()
+				{
+					Matrix manhattan = customers.distance_matrix<vrp::distance_type::manhattan, Matrix>(threads);
+					Matrix euclidean = customers.distance_matrix<vrp::distance_type::euclidean, Matrix>(threads);
+					bytes = manhattan.memory_usage() + euclidean.memory_usage();
+					return std::size_t{2};
+				});
+				print({.benchmark = "distance_matrix", .variant = variant, .n = n, .threads = threads, .operations = operations, .seconds = seconds, .bytes = bytes});
+			}
+		};
+
+		run.template operator()<vrp::matrix>("matrix");
+		run.template operator()<vrp::symmetric_matrix>("symmetric_matrix");
+		run.template operator()<vrp::compact_symmetric_matrix>("compact_symmetric_matrix");
+	}
+}
+
+// fills a route with every customer of a graph of n nodes at random positions, then empties it at random positions
+// one operation is one insert or one remove. sorties are flown one per leg of a truck route through half of the
+// customers, serving the other half
+void bench_routes(const std::vector<std::size_t> &sizes)
+{
+	for (std::size_t n : sizes)
+	{
+		vrp::customer_info customers = vrp::random_customers(n - 1, {}, 20, 1, 6, 0);
+		vrp::compact_graph graph(customers);
+
+		// the same positions every pass, drawn up front so the generator is not timed
+		std::mt19937_64 gen(0);
+		std::size_t sorties = (n - 2) / 2;
+		std::vector<std::size_t> order(n - 1), insert_at(n - 1), remove_at(n - 1), remove_sortie_at(sorties);
+		std::iota(order.begin(), order.end(), 1);
+		std::shuffle(order.begin(), order.end(), gen);
+		for (std::size_t i = 0; i < n - 1; ++i)
+		{
+			insert_at[i] = std::uniform_int_distribution<std::size_t>(0, i)(gen);
+			remove_at[i] = std::uniform_int_distribution<std::size_t>(0, n - 2 - i)(gen);
+		}
+		for (std::size_t i = 0; i < sorties; ++i)
+			remove_sortie_at[i] = std::uniform_int_distribution<std::size_t>(0, sorties - 1 - i)(gen);
+
+		// operations is the number of inserts and of removes in a pass
+		auto run = [&](std::string_view insert_variant, std::string_view remove_variant, std::size_t operations, auto &&make, auto &&insert, auto &&remove)
+		{
+			vrp::route_arenas arenas;
+			double insert_seconds = 0, remove_seconds = 0;
+			std::size_t passes = 0, bytes = 0;
+			while (insert_seconds + remove_seconds < min_seconds)
+			{
+				{
+					auto route = make(arenas);
+					auto start = std::chrono::steady_clock::now();
+					for (std::size_t i = 0; i < operations; ++i)
+						insert(route, i);
+					auto middle = std::chrono::steady_clock::now();
+					bytes = arenas.memory_usage();
+					for (std::size_t i = 0; i < operations; ++i)
+						remove(route, i);
+					auto end = std::chrono::steady_clock::now();
+
+					insert_seconds += std::chrono::duration<double>(middle - start).count();
+					remove_seconds += std::chrono::duration<double>(end - middle).count();
+				}
+				++passes;
+				arenas.clear();
+			}
+			print({.benchmark = "route", .variant = insert_variant, .n = n, .threads = 1, .operations = passes * operations, .seconds = insert_seconds, .bytes = bytes});
+			print({.benchmark = "route", .variant = remove_variant, .n = n, .threads = 1, .operations = passes * operations, .seconds = remove_seconds, .bytes = bytes});
+		};
+
+		using base_route = vrp::vehicle_route<vrp::vehicle_type::base, vrp::compact_graph>;
+		using drone_route = vrp::vehicle_route<vrp::vehicle_type::drone, vrp::compact_graph>;
+		using truck_drone_route = vrp::vehicle_route<vrp::vehicle_type::truck_drone, vrp::compact_graph>;
+
+		run("base_route.insert", "base_route.remove", n - 1, [&](vrp::route_arenas &arenas) { return base_route(graph, arenas); },
+			[&](base_route &route, std::size_t i) { route.insert(insert_at[i], order[i]); },
+			[&](base_route &route, std::size_t i) { route.remove(remove_at[i]); });
+
+		run("drone_route.insert", "drone_route.remove", n - 1, [&](vrp::route_arenas &arenas) { return drone_route(graph, arenas); },
+			[&](drone_route &route, std::size_t i) { route.insert(order[i]); },
+			[&](drone_route &route, std::size_t i) { route.remove(remove_at[i]); });
+
+		run("truck_drone_route.insert", "truck_drone_route.remove", n - 1, [&](vrp::route_arenas &arenas) { return truck_drone_route(graph, arenas); },
+			[&](truck_drone_route &route, std::size_t i) { route.insert(insert_at[i], order[i]); },
+			[&](truck_drone_route &route, std::size_t i) { route.remove(remove_at[i]); });
+
+		// the truck stops at the customers after the first sorties ones of order, sortie i serves order[i] on the leg from
+		// stop i + 1 to stop i + 2
+		auto with_stops = [&](vrp::route_arenas &arenas)
+		{
+			truck_drone_route route(graph, arenas);
+			for (std::size_t i = sorties; i < n - 1; ++i)
+				route.insert(route.size(), order[i]);
+			return route;
+		};
+		run("truck_drone_route.insert_rendevous", "truck_drone_route.remove_rendevous", sorties, with_stops,
+			[&](truck_drone_route &route, std::size_t i) { route.insert_rendevous(route.truck_stop(i + 1), order[i], route.truck_stop(i + 2)); },
+			[&](truck_drone_route &route, std::size_t i) { route.remove_rendevous(remove_sortie_at[i]); });
+	}
+}
+
+// n customers around the default center
+void bench_random_customers(const std::vector<std::size_t> &sizes)
+{
+	for (std::size_t n : sizes)
+	{
+		std::size_t bytes = 0;
+		std::uint64_t seed = 0;
+		auto [operations, seconds] = measure([&]()
+		{
+			vrp::customer_info customers = vrp::random_customers(n, {}, 20, 1, 6, seed++);
+			bytes = customers.nodes().capacity() * sizeof(vrp::customer) + 2 * customers.size() * sizeof(double);
+			return n;
+		});
+		print({.benchmark = "random_customers", .variant = "customer", .n = n, .threads = 1, .operations = operations, .seconds = seconds, .bytes = bytes});
+	}
+}
+
+// one search per thread on a graph of n nodes, one operation is one ALNS iteration of any search
+void bench_solver(const std::vector<std::size_t> &sizes, std::size_t iterations)
+{
+	vrp::fleet_info fleet = test_fleet();
+	for (std::size_t n : sizes)
+	{
+		vrp::customer_info customers = vrp::random_customers(n - 1, {}, 20, 1, 6, 0);
+		vrp::graph graph(customers);
+
+		for (std::size_t threads : thread_counts())
+		{
+			vrp::multistart search(graph, fleet, {.iterations = iterations}, threads);
+			auto start = std::chrono::steady_clock::now();
+			search.run();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::size_t operations = 0;
+			for (const vrp::search_report &report : search.reports())
+				operations += report.statistics.iterations;
+			print({.benchmark = "solver", .variant = "multistart", .n = n, .threads = threads, .operations = operations, .seconds = seconds, .bytes = graph.memory_usage()});
+		}
+	}
+}
+
+// usage: vrp_benchmark [distance_matrix|routes|random_customers|solver|all] [n...]
+// prints one JSON object per line for each measurement, nodes n include the depot, every benchmark has its own default sizes
+int main(int argc, char **argv)
+{
+	std::string which = argc > 1 ? argv[1] : "all";
+	std::vector<std::size_t> sizes;
+	for (int i = 2; i < argc; ++i)
+		sizes.push_back(std::stoull(argv[i]));
+
+	auto sizes_or = [&](std::vector<std::size_t> defaults) { return sizes.empty() ? defaults : sizes; };
+	bool all = which == "all";
+	bool known = all;
+
+	if (all || which == "distance_matrix")
+	{
+		bench_distance_matrix(sizes_or({500, 2000, 5000}));
+		known = true;
+	}
+	if (all || which == "routes")
+	{
+		bench_routes(sizes_or({100, 1000, 10000}));
+		known = true;
+	}
+	if (all || which == "random_customers")
+	{
+		bench_random_customers(sizes_or({1000, 10000, 100000}));
+		known = true;
+	}
+	if (all || which == "solver")
+	{
+		bench_solver(sizes_or({100, 400}), 1000);
+		known = true;
+	}
+
+	if (!known)
+	{
+		std::cerr << "Unknown benchmark \"" << which.c_str() << "\"\n";
+		return 1;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "info.h"
+
+// the mixed fleet every tester and benchmark solves for: autonomous vehicles, vans, standalone drones and truck-drones
+inline vrp::fleet_info test_fleet()
+{
+	vrp::cost_data cost{.cost = 10, .cost_rate = 1};
+	vrp::vehicle auto_data{.capacity = 496, .max_range = 80, .cost = 7};
+	vrp::vehicle van_data{.capacity = 2000, .max_range = 200, .cost = 20};
+	vrp::vehicle drone_data{.capacity = 5, .max_range = 24, .cost = 1};
+	vrp::vehicle truck_drone_data{.capacity = 2000, .max_range = 200, .cost = 30};
+	return vrp::fleet_info(3, 4, 2, 2, cost, cost, cost, cost, auto_data, van_data, drone_data, truck_drone_data);
+}
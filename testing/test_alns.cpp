@@ -0,0 +1,484 @@
+#include "alns.h"
+#include "multistart.h"
+#include "island.h"
+#include "batch.h"
+#include "utility.h"
+#include "fleet.h"
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+
+// every allocation of the process is counted, so the steady state of the search can be checked to not allocate
+// the whole replaceable set is overridden, so every new is paired with the delete of its own allocator. atomic, since the
+// multistart, island and checkpoint tests allocate from several threads
+static std::atomic<std::size_t> allocations = 0;
+
+static void *allocate(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *res = std::malloc(size ? size : 1))
+		return res;
+	throw std::bad_alloc();
+}
+
+static void *allocate(std::size_t size, std::align_val_t alignment)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	auto align = static_cast<std::size_t>(alignment);
+	if (void *res = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) // a multiple of the alignment
+		return res;
+	throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+// every route respects the limits of its vehicle, every sortie flies forward along its truck leg, and no customer is served twice
+bool feasible(const vrp::solution &solution)
+{
+	const vrp::graph &graph = solution.graph();
+	const vrp::vehicle &drone = solution.limits<vrp::vehicle_type::drone>();
+	std::vector<int> served(graph.size());
+	bool res = std::abs(solution.cost() - solution.manual_cost()) < .0001;
+
+	vrp::solution::for_each_type([&](auto type)
+	{
+		const vrp::vehicle &limits = solution.limits<type>();
+		for (const auto &route : solution.routes<type>())
+		{
+			if constexpr (type == vrp::vehicle_type::drone)
+			{
+				for (std::size_t i = 0; i < route.size(); ++i)
+				{
+					res &= graph.customers().node(route[i]).demand() <= limits.capacity && 2 * graph.drone_distance(0, route[i]) <= limits.max_range + 1e-9;
+					++served[route[i]];
+				}
+			}
+			else
+			{
+				res &= route.load() <= limits.capacity && route.distance_from(0) <= limits.max_range + 1e-9;
+				for (std::size_t i = 1; i < route.size(); ++i)
+				{
+					if constexpr (type == vrp::vehicle_type::truck_drone)
+						++served[route.truck_stop(i)];
+					else
+						++served[route[i]];
+				}
+
+				if constexpr (type == vrp::vehicle_type::truck_drone)
+				{
+					for (std::size_t i = 0; i < route.size_rendevous(); ++i)
+					{
+						const auto &node = route.rendevous(i);
+						double length = graph.drone_distance(node.departure, node.service) + graph.drone_distance(node.service, node.reunion);
+						res &= length <= drone.max_range + 1e-9 && graph.customers().node(node.service).demand() <= drone.capacity;
+						res &= solution.location(node.departure).index < solution.location(node.reunion).index;
+						++served[node.service];
+					}
+				}
+			}
+		}
+	});
+
+	for (std::size_t c = 1; c < graph.size(); ++c)
+		res &= served[c] == static_cast<int>(solution.routed(c));
+	return res;
+}
+
+int main()
+{
+	vrp::customer_info customers = vrp::random_customers(60, {}, 20, 1, 6, 0);
+	vrp::graph graph(customers);
+	vrp::fleet_info fleet = test_fleet();
+	vrp::alns_parameters parameters{.seed = 0};
+
+	bool success = true;
+
+	std::cout << "Testing search feasibility...\n";
+	vrp::alns search(graph, fleet, parameters);
+	double initial = search.best_objective();
+	bool res = feasible(search.best());
+	search.run(2000);
+	res &= feasible(search.best()) && feasible(search.current()) && search.best_objective() <= initial && search.current().hash() == search.current().manual_hash();
+	std::cout << (res ? "Success\n" : "Failed\n");
+	success &= res;
+
+	std::cout << "\nTesting search determinism...\n";
+	{
+		vrp::alns other(graph, fleet, parameters);
+		other.run(2000);
+		res = other.best_objective() == search.best_objective() && other.current().cost() == search.current().cost();
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting parallel repair determinism...\n";
+	{
+		// the greedy and regret repairs on three threads from the first customer on, against the same search on one
+		vrp::alns_parameters sequential{.regret_k = 3, .seed = 3};
+		vrp::alns_parameters threaded{.regret_k = 3, .repair_threads = 3, .parallel_threshold = 1, .seed = 3};
+		vrp::alns a(graph, fleet, sequential), b(graph, fleet, threaded);
+		a.run(500);
+		b.run(500);
+		res = a.best_objective() == b.best_objective() && a.current().cost() == b.current().cost() && feasible(b.best());
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting local search...\n";
+	{
+		// a search without local search leaves room for it, a local optimum is left as it is
+		vrp::alns plain(graph, fleet, {.local_search_k = 0, .seed = 5});
+		plain.run(500);
+		vrp::neighbor_lists neighbors(customers, 10);
+		vrp::local_search local(graph, fleet, neighbors);
+
+		vrp::solution improved = plain.current();
+		double saved = local.improve(improved);
+		res = saved > 0 && local.moves() > 0 && improved.cost() < plain.current().cost() && feasible(improved);
+		res &= improved.hash() == improved.manual_hash() && vrp::alns::unrouted(improved) == vrp::alns::unrouted(plain.current());
+
+		std::size_t moves = local.moves();
+		vrp::solution again = improved;
+		res &= local.improve(again) == 0 && local.moves() == moves && again.hash() == improved.hash();
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting sortie table...\n";
+	{
+		// with room for every customer, every sortie within range has both its stops listed for its service, nearest first
+		const vrp::vehicle &drone = fleet.vehicle_data(vrp::vehicle_type::drone);
+		vrp::sortie_table table(graph, drone, graph.size());
+		res = !table.empty();
+		auto listed = [&](std::size_t service, std::size_t stop)
+		{
+			return std::ranges::find(table.candidates(service), stop, &vrp::sortie_candidate::customer) != table.candidates(service).end();
+		};
+		for (std::size_t s = 1; s < graph.size(); ++s)
+		{
+			auto list = table.candidates(s);
+			res &= std::ranges::is_sorted(list, {}, &vrp::sortie_candidate::distance);
+			if (customers.node(s).demand() > drone.capacity)
+				res &= list.empty();
+			else
+				for (std::size_t i = 1; i < graph.size(); ++i)
+					for (std::size_t j = 1; j < graph.size(); ++j)
+						if (i != j && i != s && j != s && graph.drone_distance(i, s) + graph.drone_distance(s, j) <= drone.max_range)
+							res &= listed(s, i) && listed(s, j);
+		}
+
+		// capped at k, each list is the nearest k of the full one
+		vrp::sortie_table capped(graph, drone, 4);
+		for (std::size_t s = 1; s < graph.size(); ++s)
+		{
+			auto list = capped.candidates(s), full = table.candidates(s);
+			res &= list.size() == std::min<std::size_t>(4, full.size()) && capped.reach(s) == table.reach(s);
+			for (std::size_t i = 0; i < list.size(); ++i)
+				res &= list[i].customer == full[i].customer;
+		}
+		res &= capped.memory_usage() < table.memory_usage();
+
+		// the check against the order of the stops, the drone's range and the legs it already flies, on a truck leg through
+		// the two stops nearest to the customer with the longest list
+		std::size_t service = 1;
+		for (std::size_t s = 2; s < graph.size(); ++s)
+			if (table.candidates(s).size() > table.candidates(service).size())
+				service = s;
+		std::size_t a = table.candidates(service)[0].customer, b = table.candidates(service)[1].customer;
+		vrp::solution built(graph, fleet);
+		built.insert<vrp::vehicle_type::truck_drone>(0, 1, a);
+		built.insert<vrp::vehicle_type::truck_drone>(0, 2, b);
+
+		std::size_t sorties = 0;
+		for (std::size_t s = 1; s < graph.size(); ++s)
+		{
+			if (s == a || s == b)
+				continue;
+			bool fits = customers.node(s).demand() <= drone.capacity && graph.drone_distance(a, s) + graph.drone_distance(s, b) <= drone.max_range;
+			res &= built.sortie_feasible(0, a, s, b) == fits && !built.sortie_feasible(0, b, s, a) && !built.sortie_feasible(1, a, s, b);
+			sorties += fits;
+		}
+		built.insert_rendevous(0, a, service, b);
+		res &= feasible(built) && built.location(a).flying && !built.location(b).flying;
+
+		// the drone now flies over the leg, so no other sortie fits on it, and insert_rendevous refuses what does not fit
+		auto refused = [&](std::size_t departure, std::size_t s, std::size_t reunion)
+		{
+			try
+			{
+				built.insert_rendevous(0, departure, s, reunion);
+			}
+			catch (const std::invalid_argument &)
+			{
+				return true;
+			}
+			return false;
+		};
+		std::size_t spare = 1;
+		while (spare == a || spare == b || spare == service)
+			++spare;
+		res &= !built.sortie_feasible(0, a, spare, b) && refused(a, spare, b) && refused(b, spare, a) && !built.routed(spare);
+		res &= sorties > 0;
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting checkpoints...\n";
+	{
+		// a search restored from a checkpoint, through a file, continues as the search it was taken from. the visited
+		// set is not part of a checkpoint, so both run without one
+		vrp::alns_parameters forgetful{.visited_capacity = 0, .seed = 11};
+		vrp::alns a(graph, fleet, forgetful);
+		a.run(300);
+		vrp::search_checkpoint state;
+		a.save(state);
+		std::size_t before = allocations;
+		a.save(state); // into buffers that already hold a state, so nothing is allocated
+		bool in_place = allocations == before;
+		a.run(300);
+
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "psvrp_test_checkpoint.bin";
+		vrp::save_checkpoint(path, {.customers = static_cast<std::uint32_t>(graph.size()), .searches = {state}});
+		vrp::run_checkpoint loaded = vrp::load_checkpoint(path);
+		res = in_place && loaded.customers == graph.size() && loaded.searches.size() == 1 && loaded.searches[0] == state;
+
+		vrp::alns b(graph, fleet, forgetful);
+		b.restore(loaded.searches[0]);
+		res &= b.iteration() == 300 && b.current().hash() == b.current().manual_hash() && feasible(b.current());
+		b.run(300);
+		res &= std::abs(a.best_objective() - b.best_objective()) < 1e-6 && a.current().hash() == b.current().hash();
+
+		// searches hand their states to a writer thread, a run stops at its deadline
+		{
+			vrp::checkpoint_writer writer(path, graph.size(), 2);
+			vrp::multistart parallel(graph, fleet, {.iterations = 250, .checkpoint_interval = 100, .seed = 13}, 2);
+			parallel.checkpoint_to(writer);
+			parallel.run();
+			writer.flush();
+			loaded = vrp::load_checkpoint(path);
+			res &= writer.written() > 0 && loaded.searches[0].iteration == 250 && loaded.searches[1].iteration == 250;
+
+			vrp::multistart resumed(graph, fleet, {.iterations = 400, .seed = 13}, 2);
+			resumed.resume(loaded);
+			resumed.run();
+			res &= resumed.reports()[0].statistics.iterations == 150 && resumed.search(1).iteration() == 400 && feasible(resumed.best());
+		}
+		std::filesystem::remove(path);
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+		vrp::alns_statistics statistics = a.run(1000000, deadline);
+		res &= statistics.iterations < 1000000 && std::chrono::steady_clock::now() - deadline < std::chrono::seconds(1);
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting search allocations...\n";
+	{
+		std::size_t before = allocations;
+		search.run(1000);
+		res = allocations == before && feasible(search.best());
+		if (res)
+			std::cout << "Success\n";
+		else
+			std::cout << "Failed, " << allocations - before << " allocations\n";
+		success &= res;
+	}
+
+	std::cout << "\nTesting search scratch reuse...\n";
+	{
+		vrp::alns::scratch buffers;
+		{
+			vrp::alns first(graph, fleet, parameters);
+			first.run(200);
+			first.release(buffers);
+		}
+		std::size_t held = buffers.memory_usage();
+
+		// a search on the buffers of another one searches exactly like a fresh one
+		vrp::alns reused(graph, fleet, parameters, nullptr, &buffers);
+		vrp::alns fresh(graph, fleet, parameters);
+		reused.run(500);
+		fresh.run(500);
+		res = held >= parameters.visited_capacity * sizeof(std::uint64_t) && buffers.memory_usage() == 0 &&
+			reused.best_objective() == fresh.best_objective() && reused.current().hash() == fresh.current().hash();
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting batch...\n";
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "psvrp_test_batch";
+		std::filesystem::create_directories(directory);
+		for (std::size_t size : {12, 24, 18})
+		{
+			std::filesystem::path file = directory / "n";
+			file += std::to_string(size) + ".vrp";
+			std::ofstream out(file);
+			vrp::customer_info small = vrp::random_customers(size, {}, 10, 1, 6, size);
+			out << "PSVRP 1\nVEHICLE van 3 40 500 1\nNODES " << small.size() << '\n';
+			for (const vrp::customer &c : small.nodes())
+				out << c.pos().x << ' ' << c.pos().y << ' ' << c.demand() << '\n';
+		}
+
+		std::vector<vrp::batch_job> jobs = vrp::parse_manifest("# daily\nn12.vrp .5\n\nn24.vrp   # no limit\n n18.vrp 2\nmissing.vrp 1\n", directory, 0);
+		res = jobs.size() == 4 && jobs[0].instance == directory / "n12.vrp" && jobs[0].time_limit == .5 && jobs[1].time_limit == 0 && jobs[2].time_limit == 2;
+		res &= vrp::longest_first(jobs) == std::vector<std::size_t>{1, 2, 3, 0};
+		try
+		{
+			vrp::parse_manifest("a.vrp 1\nb.vrp soon\n", directory, 0, "manifest");
+			res = false;
+		}
+		catch (const std::runtime_error &e)
+		{
+			res &= std::string_view(e.what()).starts_with("manifest:2:");
+		}
+
+		// results do not depend on the threads or the order the jobs ran in
+		auto solve = [&](std::size_t threads)
+		{
+			std::vector<vrp::batch_result> results(jobs.size());
+			std::vector<std::size_t> finished;
+			vrp::solve_batch(jobs, {.iterations = 300, .seed = 4}, threads, [&](const vrp::batch_result &result)
+			{
+				results[result.job] = result;
+				finished.push_back(result.job);
+			});
+			std::sort(finished.begin(), finished.end());
+			res &= finished == std::vector<std::size_t>{0, 1, 2, 3};
+			return results;
+		};
+		std::vector<vrp::batch_result> one = solve(1), two = solve(2);
+		for (std::size_t i = 0; i < 3; ++i)
+			res &= one[i].error.empty() && one[i].statistics.iterations == 300 && one[i].unrouted == 0 && one[i].cost == two[i].cost;
+		res &= one[0].customers == 12 && one[1].customers == 24 && !one[3].error.empty() && !two[3].error.empty();
+
+		// jobs repair on their own pool thread whatever repair_threads asks for
+		std::size_t matching = 0;
+		vrp::solve_batch(jobs, {.iterations = 300, .repair_threads = 0, .seed = 4}, 2, [&](const vrp::batch_result &result)
+		{
+			matching += result.error.empty() && result.cost == one[result.job].cost;
+		});
+		res &= matching == 3;
+
+		// an exception from done stops the batch and reaches the caller instead of leaving a pool thread
+		std::size_t reported = 0;
+		try
+		{
+			vrp::solve_batch(jobs, {.iterations = 300, .seed = 4}, 2, [&](const vrp::batch_result &)
+			{
+				++reported;
+				throw std::runtime_error("done failed");
+			});
+			res = false;
+		}
+		catch (const std::runtime_error &e)
+		{
+			res &= std::string_view(e.what()) == "done failed" && reported == 1;
+		}
+		std::filesystem::remove_all(directory);
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting multistart...\n";
+	{
+		vrp::alns_parameters short_run{.iterations = 300, .seed = 7};
+		vrp::multistart parallel(graph, fleet, short_run, 3);
+		parallel.run();
+
+		// every search matches the same search run alone, and the incumbent is the best of them
+		res = feasible(parallel.best());
+		double lowest = std::numeric_limits<double>::infinity();
+		for (std::size_t i = 0; i < parallel.thread_count(); ++i)
+		{
+			const vrp::search_report &report = parallel.reports()[i];
+			vrp::alns alone(graph, fleet, {.iterations = 300, .seed = vrp::derive_seed(7, i)});
+			alone.run();
+			res &= report.seed == vrp::derive_seed(7, i) && report.statistics.iterations == 300 && report.best_objective == alone.best_objective();
+			lowest = std::min(lowest, report.best_objective);
+		}
+		res &= parallel.best_objective() == lowest && parallel.best().cost() <= lowest;
+		// the incumbent holds a copy of the best solution, not only its objective
+		vrp::solution incumbent = parallel.incumbent();
+		res &= feasible(incumbent) && std::abs(incumbent.cost() - parallel.best().cost()) < 1e-9;
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting bounded queue...\n";
+	{
+		vrp::bounded_queue<int> queue(3); // rounded up to 4
+		int pushed = 0, popped = 0;
+		while (queue.try_push([&](int &value) { value = pushed++; }));
+		res = pushed == 4 && queue.capacity() == 4;
+		for (int expected = 0; queue.try_pop([&](int &value) { res &= value == expected++; ++popped; }););
+		res &= popped == 4 && queue.try_push([](int &value) { value = 0; });
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting visited set...\n";
+	{
+		// every key is inserted by every thread, exactly one insertion of each finds it new
+		vrp::visited_set visited(1 << 12);
+		std::atomic<std::size_t> fresh{0};
+		{
+			std::vector<std::jthread> threads;
+			for (std::size_t t = 0; t < 4; ++t)
+				threads.emplace_back([&]()
+				{
+					for (std::uint64_t key = 0; key < 1000; ++key)
+						fresh.fetch_add(visited.insert(vrp::mix_bits(key)), std::memory_order_relaxed);
+				});
+		}
+		res = fresh == 1000 && visited.capacity() == 1 << 12;
+		for (std::uint64_t key = 0; key < 1000; ++key)
+			res &= visited.contains(vrp::mix_bits(key)) && !visited.contains(vrp::mix_bits(key + 1000));
+
+		// a full set keeps its size and still holds the key inserted last
+		vrp::visited_set small(16);
+		for (std::uint64_t key = 0; key < 1000; ++key)
+			small.insert(vrp::mix_bits(key));
+		res &= small.capacity() == 16 && small.contains(vrp::mix_bits(999));
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting islands...\n";
+	for (auto topology : {vrp::migration_topology::ring, vrp::migration_topology::broadcast_best})
+	{
+		vrp::islands islands(graph, fleet, {.iterations = 300, .seed = 7}, {.migration_interval = 50, .topology = topology, .merge_weights = true}, 3);
+		islands.run();
+
+		res = feasible(islands.best()) && islands.adopted() <= islands.received() && islands.received() <= islands.sent() && islands.sent() > 0;
+		double lowest = std::numeric_limits<double>::infinity();
+		for (const vrp::search_report &report : islands.reports())
+		{
+			res &= report.statistics.iterations == 300;
+			lowest = std::min(lowest, report.best_objective);
+		}
+		res &= islands.best_objective() == lowest && std::abs(islands.incumbent().cost() - islands.best().cost()) < 1e-9;
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,417 @@
+#include "graph.h"
+#include "relatedness.h"
+#include "clustering.h"
+#include "instance.h"
+#include "graph_cache.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+
+// checks that every lookup of graph_t matches the dense graph within tolerance
+template <typename graph_t>
+bool matches(const vrp::graph &reference, const graph_t &graph, double tolerance)
+{
+	for (std::size_t a = 0; a < reference.size(); ++a)
+	{
+		for (std::size_t b = 0; b < reference.size(); ++b)
+		{
+			if (std::abs(reference.van_distance(a, b) - graph.van_distance(a, b)) > tolerance ||
+				std::abs(reference.drone_distance(a, b) - graph.drone_distance(a, b)) > tolerance)
+			{
+				std::cout << "Failed on pair (" << a << ", " << b << ")\n";
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	vrp::customer_info customers = vrp::random_customers(200, {}, 20, 1, 6, 0);
+	vrp::graph graph(customers);
+
+	bool success = true;
+
+	std::cout << "Testing dense graph symmetry...\n";
+	{
+		std::size_t a = 0;
+		for (; a < graph.size(); ++a)
+		{
+			std::size_t b = 0;
+			for (; b < graph.size(); ++b)
+				if (graph.van_distance(a, b) != graph.van_distance(b, a) || graph.drone_distance(a, b) != graph.drone_distance(b, a))
+					break;
+			if (b != graph.size() || graph.van_distance(a, a) != 0 || graph.drone_distance(a, a) != 0)
+				break;
+		}
+
+		if (a == graph.size())
+			std::cout << "Success\n";
+		else
+		{
+			std::cout << "Failed on customer " << a << '\n';
+			success = false;
+		}
+	}
+
+	std::cout << "\nTesting packed graph...\n";
+	{
+		vrp::packed_graph packed(customers);
+		bool res = matches(graph, packed, 0) && packed.memory_usage() * 2 <= graph.memory_usage();
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting compact graph...\n";
+	{
+		vrp::compact_graph compact(customers);
+		bool res = matches(graph, compact, .0001) && compact.memory_usage() * 4 <= graph.memory_usage();
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting lazy graph...\n";
+	{
+		vrp::lazy_graph lazy(customers);
+		bool res = matches(graph, lazy, 1e-9);
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting lazy graph with tile cache...\n";
+	{
+		// fewer tiles than the graph has, so tiles get evicted and refilled
+		vrp::lazy_graph lazy(customers, 5);
+		bool res = matches(graph, lazy, 1e-9);
+
+		std::mt19937_64 gen(0);
+		std::uniform_int_distribution<std::size_t> node(0, customers.size() - 1);
+		for (std::size_t i = 0; i < 10000 && res; ++i)
+		{
+			std::size_t a = node(gen), b = node(gen);
+			res = std::abs(graph.van_distance(a, b) - lazy.van_distance(a, b)) < 1e-9 && std::abs(graph.drone_distance(a, b) - lazy.drone_distance(a, b)) < 1e-9;
+		}
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting route on lazy graph...\n";
+	{
+		vrp::lazy_graph lazy(customers, 16);
+		vrp::route_arenas arenas;
+		vrp::truck_drone_route graph_route(graph, arenas);
+		vrp::vehicle_route<vrp::vehicle_type::truck_drone, vrp::lazy_graph> lazy_route(lazy, arenas);
+		// the truck stops at every customer but the last, which the drone serves between the first two stops
+		std::size_t service = customers.size() - 1;
+		for (std::size_t i = 1; i < service; ++i)
+		{
+			graph_route.insert(graph_route.size(), i);
+			lazy_route.insert(lazy_route.size(), i);
+		}
+		graph_route.insert_rendevous(1, service, 2);
+		lazy_route.insert_rendevous(1, service, 2);
+
+		bool res = std::abs(graph_route.cost() - lazy_route.cost()) < .0001 && std::abs(lazy_route.cost() - lazy_route.manual_cost()) < .0001;
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting neighbor lists...\n";
+	{
+		constexpr std::size_t k = 12;
+		graph.build_neighbors(k);
+
+		// brute force reference, ties broken by index like the grid search
+		auto check = [&](std::size_t a, std::span<const std::uint32_t> list, auto distance)
+		{
+			std::vector<std::pair<double, std::uint32_t>> all;
+			for (std::size_t b = 0; b < graph.size(); ++b)
+				if (b != a)
+					all.emplace_back(distance(a, b), static_cast<std::uint32_t>(b));
+			std::sort(all.begin(), all.end());
+
+			if (list.size() != k)
+				return false;
+			for (std::size_t n = 0; n < k; ++n)
+				if (list[n] != all[n].second)
+					return false;
+			return true;
+		};
+
+		std::size_t a = 0;
+		for (; a < graph.size(); ++a)
+		{
+			if (!check(a, graph.van_neighbors(a), [&](std::size_t x, std::size_t y) { return graph.van_distance(x, y); }) ||
+				!check(a, graph.drone_neighbors(a), [&](std::size_t x, std::size_t y) { return graph.drone_distance(x, y); }))
+				break;
+		}
+
+		bool res = a == graph.size();
+		if (res)
+			std::cout << "Success\n";
+		else
+			std::cout << "Failed on customer " << a << '\n';
+		success &= res;
+	}
+
+	std::cout << "\nTesting relatedness index...\n";
+	{
+		constexpr std::size_t k = 12;
+		// with every customer a candidate the lists are exact, by default they are the best of the 4 k nearest
+		vrp::relatedness_index related(graph, k, 0, graph.size());
+		vrp::relatedness_index sequential(graph, k, 1, graph.size());
+		vrp::relatedness_index nearest(graph, k);
+
+		double max_distance = 0, min_demand = customers.node(1).demand(), max_demand = min_demand;
+		for (std::size_t a = 1; a < graph.size(); ++a)
+		{
+			min_demand = std::min(min_demand, customers.node(a).demand());
+			max_demand = std::max(max_demand, customers.node(a).demand());
+			for (std::size_t b = 1; b < graph.size(); ++b)
+				max_distance = std::max(max_distance, graph.van_distance(a, b));
+		}
+
+		bool res = related.k() == k && related.related(0).empty();
+		std::size_t a = 1;
+		for (; res && a < graph.size(); ++a)
+		{
+			auto score = [&](std::size_t b) { return 9 / max_distance * graph.van_distance(a, b) + 2 / (max_demand - min_demand) * std::abs(customers.node(a).demand() - customers.node(b).demand()); };
+			std::vector<std::pair<double, std::uint32_t>> all, closest;
+			for (std::size_t b = 1; b < graph.size(); ++b)
+			{
+				if (b != a)
+				{
+					all.emplace_back(score(b), static_cast<std::uint32_t>(b));
+					closest.emplace_back(graph.van_distance(a, b), static_cast<std::uint32_t>(b));
+				}
+			}
+			std::sort(all.begin(), all.end());
+			std::sort(closest.begin(), closest.end());
+			closest.resize(4 * k);
+			for (auto &[value, b] : closest)
+				value = score(b);
+			std::sort(closest.begin(), closest.end());
+
+			for (std::size_t n = 0; n < k; ++n)
+				res &= related.related(a)[n] == all[n].second && sequential.related(a)[n] == all[n].second && nearest.related(a)[n] == closest[n].second;
+		}
+
+		if (res)
+			std::cout << "Success\n";
+		else
+			std::cout << "Failed on customer " << a - 1 << '\n';
+		success &= res;
+	}
+
+	std::cout << "\nTesting customer clusters...\n";
+	{
+		// converged k-means, every customer is in exactly one cluster and that cluster's center is its nearest
+		vrp::customer_clusters clusters(customers, 8, 0, 1000);
+		std::vector<int> seen(customers.size());
+		bool res = clusters.count() == (customers.size() - 1 + 7) / 8;
+		for (std::size_t c = 0; c < clusters.count(); ++c)
+		{
+			for (std::uint32_t member : clusters.members(c))
+			{
+				++seen[member];
+				res &= clusters.cluster_of(member) == c;
+			}
+		}
+
+		auto squared = [&](std::size_t i, vrp::vec2 center)
+		{
+			double dx = customers.node(i).pos().x - center.x, dy = customers.node(i).pos().y - center.y;
+			return dx * dx + dy * dy;
+		};
+		for (std::size_t i = 1; i < customers.size(); ++i)
+		{
+			res &= seen[i] == 1;
+			for (std::size_t c = 0; c < clusters.count(); ++c)
+				res &= squared(i, clusters.center(clusters.cluster_of(i))) <= squared(i, clusters.center(c));
+		}
+
+		// the seed's side of a split is moved to the front
+		std::vector<std::uint32_t> points(customers.size() - 1);
+		std::iota(points.begin(), points.end(), 1);
+		std::uint32_t seed = points[5];
+		auto distance = [&](std::size_t a, std::size_t b) { return graph.van_distance(a, b); };
+		std::size_t side = vrp::split_in_two(std::span(points), 5, distance);
+		res &= side > 0 && side <= points.size() && std::find(points.begin(), points.begin() + side, seed) != points.begin() + side;
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting route on compact graph...\n";
+	{
+		vrp::compact_graph compact(customers);
+		vrp::route_arenas arenas;
+		vrp::vehicle_route<vrp::vehicle_type::van, vrp::compact_graph> route(compact, arenas);
+		for (std::size_t i = 1; i < customers.size(); ++i)
+			route.insert(route.size(), i);
+
+		bool res = std::abs(route.cost() - route.manual_cost()) < .0001;
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting instance reader...\n";
+	{
+		constexpr std::string_view cvrplib =
+			"NAME : P-n5-k2\n"
+			"COMMENT : (hand made)\n"
+			"TYPE : CVRP\n"
+			"DIMENSION : 5\n"
+			"EDGE_WEIGHT_TYPE : MAN_2D\n"
+			"CAPACITY : 10\n"
+			"NODE_COORD_SECTION\n"
+			" 1 1 1\n 2 0 0\n 3 4 0\n 4 0 3\n 5 -2.5 1e1\n"
+			"DEMAND_SECTION\n"
+			"1 4\n2 0\n3 6\n4 3\n5 2\n"
+			"DEPOT_SECTION\n 2\n -1\n"
+			"EOF\n";
+		vrp::instance cvrp = vrp::parse_instance(cvrplib);
+		bool res = cvrp.name == "P-n5-k2" && cvrp.customers.size() == 5 && cvrp.fleet.base_count() == 2 &&
+			cvrp.fleet.vehicle_data(vrp::vehicle_type::base).capacity == 10 && std::isinf(cvrp.fleet.vehicle_data(vrp::vehicle_type::base).max_range);
+		// the depot comes first, the other nodes keep their order
+		res &= cvrp.customers.depot().pos().x == 0 && cvrp.customers.depot().pos().y == 0 && cvrp.customers.depot().demand() == 0;
+		res &= cvrp.customers.node(1).pos().x == 1 && cvrp.customers.node(1).demand() == 4;
+		res &= cvrp.customers.node(4).pos().x == -2.5 && cvrp.customers.node(4).pos().y == 10 && cvrp.customers.node(4).demand() == 2;
+
+		// a route through every customer in file order costs its manhattan length, 2 + 4 + 7 + 9.5 + 12.5
+		vrp::graph cvrp_graph(cvrp.customers);
+		vrp::route_arenas cvrp_arenas;
+		vrp::vehicle_route<vrp::vehicle_type::base, vrp::graph> tour(cvrp_graph, cvrp_arenas);
+		for (std::size_t i = 1; i < cvrp.customers.size(); ++i)
+			tour.insert(tour.size(), i);
+		res &= std::abs(tour.cost() - 35) < 1e-9;
+
+		constexpr std::string_view native =
+			"# truck and drone fleet\n"
+			"PSVRP 1\n"
+			"NAME depot run\n"
+			"COST fuel 3 0.5\n"
+			"VEHICLE van 2 100 50 20\n"
+			"VEHICLE drone 1 5 10 1   # light parcels only\n"
+			"VEHICLE truck_drone 1 80 60 30\n"
+			"NODES 3\n"
+			"0 0 0\n"
+			"3 4 2\n"
+			"-1 2 7\n";
+		vrp::instance mixed = vrp::parse_instance(native);
+		res &= mixed.name == "depot run" && mixed.customers.size() == 3 && mixed.customers.node(2).demand() == 7;
+		res &= mixed.fleet.van_count() == 2 && mixed.fleet.drone_count() == 1 && mixed.fleet.truck_drone_count() == 1 && mixed.fleet.base_count() == 0;
+		res &= mixed.fleet.vehicle_data(vrp::vehicle_type::drone).max_range == 10 && mixed.fleet.cost(vrp::cost_type::fuel) == 3 && mixed.fleet.cost_rate(vrp::cost_type::fuel) == .5;
+
+		// errors name the line they are on
+		auto fails_on = [](std::string_view text, std::string_view line)
+		{
+			try
+			{
+				vrp::parse_instance(text, "bad");
+			}
+			catch (const std::runtime_error &e)
+			{
+				return std::string_view(e.what()).starts_with(line);
+			}
+			return false;
+		};
+		res &= fails_on("PSVRP 1\nVEHICLE van 1 10 10 1\nNODES 2\n0 0 0\n1 x 1\n", "bad:5:");
+		res &= fails_on("NAME : t\nTYPE : CVRP\nDIMENSION : 2\nEDGE_WEIGHT_TYPE : EXPLICIT\n", "bad:4:");
+		res &= fails_on("NAME : t\nTYPE : CVRP\nDIMENSION : 2\nEDGE_WEIGHT_TYPE : EUC_2D\n", "bad:4:");
+		res &= fails_on("NAME : t\nTYPE : CVRP\nDIMENSION : 2\nNODE_COORD_SECTION\n1 0 0\n3 1 1\n", "bad:6:");
+		res &= fails_on("PSVRP 1\nVEHICLE base 1 10 10 1\nVEHICLE van 1 10 10 1\nNODES 1\n0 0 0\n", "bad:");
+
+		// through a mapped file
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "psvrp_test_instance.vrp";
+		std::ofstream(path) << cvrplib;
+		vrp::instance mapped = vrp::read_instance(path);
+		std::filesystem::remove(path);
+		res &= mapped.name == cvrp.name && mapped.customers.nodes().size() == cvrp.customers.size();
+		for (std::size_t i = 0; res && i < cvrp.customers.size(); ++i)
+			res &= mapped.customers.node(i).pos().x == cvrp.customers.node(i).pos().x && mapped.customers.node(i).demand() == cvrp.customers.node(i).demand();
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting graph cache...\n";
+	{
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "psvrp_test_graph.bin";
+		vrp::graph with_neighbors(customers);
+		with_neighbors.build_neighbors(8);
+		vrp::save_graph(path, with_neighbors);
+
+		bool res;
+		{
+			vrp::mapped_graph mapped(path);
+			res = matches(graph, mapped, 0) && mapped.neighbors().k() == 8;
+			for (std::size_t i = 0; res && i < customers.size(); ++i)
+			{
+				res &= mapped.customers().node(i).pos().x == customers.node(i).pos().x && mapped.customers().node(i).demand() == customers.node(i).demand();
+				res &= std::ranges::equal(mapped.van_neighbors(i), with_neighbors.van_neighbors(i)) && std::ranges::equal(mapped.drone_neighbors(i), with_neighbors.drone_neighbors(i));
+			}
+		}
+
+		// a file is only opened as the matrix type it was written from
+		auto rejects = [&]<typename graph_t>(std::type_identity<graph_t>)
+		{
+			try
+			{
+				graph_t opened(path);
+			}
+			catch (const std::runtime_error &)
+			{
+				return true;
+			}
+			return false;
+		};
+		res &= rejects(std::type_identity<vrp::mapped_compact_graph>{});
+
+		vrp::compact_graph compact(customers);
+		vrp::save_graph(path, compact);
+		{
+			vrp::mapped_compact_graph mapped(path);
+			res &= matches(graph, mapped, .01) && mapped.neighbors().empty();
+		}
+		res &= rejects(std::type_identity<vrp::mapped_graph>{});
+
+		// writers racing on the same file each publish a whole copy, while readers only ever see a whole one
+		{
+			std::vector<std::jthread> writers;
+			for (std::size_t i = 0; i < 4; ++i)
+				writers.emplace_back([&]()
+				{
+					for (std::size_t round = 0; round < 8; ++round)
+						vrp::save_graph(path, compact);
+				});
+			for (std::size_t round = 0; round < 32; ++round)
+			{
+				vrp::mapped_compact_graph mapped(path);
+				res &= mapped.size() == customers.size();
+			}
+		}
+		{
+			vrp::mapped_compact_graph mapped(path);
+			res &= matches(graph, mapped, .01);
+		}
+		for (const auto &entry : std::filesystem::directory_iterator(path.parent_path()))
+			res &= !entry.path().filename().string().starts_with(path.filename().string() + '.');
+
+		std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+		res &= rejects(std::type_identity<vrp::mapped_compact_graph>{});
+		std::filesystem::remove(path);
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	return success ? 0 : 1;
+}
@@ -1,16 +1,21 @@
 #include "graph.h"
+#include "two_level_list.h"
 #include "utility.h"
 
 #include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <limits>
 
 int main()
 {
 	vrp::customer_info customers = vrp::random_customers(10, {}, 20, 1, 6, 0);
 	vrp::graph graph(customers);
+	vrp::route_arenas arenas;
 
 	// base_route test
 	{
-		vrp::base_route base_route(graph);
+		vrp::base_route base_route(graph, arenas);
 
 		std::mt19937_64 gen(0);
 		std::vector<std::size_t> route(customers.size() - 1);
@@ -54,7 +59,7 @@ int main()
 
 	// drone_route test
 	{
-		vrp::drone_route drone_route(graph);
+		vrp::drone_route drone_route(graph, arenas);
 
 		std::mt19937_64 gen(0);
 
@@ -98,68 +103,220 @@ int main()
 
 	// truck_drone_route test
 	{
-		vrp::truck_drone_route truck_drone_route(graph);
+		vrp::truck_drone_route truck_drone_route(graph, arenas);
 
 		std::mt19937_64 gen(0);
 		std::vector<std::size_t> route(customers.size() - 1);
 		std::iota(std::begin(route), std::end(route), 1);
 		std::shuffle(std::begin(route), std::end(route), gen);
 
+		// the truck stops at the first two thirds of the customers, the drone serves the others on disjoint legs
+		std::size_t stops = route.size() * 2 / 3;
+
 		std::cout << "\nTesting truck_drone route class insert...\n";
-		std::size_t rendevous_i = 1;
 		std::size_t i = 0;
-		for (; i < customers.size() - 1; ++i)
+		for (; i < route.size(); ++i)
 		{
-			std::uniform_int_distribution<std::size_t> route_insert_loc(1, truck_drone_route.size());
-			truck_drone_route.insert(route_insert_loc(gen), route[i]);
+			if (i < stops)
+			{
+				std::uniform_int_distribution<std::size_t> route_insert_loc(1, truck_drone_route.size());
+				truck_drone_route.insert(route_insert_loc(gen), route[i]);
+			}
+			else if (std::size_t leg = 2 * (i - stops) + 1; leg + 1 < truck_drone_route.size())
+				truck_drone_route.insert_rendevous(truck_drone_route.truck_stop(leg), route[i], truck_drone_route.truck_stop(leg + 1));
 
 			if (std::abs(truck_drone_route.cost() - truck_drone_route.manual_cost()) > .0001)
 			{
 				std::cout << "Failed on iteration " << i << '\n';
 				break;
 			}
-			
-			if (truck_drone_route.size_rendevous() < customers.size() / 4)
+		}
+
+		if (i == route.size())
+		{
+			std::cout << "\nTesting truck_drone route class remove...\n";
+
+			// the sorties go before the stops they depart from and return to
+			for (i = 0; truck_drone_route.size() > 1; ++i)
 			{
-				truck_drone_route.insert_rendevous(rendevous_i, rendevous_i + 1, rendevous_i + 2);
-				
+				if (truck_drone_route.size_rendevous() > 0)
+				{
+					std::uniform_int_distribution<std::size_t> rendevous_remove_loc(0, truck_drone_route.size_rendevous() - 1);
+					truck_drone_route.remove_rendevous(rendevous_remove_loc(gen));
+				}
+				else
+				{
+					std::uniform_int_distribution<std::size_t> route_remove_loc(1, truck_drone_route.size() - 1);
+					truck_drone_route.remove(route_remove_loc(gen));
+				}
+
 				if (std::abs(truck_drone_route.cost() - truck_drone_route.manual_cost()) > .0001)
 				{
 					std::cout << "Failed on iteration " << i << '\n';
 					break;
 				}
 			}
+
+			if (truck_drone_route.size() == 1)
+				std::cout << "Success\n";
 		}
+	}
 
-		if (i == customers.size() - 1)
+	// delta evaluation test
+	{
+		vrp::base_route base_route(graph, arenas);
+		vrp::drone_route drone_route(graph, arenas);
+
+		std::mt19937_64 gen(1);
+		std::vector<std::size_t> route(customers.size() - 1);
+		std::iota(std::begin(route), std::end(route), 1);
+		std::shuffle(std::begin(route), std::end(route), gen);
+
+		std::cout << "\nTesting route class deltas...\n";
+		std::size_t i = 0;
+		for (; i < route.size(); ++i)
 		{
-			std::cout << "\nTesting base route class remove...\n";
+			std::size_t customer = route[i];
 
-			for (std::size_t i = 0; i < customers.size() - 1; ++i)
+			// every position priced without mutating must match the change of actually inserting there
+			double best = std::numeric_limits<double>::infinity();
+			bool matches = true;
+			for (std::size_t index = 1; index <= base_route.size(); ++index)
 			{
-				std::uniform_int_distribution<std::size_t> route_remove_loc(0, truck_drone_route.size() - 1);
-				truck_drone_route.remove(route_remove_loc(gen));
+				vrp::base_route copy = base_route;
+				copy.insert(index, customer);
+				double delta = copy.cost() - base_route.cost();
+				matches &= std::abs(base_route.insertion_delta(index, customer) - delta) < .0001;
+				matches &= std::abs(copy.removal_delta(index) + delta) < .0001;
+				best = std::min(best, delta);
+			}
 
-				if (std::abs(truck_drone_route.cost() - truck_drone_route.manual_cost()) > .0001)
-				{
-					std::cout << "Failed on iteration " << i << '\n';
-					break;
-				}
-				
-				if (truck_drone_route.size_rendevous() > 0)
-				{
-					std::uniform_int_distribution<std::size_t> rendevous_remove_loc(0, truck_drone_route.size_rendevous() - 1);
-					truck_drone_route.remove_rendevous(rendevous_remove_loc(gen));
-					if (std::abs(truck_drone_route.cost() - truck_drone_route.manual_cost()) > .0001)
-					{
-						std::cout << "Failed on iteration " << i << '\n';
-						break;
-					}
-				}
+			vrp::route_insertion insertion = base_route.best_insertion(customer);
+			matches &= std::abs(insertion.delta - best) < .0001 && std::abs(base_route.insertion_delta(insertion.index, customer) - best) < .0001;
+
+			double drone_delta = drone_route.insertion_delta(customer);
+			double before = drone_route.cost();
+			drone_route.insert(customer);
+			matches &= std::abs(drone_route.cost() - before - drone_delta) < .0001;
+			matches &= std::abs(drone_route.removal_delta(drone_route.size() - 1) + drone_delta) < .0001;
+
+			if (!matches)
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
 			}
 
-			if (i == customers.size() - 1)
-				std::cout << "Success\n";
+			std::uniform_int_distribution<std::size_t> route_insert_loc(1, base_route.size());
+			base_route.insert(route_insert_loc(gen), customer);
+		}
+
+		if (i == route.size())
+			std::cout << "Success\n";
+	}
+
+	// feasibility test
+	{
+		vrp::truck_drone_route truck_drone_route(graph, arenas);
+		const vrp::vehicle limits{.capacity = 25, .max_range = 40, .cost = 1};
+
+		std::mt19937_64 gen(2);
+		std::vector<std::size_t> route(customers.size() - 1);
+		std::iota(std::begin(route), std::end(route), 1);
+		std::shuffle(std::begin(route), std::end(route), gen);
+
+		std::cout << "\nTesting route class feasibility...\n";
+		std::size_t i = 0;
+		for (; i < route.size(); ++i)
+		{
+			std::size_t customer = route[i];
+			bool matches = true;
+
+			// a feasible delta must exist exactly when actually inserting stays within the limits
+			for (std::size_t index = 1; index <= truck_drone_route.size(); ++index)
+			{
+				vrp::truck_drone_route copy = truck_drone_route;
+				copy.insert(index, customer);
+				bool feasible = copy.load() <= limits.capacity && copy.cost() <= limits.max_range;
+				matches &= truck_drone_route.feasible_insertion_delta(index, customer, limits).has_value() == feasible;
+			}
+
+			// prefix distances must agree with walking the truck leg
+			double walked = 0;
+			for (std::size_t k = 0; k < truck_drone_route.size(); ++k)
+			{
+				matches &= std::abs(truck_drone_route.distance_to(k) - walked) < .0001;
+				matches &= std::abs(truck_drone_route.distance_from(k) - (truck_drone_route.cost() - walked)) < .0001;
+				walked += graph.van_distance(truck_drone_route.truck_stop(k), truck_drone_route.truck_stop((k + 1) % truck_drone_route.size()));
+			}
+
+			if (!matches)
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
+			}
+
+			if (auto insertion = truck_drone_route.best_feasible_insertion(customer, limits))
+				truck_drone_route.insert(insertion->index, customer);
 		}
+
+		if (i == route.size())
+			std::cout << "Success\n";
+	}
+	// two_level_list test, against reversing a plain array
+	{
+		std::cout << "\nTesting two level list...\n";
+		std::mt19937_64 gen(4);
+		std::vector<std::uint32_t> order(500);
+		std::iota(order.begin(), order.end(), 0);
+		std::shuffle(order.begin(), order.end(), gen);
+		vrp::two_level_list list(order.size() + 10);
+		list.assign(order);
+
+		std::vector<std::size_t> where(order.size());
+		auto reindex = [&]()
+		{
+			for (std::size_t p = 0; p < order.size(); ++p)
+				where[order[p]] = p;
+		};
+		reindex();
+
+		std::size_t i = 0;
+		for (; i < 2000; ++i)
+		{
+			std::uint32_t a = order[gen() % order.size()], b = order[gen() % order.size()];
+			if (i % 5 == 0)
+			{
+				list.swap(a, b);
+				std::swap(order[where[a]], order[where[b]]);
+			}
+			else
+			{
+				// the path from a forward to b, wrapping around the end of the array
+				list.reverse(a, b);
+				std::size_t first = where[a], length = (where[b] + order.size() - first) % order.size() + 1;
+				for (std::size_t k = 0; k < length / 2; ++k)
+					std::swap(order[(first + k) % order.size()], order[(first + length - 1 - k) % order.size()]);
+			}
+			reindex();
+
+			bool matches = list.size() == order.size() && !list.contains(order.size());
+			for (std::size_t p = 0; p < order.size(); ++p)
+			{
+				matches &= list.next(order[p]) == order[(p + 1) % order.size()];
+				matches &= list.prev(order[p]) == order[(p + order.size() - 1) % order.size()];
+			}
+			std::uint32_t x = order[gen() % order.size()], y = order[gen() % order.size()], z = order[gen() % order.size()];
+			std::size_t to_y = (where[y] + order.size() - where[x]) % order.size(), to_z = (where[z] + order.size() - where[x]) % order.size();
+			matches &= list.between(x, y, z) == (to_y <= to_z);
+
+			if (!matches)
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
+			}
+		}
+
+		if (i == 2000)
+			std::cout << "Success\n";
 	}
 }
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "solution.h"
+#include "utility.h"
+#include "fleet.h"
+
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+
+// every route holds the same stops in the same order and every cached cost and hash is bitwise equal
+bool same(const vrp::solution &a, const vrp::solution &b)
+{
+	bool res = a.cost() == b.cost() && a.hash() == b.hash();
+	vrp::solution::for_each_type([&](auto type)
+	{
+		res &= a.cost<type>() == b.cost<type>();
+		for (std::size_t r = 0; r < a.route_count<type>(); ++r)
+		{
+			const auto &x = a.route<type>(r);
+			const auto &y = b.route<type>(r);
+			res &= x.cost() == y.cost() && x.size() == y.size();
+			for (std::size_t i = 0; res && i < x.size(); ++i)
+			{
+				if constexpr (type == vrp::vehicle_type::truck_drone)
+					res &= x.truck_stop(i) == y.truck_stop(i);
+				else
+					res &= x[i] == y[i];
+			}
+
+			if constexpr (type == vrp::vehicle_type::truck_drone)
+			{
+				res &= x.size_rendevous() == y.size_rendevous();
+				for (std::size_t i = 0; res && i < x.size_rendevous(); ++i)
+					res &= x.rendevous(i).departure == y.rendevous(i).departure && x.rendevous(i).service == y.rendevous(i).service && x.rendevous(i).reunion == y.rendevous(i).reunion;
+			}
+		}
+	});
+	return res;
+}
+
+// the location of every served customer points back at where it is served, nothing else is routed, and exactly the
+// truck stops whose leg a sortie flies over are marked flying
+bool consistent(const vrp::solution &solution, std::size_t routed)
+{
+	bool res = true;
+	std::size_t count = 0;
+	vrp::solution::for_each_type([&](auto type)
+	{
+		for (std::size_t r = 0; r < solution.route_count<type>(); ++r)
+		{
+			const auto &route = solution.route<type>(r);
+			for (std::size_t i = 0; i < route.size(); ++i)
+			{
+				std::size_t customer;
+				if constexpr (type == vrp::vehicle_type::truck_drone)
+					customer = route.truck_stop(i);
+				else
+					customer = route[i];
+				if (customer == 0)
+					continue;
+
+				const vrp::customer_location &loc = solution.location(customer);
+				res &= loc.type == type && !loc.sortie && loc.route == r && loc.index == i;
+				if constexpr (type != vrp::vehicle_type::truck_drone)
+					res &= !loc.flying;
+				++count;
+			}
+
+			if constexpr (type == vrp::vehicle_type::truck_drone)
+			{
+				std::vector<bool> flown(route.size());
+				for (std::size_t i = 0; i < route.size_rendevous(); ++i)
+				{
+					const vrp::drone_node &node = route.rendevous(i);
+					const vrp::customer_location &loc = solution.location(node.service);
+					res &= loc.type == type && loc.sortie && !loc.flying && loc.route == r && loc.index == i;
+					for (std::size_t k = solution.location(node.departure).index; k < solution.location(node.reunion).index; ++k)
+						flown[k] = true;
+					++count;
+				}
+				for (std::size_t i = 1; i < route.size(); ++i)
+					res &= solution.location(route.truck_stop(i)).flying == flown[i];
+			}
+		}
+	});
+
+	std::size_t indexed = 0;
+	for (std::size_t customer = 1; customer < solution.graph().size(); ++customer)
+		indexed += solution.routed(customer);
+
+	return res && count == routed && indexed == routed;
+}
+
+int main()
+{
+	vrp::customer_info customers = vrp::random_customers(60, {}, 20, 1, 6, 0);
+	vrp::graph graph(customers);
+	vrp::fleet_info fleet = test_fleet();
+
+	bool success = true;
+
+	// route storage test
+	{
+		vrp::solution solution(graph, fleet);
+
+		std::cout << "Testing solution routes...\n";
+		bool res = solution.route_count<vrp::vehicle_type::autonomous>() == fleet.auto_count() &&
+				   solution.route_count<vrp::vehicle_type::van>() == fleet.van_count() &&
+				   solution.route_count<vrp::vehicle_type::drone>() == fleet.drone_count() &&
+				   solution.route_count<vrp::vehicle_type::truck_drone>() == fleet.truck_drone_count() &&
+				   solution.cost() == 0;
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	// cached cost test
+	{
+		vrp::solution solution(graph, fleet);
+
+		std::mt19937_64 gen(0);
+		std::vector<std::size_t> order(customers.size() - 1);
+		std::iota(std::begin(order), std::end(order), 1);
+		std::shuffle(std::begin(order), std::end(order), gen);
+
+		std::cout << "\nTesting solution cost...\n";
+		std::size_t i = 0;
+		for (; i < order.size(); ++i)
+		{
+			std::size_t customer = order[i];
+			switch (i % 4)
+			{
+			case 0:
+			{
+				std::size_t route = i / 4 % fleet.auto_count();
+				solution.insert<vrp::vehicle_type::autonomous>(route, solution.route<vrp::vehicle_type::autonomous>(route).best_insertion(customer).index, customer);
+				break;
+			}
+			case 1:
+			{
+				std::size_t route = i / 4 % fleet.van_count();
+				solution.insert<vrp::vehicle_type::van>(route, solution.route<vrp::vehicle_type::van>(route).size(), customer);
+				break;
+			}
+			case 2:
+				solution.insert<vrp::vehicle_type::drone>(i / 4 % fleet.drone_count(), customer);
+				break;
+			case 3:
+			{
+				std::size_t route = i / 4 % fleet.truck_drone_count();
+				const auto &truck_drone = solution.route<vrp::vehicle_type::truck_drone>(route);
+				if (i % 8 == 3 && truck_drone.size() > 2 && solution.sortie_feasible(route, truck_drone.truck_stop(1), customer, truck_drone.truck_stop(2)))
+					solution.insert_rendevous(route, truck_drone.truck_stop(1), customer, truck_drone.truck_stop(2));
+				else
+					solution.insert<vrp::vehicle_type::truck_drone>(route, 1, customer);
+				break;
+			}
+			}
+
+			if (std::abs(solution.cost() - solution.manual_cost()) > .0001)
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
+			}
+		}
+
+		if (i == order.size())
+		{
+			std::cout << "Success\n";
+			std::cout << "\nTesting solution cost after removal...\n";
+
+			solution.remove<vrp::vehicle_type::autonomous>(0, 1);
+			solution.remove<vrp::vehicle_type::drone>(1, 0);
+			solution.remove_rendevous(0, 0);
+			solution.remove<vrp::vehicle_type::truck_drone>(1, 2);
+
+			double types = solution.cost<vrp::vehicle_type::autonomous>() + solution.cost<vrp::vehicle_type::van>() +
+						   solution.cost<vrp::vehicle_type::drone>() + solution.cost<vrp::vehicle_type::truck_drone>();
+			bool res = std::abs(solution.cost() - solution.manual_cost()) < .0001 && std::abs(types - solution.cost()) < .0001;
+			std::cout << (res ? "Success\n" : "Failed\n");
+			success &= res;
+		}
+		else
+			success = false;
+	}
+
+	// journal and location index test
+	{
+		vrp::solution solution(graph, fleet);
+
+		std::mt19937_64 gen(2);
+		std::vector<std::size_t> unrouted(customers.size() - 1);
+		std::iota(std::begin(unrouted), std::end(unrouted), 1);
+		std::shuffle(std::begin(unrouted), std::end(unrouted), gen);
+
+		auto take = [&]()
+		{
+			std::size_t customer = unrouted.back();
+			unrouted.pop_back();
+			return customer;
+		};
+
+		// half of the customers are routed before journaling
+		for (std::size_t i = 0; unrouted.size() > customers.size() / 2; ++i)
+		{
+			switch (i % 3)
+			{
+			case 0: solution.insert<vrp::vehicle_type::van>(i % fleet.van_count(), 1, take()); break;
+			case 1: solution.insert<vrp::vehicle_type::drone>(i % fleet.drone_count(), take()); break;
+			case 2: solution.insert<vrp::vehicle_type::truck_drone>(i % fleet.truck_drone_count(), 1, take()); break;
+			}
+		}
+
+		// removes the sorties of a truck_drone route that depart from or return to stop, which must go before the stop does
+		auto ground = [&](std::size_t route, std::size_t stop)
+		{
+			const auto &truck_drone = solution.route<vrp::vehicle_type::truck_drone>(route);
+			for (std::size_t k = truck_drone.size_rendevous(); k-- > 0;)
+			{
+				const vrp::drone_node &node = truck_drone.rendevous(k);
+				if (node.departure == stop || node.reunion == stop)
+				{
+					unrouted.push_back(node.service);
+					solution.remove_rendevous(route, k);
+				}
+			}
+		};
+
+		// a random destroy and repair step, keeps unrouted up to date
+		auto random_step = [&]()
+		{
+			std::uniform_int_distribution<int> operation(0, 6);
+			for (std::size_t change = 0; change < 20; ++change)
+			{
+				std::size_t route = gen() % 2;
+				const auto &van = solution.route<vrp::vehicle_type::van>(route);
+				const auto &drone = solution.route<vrp::vehicle_type::drone>(route);
+				const auto &truck_drone = solution.route<vrp::vehicle_type::truck_drone>(route);
+				switch (operation(gen))
+				{
+				case 0:
+					if (!unrouted.empty())
+						solution.insert<vrp::vehicle_type::van>(route, 1 + gen() % van.size(), take());
+					break;
+				case 1:
+					if (van.size() > 1)
+					{
+						std::size_t index = 1 + gen() % (van.size() - 1);
+						unrouted.push_back(van[index]);
+						solution.remove<vrp::vehicle_type::van>(route, index);
+					}
+					break;
+				case 2:
+					if (drone.size() > 0)
+					{
+						std::size_t index = gen() % drone.size();
+						unrouted.push_back(drone[index]);
+						solution.remove<vrp::vehicle_type::drone>(route, index);
+					}
+					if (!unrouted.empty())
+						solution.insert<vrp::vehicle_type::drone>(route, take());
+					break;
+				case 3:
+					if (truck_drone.size() > 1)
+					{
+						std::size_t index = 1 + gen() % (truck_drone.size() - 1);
+						ground(route, truck_drone.truck_stop(index));
+						unrouted.push_back(truck_drone.truck_stop(index));
+						solution.remove<vrp::vehicle_type::truck_drone>(route, index);
+					}
+					break;
+				case 4:
+					if (truck_drone.size_rendevous() > 0)
+					{
+						std::size_t index = gen() % truck_drone.size_rendevous();
+						unrouted.push_back(truck_drone.rendevous(index).service);
+						solution.remove_rendevous(route, index);
+					}
+					break;
+				case 5:
+					if (!unrouted.empty() && truck_drone.size() > 2)
+					{
+						std::size_t index = 1 + gen() % (truck_drone.size() - 2);
+						std::size_t departure = truck_drone.truck_stop(index), reunion = truck_drone.truck_stop(index + 1);
+						if (solution.sortie_feasible(route, departure, unrouted.back(), reunion))
+							solution.insert_rendevous(route, departure, take(), reunion);
+					}
+					break;
+				case 6:
+					// removal by customer id through the location index
+					if (unrouted.size() == customers.size() - 1)
+						break;
+					for (std::size_t customer = 1 + gen() % (customers.size() - 1); ; customer = customer % (customers.size() - 1) + 1)
+					{
+						if (solution.routed(customer))
+						{
+							if (const vrp::customer_location &loc = solution.location(customer); loc.type == vrp::vehicle_type::truck_drone && !loc.sortie)
+								ground(loc.route, customer);
+							solution.remove_customer(customer);
+							unrouted.push_back(customer);
+							break;
+						}
+					}
+					break;
+				}
+			}
+		};
+
+		std::cout << "\nTesting solution location index...\n";
+		std::size_t i = 0;
+		for (; i < 100; ++i)
+		{
+			random_step();
+			if (!consistent(solution, customers.size() - unrouted.size() - 1))
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
+			}
+		}
+
+		bool res = i == 100;
+		if (res)
+			std::cout << "Success\n";
+		success &= res;
+
+		std::cout << "\nTesting solution journal rollback...\n";
+		for (i = 0; i < 100; ++i)
+		{
+			vrp::solution copy = solution;
+			std::vector<std::size_t> unrouted_copy = unrouted;
+
+			solution.begin_journal();
+			random_step();
+			solution.rollback();
+			unrouted = unrouted_copy;
+
+			if (!same(solution, copy) || solution.journal_size() != 0 || !consistent(solution, customers.size() - unrouted.size() - 1))
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
+			}
+		}
+
+		res = i == 100;
+		if (res)
+			std::cout << "Success\n";
+		success &= res;
+
+		std::cout << "\nTesting solution hash...\n";
+		for (i = 0; i < 100; ++i)
+		{
+			std::uint64_t before = solution.hash();
+			std::vector<std::size_t> unrouted_copy = unrouted;
+			solution.begin_journal();
+			random_step();
+			bool updated = solution.hash() == solution.manual_hash();
+			solution.rollback();
+			unrouted = unrouted_copy;
+			if (!updated || solution.hash() != before || solution.hash() != solution.manual_hash())
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
+			}
+			random_step();
+		}
+
+		// the same routes built in a different order hash equally, and moving one customer changes the hash
+		vrp::solution forward(graph, fleet), backward(graph, fleet);
+		for (std::size_t c = 1; c <= 6; ++c)
+		{
+			forward.insert<vrp::vehicle_type::van>(0, c, c);
+			backward.insert<vrp::vehicle_type::van>(0, 1, 7 - c);
+		}
+		forward.insert<vrp::vehicle_type::drone>(0, 7);
+		forward.insert<vrp::vehicle_type::drone>(0, 8);
+		backward.insert<vrp::vehicle_type::drone>(0, 8);
+		backward.insert<vrp::vehicle_type::drone>(0, 7);
+		res = i == 100 && forward.hash() == backward.hash();
+		backward.remove<vrp::vehicle_type::van>(0, 3);
+		backward.insert<vrp::vehicle_type::van>(1, 1, 3);
+		res &= forward.hash() != backward.hash();
+		backward.remove<vrp::vehicle_type::van>(1, 1);
+		backward.insert<vrp::vehicle_type::van>(0, 3, 3);
+		res &= forward.hash() == backward.hash();
+		if (res)
+			std::cout << "Success\n";
+		success &= res;
+
+		std::cout << "\nTesting solution copies and compaction...\n";
+		vrp::solution scratch = solution;
+		for (i = 0; i < 100; ++i)
+		{
+			vrp::solution before = solution;
+			vrp::solution copy = solution;
+			random_step(); // changes the original only
+			scratch = solution;
+			copy.compact();
+
+			vrp::solution moved = std::move(copy);
+			if (!same(scratch, solution) || !consistent(scratch, customers.size() - unrouted.size() - 1) || !same(moved, before))
+			{
+				std::cout << "Failed on iteration " << i << '\n';
+				break;
+			}
+		}
+
+		scratch.clear();
+		res = i == 100 && scratch.cost() == 0 && consistent(scratch, 0) && scratch.route<vrp::vehicle_type::van>(0).size() == 1 &&
+			  scratch.hash() == vrp::solution(graph, fleet).hash();
+
+		// a solution without storage, default constructed or moved from, clears and compacts to itself
+		vrp::solution empty, emptied = std::move(scratch);
+		empty.clear();
+		empty.compact();
+		scratch.clear();
+		scratch.compact();
+		res &= empty.storage_size() == 0 && scratch.storage_size() == 0 && emptied.cost() == 0;
+		if (res)
+			std::cout << "Success\n";
+		success &= res;
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include "race.h"
+#include "statistics.h"
+#include "alns_tuning.h"
+
+#include <iostream>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+int main()
+{
+	bool success = true;
+
+	std::cout << "Testing statistics...\n";
+	{
+		auto near = [](double a, double b, double tolerance) { return std::abs(a - b) < tolerance; };
+		bool res = near(tuning::chi_squared_survival(3.841459, 1), .05, 1e-5) && near(tuning::chi_squared_survival(11.0705, 5), .05, 1e-5) &&
+			near(tuning::chi_squared_survival(0, 3), 1, 1e-12);
+		res &= near(tuning::student_t_cdf(0, 7), .5, 1e-12) && near(tuning::student_t_quantile(.975, 10), 2.228139, 1e-5) &&
+			near(tuning::student_t_quantile(.975, 1), 12.7062, 1e-3) && near(tuning::student_t_quantile(.025, 30), -2.042272, 1e-5);
+
+		std::vector<double> values{3, 1, 3, 2};
+		res &= tuning::ranks(values) == std::vector<double>{3.5, 1, 3.5, 2};
+
+		// treatment 0 is always best and 2 always worst, 3 ties with 0
+		std::vector<double> costs;
+		for (std::size_t b = 0; b < 10; ++b)
+			costs.insert(costs.end(), {1.0 + b, 2.0 + b, 3.0 + b, 1.0 + b});
+		tuning::friedman_result test = tuning::friedman_test(costs, 10, 4, .05);
+		res &= test.p_value < .001 && test.rank_sums == std::vector<double>{15, 30, 40, 15};
+		res &= test.rank_sums[1] - test.rank_sums[0] > test.critical_difference;
+
+		// nothing to tell apart when every block is a tie
+		std::vector<double> ties(30, 1.0);
+		res &= tuning::friedman_test(ties, 10, 3, .05).p_value == 1;
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting race...\n";
+	{
+		std::vector<tuning::parameter> space{
+			{"x", tuning::parameter_kind::real, 0, 1},
+			{"n", tuning::parameter_kind::integer, 0, 10},
+			{"b", tuning::parameter_kind::boolean},
+		};
+		// instances differ in scale much more than configurations, and runs are noisy
+		auto evaluate = [](const tuning::configuration &c, std::size_t instance, std::uint64_t seed)
+		{
+			std::mt19937_64 gen(seed);
+			double noise = std::normal_distribution<double>(0, .01)(gen);
+			return 10.0 * static_cast<double>(instance) + (c[0] - .3) * (c[0] - .3) + (c[1] - 7) * (c[1] - 7) / 100 + (c[2] != 0 ? 0 : .2) + noise;
+		};
+		tuning::race_settings settings{.budget = 2000, .thread_count = 2, .seed = 3};
+		tuning::race_result result = tuning::race(space, 4, evaluate, settings, {{.9, 0, 0}});
+
+		bool res = !result.elites.empty() && result.elites.size() == result.mean_costs.size() && result.evaluations <= settings.budget;
+		res &= result.configurations > result.evaluations / 10; // elimination let many configurations in
+		if (res)
+		{
+			const tuning::configuration &best = result.elites.front();
+			res &= std::abs(best[0] - .3) < .15 && std::abs(best[1] - 7) <= 2 && best[2] == 1 && best[1] == std::round(best[1]);
+		}
+
+		// sampling keeps to the constraint
+		tuning::race_result constrained = tuning::race(space, 4, evaluate, settings, {}, [](const tuning::configuration &c) { return c[0] >= .5; });
+		for (const tuning::configuration &c : constrained.elites)
+			res &= c[0] >= .5;
+
+		// a failing evaluation stops the race
+		try
+		{
+			tuning::race(space, 2, [](const tuning::configuration &, std::size_t, std::uint64_t) -> double { throw std::runtime_error("failed run"); }, settings);
+			res = false;
+		}
+		catch (const std::runtime_error &)
+		{
+		}
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	std::cout << "\nTesting ALNS tuning set...\n";
+	{
+		vrp::alns_parameters defaults;
+		defaults.iterations = 50;
+		tuning::configuration configuration = vrp::alns_configuration(defaults);
+		vrp::alns_parameters back = vrp::with_configuration({}, configuration);
+		bool res = configuration.size() == vrp::alns_space().size() && back.scores == defaults.scores && back.degree_of_destruction == defaults.degree_of_destruction &&
+			back.destroy == defaults.destroy && back.repair == defaults.repair && vrp::alns_allowed(configuration);
+		configuration[8] = configuration[9] = configuration[10] = configuration[11] = 0;
+		res &= !vrp::alns_allowed(configuration);
+
+		vrp::tuning_set set(defaults);
+		vrp::cost_data cost{.cost = 10, .cost_rate = 1};
+		set.add(vrp::random_customers(30, {}, 10, 1, 6, 0), vrp::fleet_info(4, cost, cost, cost, cost, {.capacity = 40, .max_range = 200, .cost = 1}), 1);
+		double first = set.evaluate(vrp::alns_configuration(defaults), 0, 5), second = set.evaluate(vrp::alns_configuration(defaults), 0, 5);
+		res &= set.size() == 1 && std::isfinite(first) && first == second;
+
+		std::cout << (res ? "Success\n" : "Failed\n");
+		success &= res;
+	}
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tuning
+{
+	enum class parameter_kind
+	{
+		real,
+		integer,
+		boolean,
+	};
+
+	struct parameter
+	{
+		std::string name;
+		parameter_kind kind = parameter_kind::real;
+		double min = 0, max = 1; // inclusive bounds, unused by booleans
+	};
+
+	// values of the parameters of a space in order, integers are whole and booleans 0 or 1
+	using configuration = std::vector<double>;
+
+	// cost of configuration on instance when run with seed, lower is better. called concurrently from every thread of
+	// the race, so whatever it shares between calls (the loaded instances) must be safe to read concurrently
+	using evaluator = std::function<double(const configuration &configuration, std::size_t instance, std::uint64_t seed)>;
+	// whether a configuration may be evaluated at all, sampling draws again when it may not
+	using constraint = std::function<bool(const configuration &configuration)>;
+
+	struct race_settings
+	{
+		std::size_t budget = 1000; // evaluations the whole tuning may use
+		std::size_t rounds = 0; // races, each sampling around the survivors of the previous one, 0 for 2 + log2(parameters)
+		std::size_t survivors = 0; // a race stops once this few configurations are left, 0 for 2 + log2(parameters)
+		std::size_t first_test = 5; // blocks every configuration is run on before the first elimination
+		std::size_t max_blocks = 0; // blocks after which a race stops, 0 for no limit but the budget
+		double alpha = .05; // level of the tests that eliminate configurations
+		std::size_t thread_count = 0; // concurrent evaluations, 0 for one per core
+		std::uint64_t seed = 0;
+	};
+
+	struct race_result
+	{
+		std::vector<configuration> elites; // survivors of the last race, best first
+		std::vector<double> mean_costs; // of every elite over the blocks of the last race
+		std::size_t evaluations = 0;
+		std::size_t configurations = 0; // raced over every round, elites counted once per round they raced in
+		std::size_t rounds = 0;
+	};
+
+	// iterated racing (Birattari et al., F-race and irace) for the configuration of space with the lowest cost over
+	// instance_count instances. each round samples configurations, around the elites of the previous round after the
+	// first, and races them: every configuration still in the race is evaluated on the next block (an instance and a
+	// seed shared by all of them, instances cycled in a shuffled order) and, from first_test blocks on, Friedman's test
+	// eliminates every configuration whose rank sum is significantly worse than the best one. a race spends a share of
+	// the budget left and evaluates several blocks per step when fewer configurations than threads remain
+	// initial configurations (the defaults, say) are raced in the first round alongside the sampled ones
+	// throws std::invalid_argument on an empty or invalid space, and rethrows the first exception of evaluate
+	race_result race(const std::vector<parameter> &space, std::size_t instance_count, const evaluator &evaluate,
+	                 const race_settings &settings, std::vector<configuration> initial = {}, const constraint &allowed = {});
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace tuning
+{
+	// P(X >= x) for X chi squared distributed with dof degrees of freedom
+	double chi_squared_survival(double x, double dof);
+	// P(X <= t) for X Student t distributed with dof degrees of freedom
+	double student_t_cdf(double t, double dof);
+	// t such that student_t_cdf(t, dof) == p, 0 < p < 1
+	double student_t_quantile(double p, double dof);
+
+	// ranks of values, lowest first from 1, tied values share the mean of their ranks
+	std::vector<double> ranks(std::span<const double> values);
+
+	struct friedman_result
+	{
+		double statistic = 0;
+		double p_value = 1;
+		std::vector<double> rank_sums; // of every treatment over the blocks, lower is better
+		// two treatments whose rank sums differ by more than this differ at the tested level (Conover's post hoc test),
+		// infinity if the test cannot tell any apart
+		double critical_difference = 0;
+	};
+
+	// Friedman's rank test of treatments treatments measured in blocks blocks, costs[b * treatments + t] is treatment t
+	// in block b. every block is ranked on its own, so blocks may differ in scale, as instances of a problem do
+	friedman_result friedman_test(std::span<const double> costs, std::size_t blocks, std::size_t treatments, double alpha);
+}
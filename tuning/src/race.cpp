@@ -0,0 +1,319 @@
+#include "race.h"
+#include "statistics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace tuning
+{
+	namespace
+	{
+		constexpr std::size_t sampling_attempts = 100; // draws of a configuration before the constraint is given up on
+
+		std::uint64_t mix(std::uint64_t x)
+		{
+			x += 0x9e3779b97f4a7c15ull;
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+			return x ^ (x >> 31);
+		}
+
+		// calls fn(i) for every i in [0, count) on thread_count threads, then rethrows the first exception fn threw
+		template <typename Fn>
+		void for_each_index(std::size_t count, std::size_t thread_count, Fn &&fn)
+		{
+			std::atomic<std::size_t> next{0};
+			std::exception_ptr error;
+			std::mutex error_mutex;
+			auto work = [&]()
+			{
+				for (std::size_t i = next++; i < count; i = next++)
+				{
+					try
+					{
+						fn(i);
+					}
+					catch (...)
+					{
+						std::lock_guard lock(error_mutex);
+						if (!error)
+							error = std::current_exception();
+						next = count;
+					}
+				}
+			};
+
+			{
+				std::vector<std::jthread> threads;
+				for (std::size_t t = 1; t < std::min(thread_count, count); ++t)
+					threads.emplace_back(work);
+				work();
+			}
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		double clamp_value(const parameter &p, double value)
+		{
+			if (p.kind == parameter_kind::boolean)
+				return value >= .5 ? 1 : 0;
+			value = std::clamp(value, p.min, p.max);
+			return p.kind == parameter_kind::integer ? std::round(value) : value;
+		}
+
+		class sampler
+		{
+		public:
+			sampler(const std::vector<parameter> &space, const constraint &allowed, std::mt19937_64 &gen) :
+				M_space{&space}, M_allowed{&allowed}, M_gen{&gen}
+			{
+			}
+
+			configuration uniform()
+			{
+				return draw([&]()
+				{
+					configuration res(M_space->size());
+					for (std::size_t i = 0; i < res.size(); ++i)
+					{
+						const parameter &p = (*M_space)[i];
+						if (p.kind == parameter_kind::boolean)
+							res[i] = std::bernoulli_distribution(.5)(*M_gen);
+						else if (p.kind == parameter_kind::integer)
+							res[i] = static_cast<double>(std::uniform_int_distribution<long long>(std::llround(std::ceil(p.min)), std::llround(std::floor(p.max)))(*M_gen));
+						else
+							res[i] = std::uniform_real_distribution<double>(p.min, p.max)(*M_gen);
+					}
+					return res;
+				});
+			}
+
+			// a configuration near parent, spread is the fraction of each range a value strays by and the chance of a
+			// boolean flipping twice over
+			configuration around(const configuration &parent, double spread)
+			{
+				return draw([&]()
+				{
+					configuration res = parent;
+					for (std::size_t i = 0; i < res.size(); ++i)
+					{
+						const parameter &p = (*M_space)[i];
+						if (p.kind == parameter_kind::boolean)
+						{
+							if (std::bernoulli_distribution(spread / 2)(*M_gen))
+								res[i] = 1 - res[i];
+						}
+						else if (p.max > p.min)
+							res[i] = clamp_value(p, std::normal_distribution<double>(parent[i], (p.max - p.min) * spread)(*M_gen));
+					}
+					return res;
+				});
+			}
+
+		private:
+			const std::vector<parameter> *M_space;
+			const constraint *M_allowed;
+			std::mt19937_64 *M_gen;
+
+			template <typename Draw>
+			configuration draw(Draw &&fn)
+			{
+				configuration res = fn();
+				for (std::size_t attempt = 1; attempt < sampling_attempts && *M_allowed && !(*M_allowed)(res); ++attempt)
+					res = fn();
+				return res;
+			}
+		};
+
+		struct standing
+		{
+			std::vector<configuration> survivors; // best first
+			std::vector<double> mean_costs;
+			std::size_t evaluations = 0;
+		};
+
+		// one F-race of candidates within budget evaluations
+		standing run_race(std::vector<configuration> candidates, std::size_t instance_count, const evaluator &evaluate,
+		                  const race_settings &settings, std::size_t survivors, std::size_t threads, std::size_t budget, std::mt19937_64 &gen)
+		{
+			std::size_t count = candidates.size();
+			std::vector<std::size_t> alive(count);
+			std::iota(alive.begin(), alive.end(), 0);
+			std::vector<std::vector<double>> costs(count); // costs[c][b], every alive candidate has every block
+
+			// block b runs instance order[b % instance_count], the order is shuffled again every cycle
+			std::vector<std::size_t> order(instance_count);
+			std::vector<std::pair<std::size_t, std::uint64_t>> blocks;
+			auto block = [&](std::size_t b)
+			{
+				while (blocks.size() <= b)
+				{
+					if (blocks.size() % instance_count == 0)
+					{
+						std::iota(order.begin(), order.end(), 0);
+						std::shuffle(order.begin(), order.end(), gen);
+					}
+					blocks.emplace_back(order[blocks.size() % instance_count], gen());
+				}
+				return blocks[b];
+			};
+
+			std::size_t block_count = 0, spent = 0;
+			std::vector<double> matrix;
+			friedman_result ranking;
+			auto rank = [&]()
+			{
+				matrix.resize(block_count * alive.size());
+				for (std::size_t b = 0; b < block_count; ++b)
+					for (std::size_t i = 0; i < alive.size(); ++i)
+						matrix[b * alive.size() + i] = costs[alive[i]][b];
+				ranking = friedman_test(matrix, block_count, alive.size(), settings.alpha);
+			};
+
+			while (true)
+			{
+				std::size_t step = block_count < settings.first_test ? settings.first_test - block_count : (threads + alive.size() - 1) / alive.size();
+				if (settings.max_blocks)
+					step = std::min(step, settings.max_blocks - std::min(block_count, settings.max_blocks));
+				step = std::min(step, (budget - spent) / alive.size());
+				if (step == 0)
+					break;
+
+				for (std::size_t c : alive)
+					costs[c].resize(block_count + step);
+				for (std::size_t b = block_count; b < block_count + step; ++b)
+					block(b);
+				for_each_index(alive.size() * step, threads, [&](std::size_t task)
+				{
+					std::size_t c = alive[task % alive.size()], b = block_count + task / alive.size();
+					costs[c][b] = evaluate(candidates[c], blocks[b].first, blocks[b].second);
+				});
+				block_count += step;
+				spent += alive.size() * step;
+
+				if (block_count < settings.first_test)
+					continue;
+				if (alive.size() <= survivors)
+					break;
+				if (block_count < 2)
+					continue;
+
+				rank();
+				if (ranking.p_value < settings.alpha)
+				{
+					double best = *std::min_element(ranking.rank_sums.begin(), ranking.rank_sums.end());
+					std::vector<std::size_t> kept;
+					for (std::size_t i = 0; i < alive.size(); ++i)
+						if (ranking.rank_sums[i] - best <= ranking.critical_difference)
+							kept.push_back(alive[i]);
+					alive = std::move(kept);
+				}
+				if (alive.size() <= survivors)
+					break;
+			}
+
+			standing res;
+			res.evaluations = spent;
+			if (block_count == 0)
+				return res;
+
+			rank();
+			std::vector<std::size_t> by_rank(alive.size());
+			std::iota(by_rank.begin(), by_rank.end(), 0);
+			std::stable_sort(by_rank.begin(), by_rank.end(), [&](std::size_t a, std::size_t b) { return ranking.rank_sums[a] < ranking.rank_sums[b]; });
+			for (std::size_t i : by_rank)
+			{
+				const std::vector<double> &c = costs[alive[i]];
+				res.survivors.push_back(std::move(candidates[alive[i]]));
+				res.mean_costs.push_back(std::accumulate(c.begin(), c.end(), 0.0) / static_cast<double>(c.size()));
+			}
+			return res;
+		}
+	}
+
+	race_result race(const std::vector<parameter> &space, std::size_t instance_count, const evaluator &evaluate,
+	                 const race_settings &settings, std::vector<configuration> initial, const constraint &allowed)
+	{
+		if (space.empty() || instance_count == 0)
+			throw std::invalid_argument("Race needs parameters and instances");
+		for (const parameter &p : space)
+			if (p.kind != parameter_kind::boolean && !(p.min <= p.max))
+				throw std::invalid_argument("Invalid range of parameter " + p.name);
+		for (configuration &c : initial)
+		{
+			if (c.size() != space.size())
+				throw std::invalid_argument("Initial configuration does not match the parameters");
+			for (std::size_t i = 0; i < c.size(); ++i)
+				c[i] = clamp_value(space[i], c[i]);
+		}
+
+		double dimensions = static_cast<double>(space.size());
+		std::size_t log_dimensions = static_cast<std::size_t>(std::log2(dimensions));
+		std::size_t rounds = settings.rounds ? settings.rounds : 2 + log_dimensions;
+		std::size_t survivors = settings.survivors ? settings.survivors : 2 + log_dimensions;
+		std::size_t threads = settings.thread_count ? settings.thread_count : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+		std::mt19937_64 gen(mix(settings.seed));
+		sampler sample(space, allowed, gen);
+		race_result res;
+		std::vector<configuration> elites = std::move(initial);
+		std::vector<double> elite_costs;
+
+		for (std::size_t round = 1; round <= rounds && res.evaluations < settings.budget; ++round)
+		{
+			// irace's split: an equal share of what is left per remaining round, and as many configurations as can each
+			// get the first test and a few more blocks
+			std::size_t budget = (settings.budget - res.evaluations) / (rounds - round + 1);
+			std::size_t count = budget / (std::max<std::size_t>(settings.first_test, 1) + std::min<std::size_t>(5, round));
+			if (count < 2 && round > 1)
+				break;
+
+			std::vector<configuration> candidates = elites;
+			candidates.resize(std::min(candidates.size(), std::max<std::size_t>(count, 1)));
+			double spread = std::pow(1 / static_cast<double>(std::max<std::size_t>(count, 1)), static_cast<double>(round - 1) / dimensions);
+			std::size_t parents = round > 1 ? elites.size() : 0;
+			while (candidates.size() < count)
+			{
+				if (parents == 0)
+				{
+					candidates.push_back(sample.uniform());
+					continue;
+				}
+				// elites are picked with weights falling linearly with their rank
+				std::size_t total = parents * (parents + 1) / 2, pick = std::uniform_int_distribution<std::size_t>(0, total - 1)(gen), parent = 0;
+				while (pick >= parents - parent)
+					pick -= parents - parent++;
+				candidates.push_back(sample.around(elites[parent], spread));
+			}
+			if (candidates.empty())
+				break;
+
+			res.configurations += candidates.size();
+			standing result = run_race(std::move(candidates), instance_count, evaluate, settings, survivors, threads, budget, gen);
+			res.evaluations += result.evaluations;
+			res.rounds = round;
+			if (result.survivors.empty())
+				break;
+			elites = std::move(result.survivors);
+			elite_costs = std::move(result.mean_costs);
+			if (elites.size() > survivors)
+			{
+				elites.resize(survivors);
+				elite_costs.resize(survivors);
+			}
+		}
+
+		res.elites = std::move(elites);
+		res.mean_costs = std::move(elite_costs);
+		if (res.mean_costs.size() != res.elites.size()) // no race ran, only initial configurations are known
+			res.elites.clear();
+		return res;
+	}
+}
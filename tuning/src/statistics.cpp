@@ -0,0 +1,179 @@
+#include "statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace tuning
+{
+	namespace
+	{
+		constexpr double epsilon = 1e-15;
+		constexpr double tiny = 1e-300;
+		constexpr int max_terms = 500;
+
+		// Q(a, x), the upper regularized incomplete gamma function
+		double gamma_q(double a, double x)
+		{
+			if (x <= 0)
+				return 1;
+			double log_front = a * std::log(x) - x - std::lgamma(a);
+			if (x < a + 1)
+			{
+				// series of P(a, x)
+				double term = 1 / a, sum = term;
+				for (int n = 1; n < max_terms && std::abs(term) > std::abs(sum) * epsilon; ++n)
+				{
+					term *= x / (a + n);
+					sum += term;
+				}
+				return 1 - sum * std::exp(log_front);
+			}
+
+			// continued fraction of Q(a, x), by Lentz's method
+			double b = x + 1 - a, c = 1 / tiny, d = 1 / b, h = d;
+			for (int n = 1; n < max_terms; ++n)
+			{
+				double an = -n * (n - a);
+				b += 2;
+				d = an * d + b;
+				d = std::abs(d) < tiny ? tiny : d;
+				c = b + an / c;
+				c = std::abs(c) < tiny ? tiny : c;
+				d = 1 / d;
+				double delta = d * c;
+				h *= delta;
+				if (std::abs(delta - 1) < epsilon)
+					break;
+			}
+			return std::exp(log_front) * h;
+		}
+
+		// continued fraction of the incomplete beta function, by Lentz's method
+		double beta_fraction(double x, double a, double b)
+		{
+			double c = 1, d = 1 - (a + b) * x / (a + 1);
+			d = 1 / (std::abs(d) < tiny ? tiny : d);
+			double h = d;
+			for (int m = 1; m < max_terms; ++m)
+			{
+				double even = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+				d = 1 / (std::abs(1 + even * d) < tiny ? tiny : 1 + even * d);
+				c = std::abs(1 + even / c) < tiny ? tiny : 1 + even / c;
+				h *= d * c;
+
+				double odd = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+				d = 1 / (std::abs(1 + odd * d) < tiny ? tiny : 1 + odd * d);
+				c = std::abs(1 + odd / c) < tiny ? tiny : 1 + odd / c;
+				double delta = d * c;
+				h *= delta;
+				if (std::abs(delta - 1) < epsilon)
+					break;
+			}
+			return h;
+		}
+
+		// I_x(a, b), the regularized incomplete beta function
+		double beta_i(double x, double a, double b)
+		{
+			if (x <= 0)
+				return 0;
+			if (x >= 1)
+				return 1;
+			double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log1p(-x));
+			if (x < (a + 1) / (a + b + 2))
+				return front * beta_fraction(x, a, b) / a;
+			return 1 - front * beta_fraction(1 - x, b, a) / b;
+		}
+	}
+
+	double chi_squared_survival(double x, double dof)
+	{
+		return std::clamp(gamma_q(dof / 2, x / 2), 0.0, 1.0);
+	}
+
+	double student_t_cdf(double t, double dof)
+	{
+		double tail = beta_i(dof / (dof + t * t), dof / 2, .5) / 2;
+		return t >= 0 ? 1 - tail : tail;
+	}
+
+	double student_t_quantile(double p, double dof)
+	{
+		if (!(p > 0 && p < 1))
+			throw std::invalid_argument("Quantile probability must be in (0, 1)");
+		if (p < .5)
+			return -student_t_quantile(1 - p, dof);
+
+		double low = 0, high = 1;
+		while (student_t_cdf(high, dof) < p)
+			high *= 2;
+		for (int i = 0; i < 200 && high - low > 1e-12 * high; ++i)
+		{
+			double mid = (low + high) / 2;
+			(student_t_cdf(mid, dof) < p ? low : high) = mid;
+		}
+		return (low + high) / 2;
+	}
+
+	std::vector<double> ranks(std::span<const double> values)
+	{
+		std::vector<std::size_t> order(values.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return values[a] < values[b]; });
+
+		std::vector<double> res(values.size());
+		for (std::size_t i = 0; i < order.size();)
+		{
+			std::size_t j = i;
+			while (j + 1 < order.size() && values[order[j + 1]] == values[order[i]])
+				++j;
+			double rank = (i + j) / 2.0 + 1;
+			for (std::size_t t = i; t <= j; ++t)
+				res[order[t]] = rank;
+			i = j + 1;
+		}
+		return res;
+	}
+
+	friedman_result friedman_test(std::span<const double> costs, std::size_t blocks, std::size_t treatments, double alpha)
+	{
+		if (costs.size() != blocks * treatments)
+			throw std::invalid_argument("Friedman test needs blocks * treatments costs");
+
+		friedman_result res;
+		res.rank_sums.assign(treatments, 0);
+		res.critical_difference = std::numeric_limits<double>::infinity();
+		if (blocks < 2 || treatments < 2)
+			return res;
+
+		double squares = 0; // A, the sum of every squared rank
+		for (std::size_t b = 0; b < blocks; ++b)
+		{
+			std::vector<double> block = ranks(costs.subspan(b * treatments, treatments));
+			for (std::size_t t = 0; t < treatments; ++t)
+			{
+				res.rank_sums[t] += block[t];
+				squares += block[t] * block[t];
+			}
+		}
+
+		double n = static_cast<double>(blocks), k = static_cast<double>(treatments);
+		double correction = n * k * (k + 1) * (k + 1) / 4; // C
+		if (squares - correction <= 0) // every block is one tie
+			return res;
+
+		double spread = 0;
+		for (double sum : res.rank_sums)
+			spread += (sum - n * (k + 1) / 2) * (sum - n * (k + 1) / 2);
+		res.statistic = (k - 1) * spread / (squares - correction);
+		res.p_value = chi_squared_survival(res.statistic, k - 1);
+
+		double dof = (n - 1) * (k - 1);
+		double variance = 2 * n * (1 - res.statistic / (n * (k - 1))) * (squares - correction) / dof;
+		res.critical_difference = student_t_quantile(1 - alpha / 2, dof) * std::sqrt(std::max(variance, 0.0));
+		return res;
+	}
+}
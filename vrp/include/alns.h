@@ -0,0 +1,1072 @@
+#pragma once
+#include "solution.h"
+#include "parallel.h"
+#include "relatedness.h"
+#include "clustering.h"
+#include "visited_set.h"
+#include "local_search.h"
+#include "sorties.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+VRP_BEG
+
+// destroy operators, indexed like alns_parameters::destroy
+enum class destroy_operator
+{
+	random, // II, customers picked uniformly
+	related, // RD, customers close to the ones already removed
+	worst, // WD, customers whose removal saves the most
+	cluster, // CD, a spatial cluster of customers across routes, or one side of a route split in two
+};
+
+// repair operators, indexed like alns_parameters::repair
+enum class repair_operator
+{
+	cheapest, // CI, customers in random order, each at its cheapest position
+	greedy, // GR, the cheapest insertion over every customer first
+	regret, // RR, the customer that loses the most by not getting one of its k best routes first (regret-k)
+};
+
+struct alns_parameters
+{
+	// score of the operators of an iteration that found a new best solution, improved the current one, was accepted, was rejected
+	std::array<double, 4> scores{24, 22, 20, 4};
+	double reaction_factor = .16; // how much the scores of a segment move the weights
+	double degree_of_destruction = .41; // fraction of the customers removed per iteration
+	double start_worse = 2.04; // percent, a solution this much worse than the initial one is first accepted with probability 0.5
+	double determinism = 5; // higher values make the related and worst removals pick their best candidates more often
+	double cooling = .99975; // temperature multiplier per iteration
+	std::size_t segment_length = 100; // iterations between weight updates
+	std::size_t iterations = 25000;
+	double time_limit = 0; // wall clock seconds a run may take, 0 for no limit
+	std::size_t checkpoint_interval = 1000; // iterations between the checkpoints of a search given a checkpoint_writer
+	std::size_t compact_interval = 1000; // iterations between compactions of the route storage
+	std::size_t related_k = 32; // length of the relatedness lists related removal draws from
+	std::size_t cluster_size = 10; // customers per cluster of cluster removal
+	std::size_t regret_k = 2; // the regret repair compares the k cheapest routes of each customer
+	std::size_t repair_threads = 1; // threads of the greedy and regret repairs, the graph must then be safe to read concurrently
+	std::size_t parallel_threshold = 64; // fewest customers to insert for the repairs to use their threads
+	std::size_t visited_capacity = 1 << 16; // hashes of accepted solutions remembered to reject revisits, 0 to remember none
+	std::size_t local_search_k = 10; // nearest neighbors the local search applied to every new best tries, 0 disables it
+	std::size_t sortie_k = 32; // nearest stops a sortie serving a customer may depart from
+	std::array<bool, 4> destroy{true, true, true, true}; // enabled destroy operators
+	std::array<bool, 3> repair{true, true, true}; // enabled repair operators
+	std::uint64_t seed = 0;
+};
+
+struct alns_statistics
+{
+	std::size_t iterations;
+	std::size_t improvements; // new best solutions found
+	std::size_t duplicates; // candidates that had already been accepted, rejected without the acceptance test
+	double seconds;
+
+	double iterations_per_second() const { return seconds > 0 ? iterations / seconds : 0; }
+};
+
+// precomputed data of the operators and the local search, built once for a graph and fleet and shared by every search on them
+struct search_indexes
+{
+	relatedness_index related;
+	customer_clusters clusters;
+	neighbor_lists neighbors; // candidates of the local search
+	sortie_table sorties; // nearest stops in drone range of every customer, empty without truck_drone routes
+
+	// built on thread_count threads (0 for all cores), so the graph must be safe to read concurrently unless it is 1
+	template <graph_backend Graph>
+	search_indexes(const Graph &graph, const fleet_info &fleet, const alns_parameters &parameters, std::size_t thread_count) :
+		related(graph, parameters.related_k, thread_count), clusters(graph.customers(), parameters.cluster_size, thread_count),
+		neighbors(local_search_neighbors(graph, parameters.local_search_k, thread_count)),
+		sorties(fleet.truck_drone_count() ? sortie_table(graph, fleet.vehicle_data(vehicle_type::drone), parameters.sortie_k, thread_count) : sortie_table{})
+	{
+	}
+
+private:
+	// the graph's own lists if it has them for k, as a graph read from a file may, otherwise new ones
+	template <graph_backend Graph>
+	static neighbor_lists local_search_neighbors(const Graph &graph, std::size_t k, std::size_t thread_count)
+	{
+		if constexpr (requires { graph.neighbors(); })
+			if (!graph.neighbors().empty() && graph.neighbors().k() == std::min(k, graph.size() - 1))
+				return graph.neighbors();
+		return neighbor_lists(graph.customers(), k, thread_count);
+	}
+};
+
+// best solution over several concurrent searches. its objective is lowered atomically so any thread reads it without
+// locking, its routes (see write_routes) are swapped in under a lock, so a search only encodes its own best outside it
+// the searches publish to it but never read it back: pruning on another search's objective would make every search
+// depend on thread timing instead of its seed alone, so that is out of scope
+class shared_incumbent
+{
+public:
+	shared_incumbent() : M_objective{std::numeric_limits<double>::infinity()} {}
+
+	double objective() const { return M_objective.load(std::memory_order_relaxed); }
+
+	// makes the solution encoded in routes the incumbent if objective is better, swapping routes with the previous
+	// incumbent's buffer, returns whether it was
+	bool offer(double objective, std::vector<std::uint32_t> &routes)
+	{
+		if (objective >= this->objective())
+			return false;
+		std::lock_guard lock(M_mutex);
+		if (objective >= this->objective())
+			return false;
+		M_routes.swap(routes);
+		M_objective.store(objective, std::memory_order_relaxed);
+		return true;
+	}
+
+	// copies the routes of the incumbent into out, empty if nothing was offered, returns its objective
+	double snapshot(std::vector<std::uint32_t> &out) const
+	{
+		std::lock_guard lock(M_mutex);
+		out.assign(M_routes.begin(), M_routes.end());
+		return objective();
+	}
+
+private:
+	alignas(64) std::atomic<double> M_objective; // on its own cache line, read by every worker
+	mutable std::mutex M_mutex; // guards M_routes and the writes of M_objective
+	std::vector<std::uint32_t> M_routes;
+};
+
+// adaptive large neighborhood search (Ropke & Pisinger) over a basic_solution
+// every iteration destroys part of the current solution and repairs it with operators picked by roulette wheel,
+// the candidate is kept through simulated annealing, otherwise the solution's journal rolls it back
+// every buffer is sized up front, so once the route storage has grown to its working size an iteration does not allocate
+template <graph_backend Graph>
+class basic_alns
+{
+public:
+	// buffers a finished search hands to the next one, see release
+	struct scratch;
+
+	// a customer the solution cannot serve costs penalty, which exceeds the cost of any single insertion
+	// the destroy operators and the local search use indexes, which must outlive the search, or their own built with
+	// repair_threads threads if it is null
+	// the search's buffers are taken from buffers if it is not null, so they keep the memory a previous search released
+	basic_alns(const Graph &graph, const fleet_info &fleet, const alns_parameters &parameters, const search_indexes *indexes = nullptr, scratch *buffers = nullptr) :
+		M_graph{&graph}, M_parameters{parameters}, M_current(graph, fleet), M_best{}, M_gen{parameters.seed},
+		M_destroy_weights{}, M_destroy_scores{}, M_destroy_uses{}, M_repair_weights{}, M_repair_scores{}, M_repair_uses{},
+		M_temperature{}, M_penalty{}, M_current_objective{}, M_best_objective{}, M_iteration{},
+		M_own_indexes{indexes ? nullptr : std::make_unique<search_indexes>(graph, fleet, parameters, parameters.repair_threads)},
+		M_indexes{indexes ? indexes : M_own_indexes.get()}, M_own_visited(take_visited(buffers, parameters.visited_capacity)), M_visited{&M_own_visited}, M_duplicates{}
+	{
+		if (std::ranges::none_of(parameters.destroy, std::identity{}) || std::ranges::none_of(parameters.repair, std::identity{}))
+			throw std::invalid_argument("At least one destroy and one repair operator must be enabled");
+
+		if (buffers)
+		{
+			M_removed = std::move(buffers->removed);
+			M_pool = std::move(buffers->pool);
+			M_candidates = std::move(buffers->candidates);
+			M_table = std::move(buffers->table);
+			M_top = std::move(buffers->top);
+			M_top_columns = std::move(buffers->top_columns);
+			M_removed.clear();
+			M_pool.clear();
+			M_candidates.clear();
+		}
+
+		std::size_t n = graph.size();
+		M_removed.reserve(n);
+		M_pool.reserve(n);
+		M_candidates.reserve(n);
+		M_current.reserve_journal(4 * n);
+
+		basic_solution<Graph>::for_each_type([&](auto type)
+		{
+			if constexpr (type == vehicle_type::drone)
+			{
+				if (fleet.count(type))
+					M_columns.push_back({type, 0});
+			}
+			else
+			{
+				for (std::size_t r = 0; r < fleet.count(type); ++r)
+					M_columns.push_back({type, static_cast<std::uint32_t>(r)});
+			}
+		});
+		M_k = std::clamp<std::size_t>(parameters.regret_k, 1, std::max<std::size_t>(M_columns.size(), 1));
+		M_table.resize(n * M_columns.size());
+		M_top.resize(n * M_k);
+		M_top_columns.resize(n * M_k);
+		if (parameters.repair_threads != 1)
+			M_workers = std::make_unique<work_stealing_pool>(parameters.repair_threads);
+		if (parameters.local_search_k && !M_indexes->neighbors.empty())
+			M_local_search = std::make_unique<basic_local_search<Graph>>(graph, fleet, M_indexes->neighbors);
+
+		M_destroy_weights.fill(1);
+		M_repair_weights.fill(1);
+
+		double farthest = 0;
+		for (std::size_t c = 1; c < n; ++c)
+			farthest = std::max(farthest, graph.van_distance(0, c) + graph.van_distance(c, 0));
+		M_penalty = 10 * std::max(farthest, 1.0);
+
+		// initial solution, every customer inserted by the cheapest insertion
+		for (std::size_t c = 1; c < n; ++c)
+			M_removed.push_back(static_cast<std::uint32_t>(c));
+		repair(repair_operator::cheapest);
+		if (M_local_search)
+			M_local_search->improve(M_current);
+
+		M_current_objective = M_best_objective = objective();
+		M_best = M_current;
+		M_visited->insert(M_current.hash());
+		M_temperature = -(parameters.start_worse / 100 * M_current_objective) / std::log(.5);
+	}
+
+	// runs iterations more iterations, fewer if deadline passes first, continuing from the state the previous call left
+	alns_statistics run(std::size_t iterations, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max())
+	{
+		alns_statistics res{.iterations = 0, .improvements = 0, .duplicates = M_duplicates, .seconds = 0};
+		auto start = std::chrono::steady_clock::now();
+		bool timed = deadline != std::chrono::steady_clock::time_point::max();
+		for (; res.iterations < iterations && (!timed || std::chrono::steady_clock::now() < deadline); ++res.iterations)
+		{
+			res.improvements += iterate();
+			if (M_checkpoint && M_iteration % M_parameters.checkpoint_interval == 0)
+				checkpoint();
+		}
+		res.duplicates = M_duplicates - res.duplicates;
+		res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return res;
+	}
+	// parameters.iterations iterations within parameters.time_limit
+	alns_statistics run() { return run(M_parameters.iterations, deadline(M_parameters, std::chrono::steady_clock::now())); }
+
+	// end of a run of parameters started at start, the largest time point if it has no time limit
+	static std::chrono::steady_clock::time_point deadline(const alns_parameters &parameters, std::chrono::steady_clock::time_point start)
+	{
+		if (parameters.time_limit <= 0)
+			return std::chrono::steady_clock::time_point::max();
+		return start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(parameters.time_limit));
+	}
+
+	const basic_solution<Graph> &best() const { return M_best; }
+	const basic_solution<Graph> &current() const { return M_current; }
+	// cost of the best solution, plus the penalty of the customers it does not serve
+	double best_objective() const { return M_best_objective; }
+	// customers solution does not serve
+	static std::size_t unrouted(const basic_solution<Graph> &solution)
+	{
+		std::size_t res = 0;
+		for (std::size_t c = 1; c < solution.graph().size(); ++c)
+			res += !solution.routed(c);
+		return res;
+	}
+
+	// moves the search's buffers into buffers for the next search on this thread to take, the search must not be
+	// used afterwards but to be destroyed. the visited set is only handed over if the search did not share another one
+	void release(scratch &buffers)
+	{
+		buffers.removed = std::move(M_removed);
+		buffers.pool = std::move(M_pool);
+		buffers.candidates = std::move(M_candidates);
+		buffers.table = std::move(M_table);
+		buffers.top = std::move(M_top);
+		buffers.top_columns = std::move(M_top_columns);
+		if (M_visited == &M_own_visited)
+			buffers.visited = std::move(M_own_visited);
+	}
+
+	// every new best solution is offered to incumbent, which must outlive the search
+	void publish_to(shared_incumbent &incumbent)
+	{
+		M_incumbent = &incumbent;
+		publish();
+	}
+
+	// remembers accepted solutions in visited, which must outlive the search and may be shared with other searches,
+	// instead of in the search's own set. a solution another search accepted is then a revisit too
+	void share_visited(visited_set &visited)
+	{
+		M_own_visited = visited_set{};
+		M_visited = &visited;
+		M_visited->insert(M_current.hash());
+	}
+
+	// replaces the current solution by one of objective found elsewhere, which becomes the best if it is better
+	// only between calls to run
+	void adopt(const basic_solution<Graph> &solution, double objective)
+	{
+		M_current = solution;
+		M_current_objective = objective;
+		M_visited->insert(solution.hash());
+		if (objective < M_best_objective)
+		{
+			M_best = solution;
+			M_best_objective = objective;
+		}
+	}
+	double current_objective() const { return M_current_objective; }
+
+	// moves the operator weights halfway towards the ones of another search
+	void merge_weights(const std::array<double, 4> &destroy, const std::array<double, 3> &repair)
+	{
+		for (std::size_t i = 0; i < destroy.size(); ++i)
+			M_destroy_weights[i] = (M_destroy_weights[i] + destroy[i]) / 2;
+		for (std::size_t i = 0; i < repair.size(); ++i)
+			M_repair_weights[i] = (M_repair_weights[i] + repair[i]) / 2;
+	}
+
+	// every parameters.checkpoint_interval iterations the state of the search is handed to writer as search index, the
+	// writer must outlive the search
+	void checkpoint_to(checkpoint_writer &writer, std::size_t index)
+	{
+		if (M_parameters.checkpoint_interval == 0)
+			throw std::invalid_argument("Checkpoint interval must be positive");
+		M_checkpoint = &writer;
+		M_checkpoint_index = index;
+	}
+	// hands the state of the search to its writer now, the state is saved on this thread and the file is written on the writer's
+	void checkpoint()
+	{
+		if (!M_checkpoint)
+			return;
+		save(M_snapshot);
+		M_checkpoint->submit(M_checkpoint_index, M_snapshot);
+	}
+
+	// everything restore needs to continue the search where it is, only between calls to run
+	void save(search_checkpoint &state) const
+	{
+		state.iteration = M_iteration;
+		state.temperature = M_temperature;
+		state.current_objective = M_current_objective;
+		state.best_objective = M_best_objective;
+		state.destroy_weights = M_destroy_weights;
+		state.destroy_scores = M_destroy_scores;
+		std::ranges::copy(M_destroy_uses, state.destroy_uses.begin());
+		state.repair_weights = M_repair_weights;
+		state.repair_scores = M_repair_scores;
+		std::ranges::copy(M_repair_uses, state.repair_uses.begin());
+
+		state.generator = M_gen.state();
+
+		state.current.clear();
+		write_routes(M_current, state.current);
+		state.best.clear();
+		write_routes(M_best, state.best);
+	}
+	// continues from state, saved by a search with the same graph, fleet and parameters. the remembered solutions are
+	// not part of the state, so the search only continues exactly as it would have without a visited set
+	// throws std::runtime_error if state does not fit the search
+	void restore(const search_checkpoint &state)
+	{
+		if (state.empty())
+			throw std::runtime_error("Invalid generator state in checkpoint");
+
+		read_routes(M_current, state.current);
+		read_routes(M_best, state.best);
+		M_gen = xoshiro256(state.generator);
+		M_iteration = static_cast<std::size_t>(state.iteration);
+		M_temperature = state.temperature;
+		M_current_objective = state.current_objective;
+		M_best_objective = state.best_objective;
+		M_destroy_weights = state.destroy_weights;
+		M_destroy_scores = state.destroy_scores;
+		std::ranges::copy(state.destroy_uses, M_destroy_uses.begin());
+		M_repair_weights = state.repair_weights;
+		M_repair_scores = state.repair_scores;
+		std::ranges::copy(state.repair_uses, M_repair_uses.begin());
+		M_visited->insert(M_current.hash());
+		publish();
+	}
+
+	// iterations run since the search was built, including the ones before the checkpoint it was restored from
+	std::size_t iteration() const { return M_iteration; }
+	double temperature() const { return M_temperature; }
+	const std::array<double, 4> &destroy_weights() const { return M_destroy_weights; }
+	const std::array<double, 3> &repair_weights() const { return M_repair_weights; }
+
+private:
+	// where a customer can be inserted and what it costs
+	struct insertion
+	{
+		vehicle_type type;
+		bool sortie; // served by the drone of a truck_drone route, index is then the truck stop the drone departs from
+		std::uint32_t route;
+		std::uint32_t index;
+		double delta;
+	};
+
+	struct candidate
+	{
+		double key;
+		std::uint32_t customer;
+	};
+
+	// a route customers are inserted into, or every drone at once since their trips are interchangeable
+	struct column
+	{
+		vehicle_type type;
+		std::uint32_t route; // unused for drones
+	};
+
+	static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+	const Graph *M_graph;
+	alns_parameters M_parameters;
+
+	basic_solution<Graph> M_current;
+	basic_solution<Graph> M_best;
+
+	xoshiro256 M_gen;
+
+	std::array<double, 4> M_destroy_weights, M_destroy_scores;
+	std::array<std::size_t, 4> M_destroy_uses;
+	std::array<double, 3> M_repair_weights, M_repair_scores;
+	std::array<std::size_t, 3> M_repair_uses;
+
+	double M_temperature;
+	double M_penalty;
+	double M_current_objective;
+	double M_best_objective;
+	std::size_t M_iteration;
+	shared_incumbent *M_incumbent = nullptr;
+
+	std::unique_ptr<search_indexes> M_own_indexes;
+	const search_indexes *M_indexes;
+
+	visited_set M_own_visited;
+	visited_set *M_visited; // hashes of the solutions accepted as current
+	std::size_t M_duplicates;
+
+	std::vector<std::uint32_t> M_removed; // customers not served by M_current
+	std::vector<std::uint32_t> M_pool; // scratch list of customers
+	std::vector<candidate> M_candidates;
+
+	// insertion tables of the greedy and regret repairs, M_table holds the best insertion of M_removed[i] into every
+	// column in row i, M_top the M_k cheapest of them in ascending order with their columns in M_top_columns
+	std::vector<column> M_columns;
+	std::size_t M_k;
+	std::vector<insertion> M_table;
+	std::vector<double> M_top;
+	std::vector<std::uint32_t> M_top_columns;
+	std::unique_ptr<work_stealing_pool> M_workers;
+	std::unique_ptr<basic_local_search<Graph>> M_local_search;
+
+	checkpoint_writer *M_checkpoint = nullptr;
+	std::size_t M_checkpoint_index = 0;
+	search_checkpoint M_snapshot; // swapped with the writer's buffers, so checkpoints reuse the storage of earlier ones
+	std::vector<std::uint32_t> M_published; // routes of the best solution, swapped with the incumbent's buffer
+
+	// offers the best solution to the incumbent, only encoding it if it beats the incumbent's objective
+	void publish()
+	{
+		if (!M_incumbent || M_best_objective >= M_incumbent->objective())
+			return;
+		M_published.clear();
+		write_routes(M_best, M_published);
+		M_incumbent->offer(M_best_objective, M_published);
+	}
+
+	double objective() const { return M_current.cost() + M_penalty * static_cast<double>(M_removed.size()); }
+
+	// the visited set of buffers if it has the capacity asked for, emptied, otherwise a new one
+	static visited_set take_visited(scratch *buffers, std::size_t capacity)
+	{
+		if (!buffers || buffers->visited.capacity() != visited_set::slots(capacity))
+			return visited_set(capacity);
+		visited_set res = std::move(buffers->visited);
+		res.clear();
+		return res;
+	}
+
+	// one destroy and repair, returns whether it found a new best solution
+	bool iterate()
+	{
+		std::size_t d = select(M_destroy_weights, M_parameters.destroy);
+		std::size_t r = select(M_repair_weights, M_parameters.repair);
+
+		M_current.begin_journal();
+		M_removed.clear();
+		for (std::size_t c = 1; c < M_graph->size(); ++c)
+			if (!M_current.routed(c))
+				M_removed.push_back(static_cast<std::uint32_t>(c));
+
+		destroy(static_cast<destroy_operator>(d));
+		repair(static_cast<repair_operator>(r));
+
+		// a candidate that was accepted before earns no score for being found again and only returns if it is better
+		// (Ropke & Pisinger), which spares the acceptance test of the revisits that dominate late in a run
+		double candidate = objective();
+		double score;
+		bool improved = false, keep = true;
+		if (candidate < M_best_objective - 1e-9)
+		{
+			score = M_parameters.scores[0];
+			improved = true;
+		}
+		else if (M_visited->contains(M_current.hash()))
+		{
+			++M_duplicates;
+			score = M_parameters.scores[3];
+			keep = candidate < M_current_objective - 1e-9;
+		}
+		else if (candidate < M_current_objective - 1e-9)
+			score = M_parameters.scores[1];
+		else if (accept(candidate))
+			score = M_parameters.scores[2];
+		else
+		{
+			score = M_parameters.scores[3];
+			keep = false;
+		}
+
+		if (keep)
+		{
+			M_visited->insert(M_current.hash());
+			M_current.commit();
+			if (improved && M_local_search) // intensifies around every new best, outside the journal
+			{
+				M_local_search->improve(M_current);
+				candidate = objective();
+				M_visited->insert(M_current.hash());
+			}
+			M_current_objective = candidate;
+			if (improved)
+			{
+				M_best = M_current;
+				M_best_objective = candidate;
+				publish();
+			}
+		}
+		else
+			M_current.rollback();
+
+		M_destroy_scores[d] += score;
+		++M_destroy_uses[d];
+		M_repair_scores[r] += score;
+		++M_repair_uses[r];
+
+		M_temperature *= M_parameters.cooling;
+		++M_iteration;
+		if (M_iteration % M_parameters.segment_length == 0)
+			update_weights();
+		if (M_iteration % M_parameters.compact_interval == 0)
+			M_current.compact();
+		return improved;
+	}
+
+	// simulated annealing, a worse candidate is accepted with probability exp(-(candidate - current) / temperature)
+	bool accept(double candidate)
+	{
+		if (M_temperature <= 0)
+			return false;
+		return std::uniform_real_distribution<double>(0, 1)(M_gen) < std::exp((M_current_objective - candidate) / M_temperature);
+	}
+
+	// roulette wheel over the enabled operators
+	template <std::size_t count>
+	std::size_t select(const std::array<double, count> &weights, const std::array<bool, count> &enabled)
+	{
+		double total = 0;
+		for (std::size_t i = 0; i < count; ++i)
+			if (enabled[i])
+				total += weights[i];
+
+		double x = std::uniform_real_distribution<double>(0, total)(M_gen);
+		std::size_t last = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (!enabled[i])
+				continue;
+			last = i;
+			x -= weights[i];
+			if (x <= 0)
+				return i;
+		}
+		return last;
+	}
+
+	// at the end of a segment every used operator moves towards its average score
+	void update_weights()
+	{
+		auto update = [&](auto &weights, auto &scores, auto &uses)
+		{
+			for (std::size_t i = 0; i < weights.size(); ++i)
+			{
+				if (uses[i])
+					weights[i] = weights[i] * (1 - M_parameters.reaction_factor) + M_parameters.reaction_factor * scores[i] / static_cast<double>(uses[i]);
+				scores[i] = 0;
+				uses[i] = 0;
+			}
+		};
+		update(M_destroy_weights, M_destroy_scores, M_destroy_uses);
+		update(M_repair_weights, M_repair_scores, M_repair_uses);
+	}
+
+	// index into a list of size candidates sorted best first, biased towards the front by the determinism parameter
+	std::size_t biased_index(std::size_t size)
+	{
+		double y = std::uniform_real_distribution<double>(0, 1)(M_gen);
+		return std::min(size - 1, static_cast<std::size_t>(std::pow(y, M_parameters.determinism) * static_cast<double>(size)));
+	}
+
+	// M_pool = every routed customer
+	void collect_routed()
+	{
+		M_pool.clear();
+		for (std::size_t c = 1; c < M_graph->size(); ++c)
+			if (M_current.routed(c))
+				M_pool.push_back(static_cast<std::uint32_t>(c));
+	}
+
+	// removes customer and the sorties its truck stop launches or recovers
+	void remove(std::size_t customer)
+	{
+		const customer_location &loc = M_current.location(customer);
+		if (loc.type == vehicle_type::truck_drone && !loc.sortie)
+		{
+			std::size_t route = loc.route;
+			const auto &r = M_current.template route<vehicle_type::truck_drone>(route);
+			for (std::size_t k = r.size_rendevous(); k-- > 0;)
+			{
+				const drone_node &node = r.rendevous(k);
+				if (node.departure == customer || node.reunion == customer)
+				{
+					M_removed.push_back(node.service);
+					M_current.template remove_rendevous<vehicle_type::truck_drone>(route, k);
+				}
+			}
+		}
+		M_current.remove_customer(customer);
+		M_removed.push_back(static_cast<std::uint32_t>(customer));
+	}
+
+	// cost saved by removing customer, ignoring the sorties a truck stop carries
+	double removal_saving(std::size_t customer) const
+	{
+		const customer_location &loc = M_current.location(customer);
+		double res = 0;
+		basic_solution<Graph>::for_each_type([&](auto type)
+		{
+			if (type != loc.type)
+				return;
+			const auto &r = M_current.template route<type>(loc.route);
+			if constexpr (type == vehicle_type::truck_drone)
+			{
+				if (loc.sortie)
+				{
+					const drone_node &node = r.rendevous(loc.index);
+					res = M_graph->drone_distance(node.departure, node.service) + M_graph->drone_distance(node.service, node.reunion);
+					return;
+				}
+			}
+			res = -r.removal_delta(loc.index);
+		});
+		return res;
+	}
+
+	void destroy(destroy_operator op)
+	{
+		std::size_t routed = M_graph->size() - 1 - M_removed.size();
+		if (routed == 0)
+			return;
+		std::size_t goal = M_removed.size() + std::clamp<std::size_t>(static_cast<std::size_t>(std::ceil(M_parameters.degree_of_destruction * routed)), 1, routed);
+
+		switch (op)
+		{
+		case destroy_operator::random: random_removal(goal); break;
+		case destroy_operator::related: related_removal(goal); break;
+		case destroy_operator::worst: worst_removal(goal); break;
+		case destroy_operator::cluster: cluster_removal(goal); break;
+		}
+	}
+
+	void random_removal(std::size_t goal)
+	{
+		collect_routed();
+		for (std::size_t i = 0; i < M_pool.size() && M_removed.size() < goal; ++i)
+		{
+			std::swap(M_pool[i], M_pool[std::uniform_int_distribution<std::size_t>(i, M_pool.size() - 1)(M_gen)]);
+			if (M_current.routed(M_pool[i])) // may have gone with the truck stop of its sortie
+				remove(M_pool[i]);
+		}
+	}
+
+	// Shaw removal with distance as relatedness
+	// a routed customer drawn uniformly, there must be one
+	std::size_t random_routed()
+	{
+		std::uniform_int_distribution<std::size_t> customer(1, M_graph->size() - 1);
+		for (std::size_t tries = 0; tries < 32; ++tries)
+			if (std::size_t c = customer(M_gen); M_current.routed(c))
+				return c;
+		collect_routed();
+		return M_pool[std::uniform_int_distribution<std::size_t>(0, M_pool.size() - 1)(M_gen)];
+	}
+
+	// Shaw removal, draws from the relatedness list of a removed customer so a removal costs O(related_k)
+	void related_removal(std::size_t goal)
+	{
+		std::size_t first = M_removed.size();
+		remove(random_routed());
+
+		while (M_removed.size() < goal)
+		{
+			std::size_t seed = M_removed[std::uniform_int_distribution<std::size_t>(first, M_removed.size() - 1)(M_gen)];
+			M_candidates.clear();
+			for (std::uint32_t c : M_indexes->related.related(seed))
+				if (M_current.routed(c))
+					M_candidates.push_back({0, c});
+
+			// the list is sorted by relatedness already, a seed whose whole list is removed restarts somewhere random
+			if (M_candidates.empty())
+				remove(random_routed());
+			else
+				remove(M_candidates[biased_index(M_candidates.size())].customer);
+		}
+	}
+
+	void worst_removal(std::size_t goal)
+	{
+		collect_routed();
+		while (M_removed.size() < goal)
+		{
+			M_candidates.clear();
+			for (std::uint32_t c : M_pool)
+				if (M_current.routed(c))
+					M_candidates.push_back({-removal_saving(c), c});
+			if (M_candidates.empty())
+				return;
+			remove(pick(M_candidates));
+		}
+	}
+
+	// removes whole clusters, each time either the spatial cluster of a random customer across every route or, with even
+	// odds, the side of the customer's truck leg when the leg is split in two. costs the size of the clusters removed
+	void cluster_removal(std::size_t goal)
+	{
+		while (M_removed.size() < goal)
+		{
+			std::size_t seed = random_routed();
+			const customer_location &loc = M_current.location(seed);
+			if (loc.type == vehicle_type::drone || loc.sortie || std::uniform_int_distribution<int>(0, 1)(M_gen))
+			{
+				for (std::uint32_t c : M_indexes->clusters.members(M_indexes->clusters.cluster_of(seed)))
+					if (M_removed.size() < goal && M_current.routed(c))
+						remove(c);
+				continue;
+			}
+
+			M_pool.clear();
+			basic_solution<Graph>::for_each_type([&](auto type)
+			{
+				if constexpr (type != vehicle_type::drone)
+				{
+					if (type != loc.type)
+						return;
+					const auto &r = M_current.template route<type>(loc.route);
+					for (std::size_t k = 1; k < r.size(); ++k)
+					{
+						if constexpr (type == vehicle_type::truck_drone)
+							M_pool.push_back(static_cast<std::uint32_t>(r.truck_stop(k)));
+						else
+							M_pool.push_back(static_cast<std::uint32_t>(r[k]));
+					}
+				}
+			});
+
+			std::size_t side = split_in_two(std::span(M_pool), loc.index - 1, [&](std::size_t a, std::size_t b) { return M_graph->van_distance(a, b); });
+			for (std::size_t i = 0; i < side && M_removed.size() < goal; ++i)
+				if (M_current.routed(M_pool[i]))
+					remove(M_pool[i]);
+		}
+	}
+
+	// customer at the biased position of candidates sorted by ascending key
+	std::uint32_t pick(std::vector<candidate> &candidates)
+	{
+		std::size_t index = biased_index(candidates.size());
+		std::ranges::nth_element(candidates, candidates.begin() + index, {}, &candidate::key);
+		return candidates[index].customer;
+	}
+
+	// best feasible insertion of customer into col, delta is infinity if there is none
+	// only reads the solution, so different customers can be evaluated concurrently
+	insertion evaluate(std::size_t customer, const column &col) const
+	{
+		insertion res{col.type, false, col.route, 0, infinity};
+		double demand = M_graph->customers().node(customer).demand();
+		basic_solution<Graph>::for_each_type([&](auto type)
+		{
+			if (type != col.type)
+				return;
+			const vehicle &limits = M_current.template limits<type>();
+			if constexpr (type == vehicle_type::drone)
+			{
+				double delta = 2 * M_graph->drone_distance(0, customer);
+				if (demand <= limits.capacity && delta <= limits.max_range)
+					res.delta = delta;
+			}
+			else
+			{
+				const auto &route = M_current.template route<type>(col.route);
+				if (auto ins = route.best_feasible_insertion(customer, limits))
+				{
+					res.index = static_cast<std::uint32_t>(ins->index);
+					res.delta = ins->delta;
+				}
+
+				if constexpr (type == vehicle_type::truck_drone)
+				{
+					const vehicle &drone = M_current.template limits<vehicle_type::drone>();
+					if (demand <= drone.capacity && route.fits(customer, limits))
+						best_sortie(route, customer, drone, res);
+				}
+			}
+		});
+		return res;
+	}
+
+	// cheapest feasible insertion of customer over every column
+	insertion cheapest(std::size_t customer) const
+	{
+		insertion best{vehicle_type::base, false, 0, 0, infinity};
+		for (const column &col : M_columns)
+		{
+			insertion ins = evaluate(customer, col);
+			if (ins.delta < best.delta)
+				best = ins;
+		}
+		return best;
+	}
+
+	// cheapest sortie serving customer between two consecutive truck stops whose leg the drone is not flying over yet
+	// a feasible sortie departs from a stop in the sortie table of customer, so only those are looked up, nearest first,
+	// until even the shortest sortie through the next one could not beat best
+	template <typename Route>
+	void best_sortie(const Route &route, std::size_t customer, const vehicle &drone, insertion &best) const
+	{
+		double reach = M_indexes->sorties.reach(customer);
+		for (const sortie_candidate &stop : M_indexes->sorties.candidates(customer))
+		{
+			if (stop.distance + reach >= best.delta)
+				break;
+			const customer_location &loc = M_current.location(stop.customer);
+			if (loc.type != vehicle_type::truck_drone || loc.sortie || loc.route != best.route || loc.index + 1 >= route.size())
+				continue;
+
+			double length = route.rendevous_delta(stop.customer, customer, route.truck_stop(loc.index + 1));
+			if (length <= drone.max_range && length < best.delta && !loc.flying)
+				best = {vehicle_type::truck_drone, true, best.route, loc.index, length};
+		}
+	}
+
+	void apply(const insertion &ins, std::size_t customer)
+	{
+		basic_solution<Graph>::for_each_type([&](auto type)
+		{
+			if (type != ins.type)
+				return;
+			if constexpr (type == vehicle_type::drone)
+			{
+				// the least used drone, the cost is the same for all of them
+				auto routes = M_current.template routes<type>();
+				std::size_t r = 0;
+				for (std::size_t i = 1; i < routes.size(); ++i)
+					if (routes[i].size() < routes[r].size())
+						r = i;
+				M_current.template insert<type>(r, customer);
+			}
+			else
+			{
+				if constexpr (type == vehicle_type::truck_drone)
+				{
+					if (ins.sortie)
+					{
+						const auto &r = M_current.template route<type>(ins.route);
+						M_current.insert_rendevous(ins.route, r.truck_stop(ins.index), customer, r.truck_stop(ins.index + 1));
+						return;
+					}
+				}
+				M_current.template insert<type>(ins.route, ins.index, customer);
+			}
+		});
+	}
+
+	// inserts the customers of M_removed, the ones no route can take stay in it
+	void repair(repair_operator op)
+	{
+		if (op != repair_operator::cheapest)
+		{
+			table_repair(op);
+			return;
+		}
+
+		std::ranges::shuffle(M_removed, M_gen);
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < M_removed.size(); ++i)
+		{
+			insertion best = cheapest(M_removed[i]);
+			if (best.delta < infinity)
+				apply(best, M_removed[i]);
+			else
+				M_removed[kept++] = M_removed[i];
+		}
+		M_removed.resize(kept);
+	}
+
+	// calls fn(i) for every i in [0, count), on the repair threads when there is enough work
+	template <typename Fn>
+	void for_each_slot(std::size_t count, Fn &&fn)
+	{
+		if (M_workers && count >= M_parameters.parallel_threshold)
+			M_workers->run(count, fn);
+		else
+			for (std::size_t i = 0; i < count; ++i)
+				fn(i);
+	}
+
+	// recomputes the M_k cheapest columns of row slot
+	void rank(std::size_t slot)
+	{
+		double *top = M_top.data() + slot * M_k;
+		std::uint32_t *top_columns = M_top_columns.data() + slot * M_k;
+		std::fill_n(top, M_k, infinity);
+		std::fill_n(top_columns, M_k, 0);
+
+		const insertion *row = M_table.data() + slot * M_columns.size();
+		for (std::size_t c = 0; c < M_columns.size(); ++c)
+		{
+			if (!(row[c].delta < top[M_k - 1]))
+				continue;
+			std::size_t j = M_k - 1;
+			for (; j > 0 && row[c].delta < top[j - 1]; --j)
+			{
+				top[j] = top[j - 1];
+				top_columns[j] = top_columns[j - 1];
+			}
+			top[j] = row[c].delta;
+			top_columns[j] = static_cast<std::uint32_t>(c);
+		}
+	}
+
+	// re-evaluates column c of row slot after an insertion into it, ranking the row again only if its top changes
+	void refresh(std::size_t slot, std::size_t c)
+	{
+		insertion &cell = M_table[slot * M_columns.size() + c];
+		cell = evaluate(M_removed[slot], M_columns[c]);
+
+		const double *top = M_top.data() + slot * M_k;
+		const std::uint32_t *top_columns = M_top_columns.data() + slot * M_k;
+		bool ranked = false;
+		for (std::size_t j = 0; j < M_k; ++j)
+			ranked |= top[j] < infinity && top_columns[j] == c;
+		if (ranked || cell.delta < top[M_k - 1])
+			rank(slot);
+	}
+
+	// whether row a should be inserted before row b, the result does not depend on the order of the rows
+	bool before(repair_operator op, std::size_t a, std::size_t b) const
+	{
+		const double *x = M_top.data() + a * M_k;
+		const double *y = M_top.data() + b * M_k;
+		if (op == repair_operator::regret)
+		{
+			// customers with fewer than k feasible routes first, they are about to lose their last options
+			auto options = [&](const double *top) { return std::ranges::count_if(top, top + M_k, [](double d) { return d < infinity; }); };
+			auto regret = [&](const double *top)
+			{
+				double res = 0;
+				for (std::size_t j = 1; j < M_k && top[j] < infinity; ++j)
+					res += top[j] - top[0];
+				return res;
+			};
+
+			auto ox = options(x), oy = options(y);
+			if (ox != oy)
+				return ox < oy;
+			double rx = regret(x), ry = regret(y);
+			if (rx != ry)
+				return rx > ry;
+		}
+		if (x[0] != y[0])
+			return x[0] < y[0];
+		return M_removed[a] < M_removed[b];
+	}
+
+	// greedy and regret insert one customer at a time, chosen over every remaining customer
+	// the insertion of every customer into every column is cached, after an insertion only the column of the route
+	// that changed is evaluated again
+	void table_repair(repair_operator op)
+	{
+		std::size_t columns = M_columns.size();
+		if (M_removed.empty() || columns == 0)
+			return;
+
+		for_each_slot(M_removed.size(), [&](std::size_t slot)
+		{
+			for (std::size_t c = 0; c < columns; ++c)
+				M_table[slot * columns + c] = evaluate(M_removed[slot], M_columns[c]);
+			rank(slot);
+		});
+
+		while (!M_removed.empty())
+		{
+			std::size_t chosen = M_removed.size();
+			for (std::size_t slot = 0; slot < M_removed.size(); ++slot)
+				if (M_top[slot * M_k] < infinity && (chosen == M_removed.size() || before(op, slot, chosen)))
+					chosen = slot;
+			if (chosen == M_removed.size())
+				return;
+
+			std::size_t c = M_top_columns[chosen * M_k];
+			apply(M_table[chosen * columns + c], M_removed[chosen]);
+
+			// the last row takes the place of the inserted customer
+			std::size_t last = M_removed.size() - 1;
+			if (chosen != last)
+			{
+				M_removed[chosen] = M_removed[last];
+				std::copy_n(M_table.begin() + last * columns, columns, M_table.begin() + chosen * columns);
+				std::copy_n(M_top.begin() + last * M_k, M_k, M_top.begin() + chosen * M_k);
+				std::copy_n(M_top_columns.begin() + last * M_k, M_k, M_top_columns.begin() + chosen * M_k);
+			}
+			M_removed.pop_back();
+
+			// inserting into a drone changes no drone insertion
+			if (M_columns[c].type != vehicle_type::drone)
+				for_each_slot(M_removed.size(), [&](std::size_t slot) { refresh(slot, c); });
+		}
+	}
+};
+
+template <graph_backend Graph>
+struct basic_alns<Graph>::scratch
+{
+	visited_set visited;
+	std::vector<std::uint32_t> removed, pool;
+	std::vector<candidate> candidates;
+	std::vector<insertion> table;
+	std::vector<double> top;
+	std::vector<std::uint32_t> top_columns;
+
+	std::size_t memory_usage() const
+	{
+		return visited.memory_usage() + (removed.capacity() + pool.capacity() + top_columns.capacity()) * sizeof(std::uint32_t) +
+			candidates.capacity() * sizeof(candidate) + table.capacity() * sizeof(insertion) + top.capacity() * sizeof(double);
+	}
+};
+
+using alns = basic_alns<graph>;
+
+VRP_END
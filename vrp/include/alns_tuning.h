@@ -0,0 +1,60 @@
+#pragma once
+#include "alns.h"
+#include "race.h"
+
+#include <memory>
+#include <vector>
+
+VRP_BEG
+
+// the alns_parameters a race tunes, in the order of their values in a configuration and named like the command line
+// options of algorithm: the four scores, reaction factor, degree of destruction, start worse, determinism, then the
+// destroy toggles II, RD, WD, CD and the repair toggles CI, GR, RR
+std::vector<tuning::parameter> alns_space();
+// configuration of alns_space() holding the values of parameters
+tuning::configuration alns_configuration(const alns_parameters &parameters);
+// parameters with the values of configuration
+alns_parameters with_configuration(alns_parameters parameters, const tuning::configuration &configuration);
+// whether configuration enables a destroy and a repair operator, which basic_alns requires
+bool alns_allowed(const tuning::configuration &configuration);
+
+// instances ALNS runs are raced on. each is loaded once, and its graph and search indexes are shared by every run on
+// it, which may be concurrent
+class tuning_set
+{
+public:
+	// every run uses base with the values of its configuration and its seed, the iterations and time limit of base bound
+	// each run
+	explicit tuning_set(const alns_parameters &base) : M_base{base} {}
+
+	// builds the graph and search indexes of customers on thread_count threads (0 for all cores)
+	void add(customer_info customers, const fleet_info &fleet, std::size_t thread_count = 0);
+	std::size_t size() const { return M_entries.size(); }
+
+	// best objective of a run of configuration on instance
+	double evaluate(const tuning::configuration &configuration, std::size_t instance, std::uint64_t seed) const;
+	// evaluate for tuning::race, the set must outlive it
+	tuning::evaluator evaluator() const
+	{
+		return [this](const tuning::configuration &configuration, std::size_t instance, std::uint64_t seed) { return evaluate(configuration, instance, seed); };
+	}
+
+private:
+	struct entry
+	{
+		customer_info customers;
+		fleet_info fleet;
+		vrp::graph graph;
+		search_indexes indexes;
+
+		entry(customer_info &&customers, const fleet_info &fleet, const alns_parameters &parameters, std::size_t thread_count) :
+			customers{std::move(customers)}, fleet{fleet}, graph(this->customers), indexes(graph, this->fleet, parameters, thread_count)
+		{
+		}
+	};
+
+	alns_parameters M_base;
+	std::vector<std::unique_ptr<entry>> M_entries; // not moved, the graphs point at their customers
+};
+
+VRP_END
@@ -0,0 +1,158 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "macro.h"
+
+VRP_BEG
+
+// one contiguous buffer shared by many small growable arrays (see arena_vector)
+// arrays that outgrow their block move to the end of the buffer, clear() releases every block at once
+template <typename T>
+class arena
+{
+public:
+	struct block
+	{
+		std::uint32_t offset;
+		std::uint32_t capacity;
+	};
+
+	block allocate(std::size_t capacity)
+	{
+		block res{static_cast<std::uint32_t>(M_data.size()), static_cast<std::uint32_t>(capacity)};
+		M_data.resize(M_data.size() + capacity);
+		return res;
+	}
+
+	T *data() { return M_data.data(); }
+	const T *data() const { return M_data.data(); }
+
+	// every block is released, the buffer keeps its capacity
+	void clear() { M_data.clear(); }
+	void reserve(std::size_t elements) { M_data.reserve(elements); }
+
+	std::size_t size() const { return M_data.size(); }
+	std::size_t memory_usage() const { return M_data.capacity() * sizeof(T); }
+
+private:
+	std::vector<T> M_data;
+};
+
+// growable array whose elements live in a block of an arena, refers to it by offset so the arena may reallocate
+// copies are deep and allocate in the same arena, the (other, arena) constructor instead refers to the same block
+// of an arena that is a wholesale copy of other's
+template <typename T>
+class arena_vector
+{
+public:
+	using value_type = T;
+
+	arena_vector() : M_arena{}, M_block{}, M_size{} {}
+	explicit arena_vector(arena<T> &storage, std::size_t capacity = 0) : M_arena{&storage}, M_block{storage.allocate(capacity)}, M_size{} {}
+
+	arena_vector(const arena_vector &other) : M_arena{other.M_arena}, M_block{}, M_size{other.M_size}
+	{
+		if (M_arena)
+		{
+			M_block = M_arena->allocate(other.M_size);
+			std::copy_n(other.data(), M_size, data());
+		}
+	}
+	arena_vector(const arena_vector &other, arena<T> &copied_storage) : M_arena{&copied_storage}, M_block{other.M_block}, M_size{other.M_size} {}
+	arena_vector(arena_vector &&other) noexcept : M_arena{other.M_arena}, M_block{other.M_block}, M_size{other.M_size}
+	{
+		other.M_block = {};
+		other.M_size = 0;
+	}
+
+	arena_vector &operator=(const arena_vector &other)
+	{
+		if (this == &other)
+			return *this;
+		if (!M_arena)
+			M_arena = other.M_arena;
+		reserve(other.M_size);
+		std::copy_n(other.data(), other.M_size, data());
+		M_size = other.M_size;
+		return *this;
+	}
+	arena_vector &operator=(arena_vector &&other) noexcept
+	{
+		M_arena = other.M_arena;
+		M_block = other.M_block;
+		M_size = other.M_size;
+		other.M_block = {};
+		other.M_size = 0;
+		return *this;
+	}
+
+	std::size_t size() const { return M_size; }
+	std::size_t capacity() const { return M_block.capacity; }
+	bool empty() const { return M_size == 0; }
+
+	T *data() { return M_arena ? M_arena->data() + M_block.offset : nullptr; }
+	const T *data() const { return M_arena ? M_arena->data() + M_block.offset : nullptr; }
+
+	T &operator[](std::size_t index) { return data()[index]; }
+	const T &operator[](std::size_t index) const { return data()[index]; }
+	T &back() { return data()[M_size - 1]; }
+	const T &back() const { return data()[M_size - 1]; }
+
+	T *begin() { return data(); }
+	T *end() { return data() + M_size; }
+	const T *begin() const { return data(); }
+	const T *end() const { return data() + M_size; }
+
+	void reserve(std::size_t capacity)
+	{
+		if (capacity > M_block.capacity)
+			relocate(*M_arena, capacity);
+	}
+
+	void push_back(T value)
+	{
+		if (M_size == M_block.capacity)
+			grow();
+		data()[M_size++] = value;
+	}
+	void pop_back() { --M_size; }
+
+	void insert(std::size_t index, T value)
+	{
+		if (M_size == M_block.capacity)
+			grow();
+		T *elements = data();
+		std::copy_backward(elements + index, elements + M_size, elements + M_size + 1);
+		elements[index] = value;
+		++M_size;
+	}
+	void erase(std::size_t index)
+	{
+		T *elements = data();
+		std::copy(elements + index + 1, elements + M_size, elements + index);
+		--M_size;
+	}
+
+	void clear() { M_size = 0; }
+
+	// moves the elements into a new block of target, which may be another arena
+	void relocate(arena<T> &target, std::size_t capacity)
+	{
+		auto block = target.allocate(std::max<std::size_t>(capacity, M_size));
+		if (M_size) // allocating may have moved the source if it is the same arena
+			std::copy_n(M_arena->data() + M_block.offset, M_size, target.data() + block.offset);
+		M_arena = &target;
+		M_block = block;
+	}
+
+private:
+	arena<T> *M_arena;
+	typename arena<T>::block M_block;
+	std::uint32_t M_size;
+
+	void grow() { reserve(std::max<std::size_t>(8, 2 * static_cast<std::size_t>(M_block.capacity))); }
+};
+
+VRP_END
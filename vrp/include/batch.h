@@ -0,0 +1,48 @@
+#pragma once
+#include "alns.h"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+VRP_BEG
+
+// one instance of a batch and the wall clock seconds its search may take, 0 for no limit but the iterations
+struct batch_job
+{
+	std::filesystem::path instance;
+	double time_limit = 0;
+};
+
+// manifest of a batch, one job per line: an instance file and optionally its time limit in seconds, default_time_limit
+// if it has none. # starts a comment, relative instance paths are relative to the manifest's directory
+// throws std::runtime_error naming the file and line of the first error
+std::vector<batch_job> read_manifest(const std::filesystem::path &path, double default_time_limit);
+// the same as read_manifest on text, relative paths are relative to directory and source names the text in errors
+std::vector<batch_job> parse_manifest(std::string_view text, const std::filesystem::path &directory, double default_time_limit, std::string_view source = "<memory>");
+
+// indices of jobs, longest first: by time limit, a job without one first, then by the size of the instance file
+std::vector<std::size_t> longest_first(const std::vector<batch_job> &jobs);
+
+struct batch_result
+{
+	std::size_t job = 0; // index in the manifest
+	std::string name{};
+	std::size_t customers = 0;
+	double cost = 0;
+	std::size_t unrouted = 0;
+	alns_statistics statistics{};
+	std::string error{}; // why the job failed, empty if it did not
+};
+
+// solves every job with one search each on a pool of thread_count threads (0 for one per core) that take the jobs in
+// longest_first order, so the long jobs do not trail at the end. each thread keeps the buffers of its last search for
+// its next one. jobs use parameters with their time limit and a single repair thread, and the seed of job i is
+// derive_seed(parameters.seed, i), so results do not depend on the schedule. done is called with each result as soon
+// as its job ends, from the thread that ran it but never concurrently. if done throws, no job is started or reported
+// after it and the exception is thrown again from solve_batch once the running jobs end
+void solve_batch(const std::vector<batch_job> &jobs, const alns_parameters &parameters, std::size_t thread_count, const std::function<void(const batch_result &)> &done);
+
+VRP_END
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "macro.h"
+
+VRP_BEG
+
+// bounded multi producer multi consumer queue (Vyukov), neither side ever waits on the other
+// elements live in the queue and are written and read in place, so a queue of preallocated objects never allocates
+template <typename T>
+class bounded_queue
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit bounded_queue(std::size_t capacity) : M_cells(std::bit_ceil(std::max<std::size_t>(capacity, 2))), M_mask{M_cells.size() - 1}, M_tail{0}, M_head{0}
+	{
+		for (std::size_t i = 0; i < M_cells.size(); ++i)
+			M_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// calls write(T &) on a free element and publishes it, false without calling write if the queue is full
+	template <typename Fn>
+	bool try_push(Fn &&write)
+	{
+		cell *target;
+		std::size_t position = M_tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			target = &M_cells[position & M_mask];
+			std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+			auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+			if (difference == 0)
+			{
+				if (M_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = M_tail.load(std::memory_order_relaxed);
+		}
+
+		write(target->value);
+		target->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// calls read(T &) on the oldest published element and frees it, false without calling read if there is none
+	template <typename Fn>
+	bool try_pop(Fn &&read)
+	{
+		cell *source;
+		std::size_t position = M_head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			source = &M_cells[position & M_mask];
+			std::size_t sequence = source->sequence.load(std::memory_order_acquire);
+			auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+			if (difference == 0)
+			{
+				if (M_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = M_head.load(std::memory_order_relaxed);
+		}
+
+		read(source->value);
+		source->sequence.store(position + M_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t capacity() const { return M_cells.size(); }
+
+private:
+	struct alignas(64) cell
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	std::vector<cell> M_cells;
+	std::size_t M_mask;
+	alignas(64) std::atomic<std::size_t> M_tail; // producers and consumers on separate cache lines
+	alignas(64) std::atomic<std::size_t> M_head;
+};
+
+VRP_END
@@ -0,0 +1,178 @@
+#pragma once
+#include "solution.h"
+#include "random.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+VRP_BEG
+
+// state of one search, enough to continue it where it stopped
+struct search_checkpoint
+{
+	std::uint64_t iteration = 0;
+	double temperature = 0, current_objective = 0, best_objective = 0;
+	std::array<double, 4> destroy_weights{}, destroy_scores{};
+	std::array<std::uint64_t, 4> destroy_uses{};
+	std::array<double, 3> repair_weights{}, repair_scores{};
+	std::array<std::uint64_t, 3> repair_uses{};
+	xoshiro256::state_type generator{}; // state of the search's random generator, all zeros for a search that saved nothing
+	std::vector<std::uint32_t> current, best; // solutions, see write_routes
+
+	bool empty() const { return generator == xoshiro256::state_type{}; }
+	bool operator==(const search_checkpoint &) const = default;
+};
+
+// checkpoint of a run of several searches, on a graph of customers nodes (the depot included)
+struct run_checkpoint
+{
+	std::uint32_t customers = 0;
+	std::vector<search_checkpoint> searches;
+
+	bool operator==(const run_checkpoint &) const = default;
+};
+
+// appends the routes of solution to out, route by route in the order of the types: the number of stops and the stops
+// without the depot, then for truck_drone routes the number of sorties and their departure, service and reunion
+template <graph_backend Graph>
+void write_routes(const basic_solution<Graph> &solution, std::vector<std::uint32_t> &out)
+{
+	basic_solution<Graph>::for_each_type([&](auto type)
+	{
+		for (const auto &route : solution.template routes<type>())
+		{
+			if constexpr (type == vehicle_type::drone)
+			{
+				out.push_back(static_cast<std::uint32_t>(route.size()));
+				for (std::size_t i = 0; i < route.size(); ++i)
+					out.push_back(static_cast<std::uint32_t>(route[i]));
+			}
+			else
+			{
+				out.push_back(static_cast<std::uint32_t>(route.size() - 1));
+				for (std::size_t i = 1; i < route.size(); ++i)
+				{
+					if constexpr (type == vehicle_type::truck_drone)
+						out.push_back(static_cast<std::uint32_t>(route.truck_stop(i)));
+					else
+						out.push_back(static_cast<std::uint32_t>(route[i]));
+				}
+
+				if constexpr (type == vehicle_type::truck_drone)
+				{
+					out.push_back(static_cast<std::uint32_t>(route.size_rendevous()));
+					for (std::size_t k = 0; k < route.size_rendevous(); ++k)
+						out.insert(out.end(), {route.rendevous(k).departure, route.rendevous(k).service, route.rendevous(k).reunion});
+				}
+			}
+		}
+	});
+}
+
+// replaces the routes of solution by the ones write_routes wrote for a solution on the same graph and fleet
+// throws std::runtime_error if routes does not describe such a solution
+template <graph_backend Graph>
+void read_routes(basic_solution<Graph> &solution, std::span<const std::uint32_t> routes)
+{
+	std::size_t at = 0;
+	auto next = [&]()
+	{
+		if (at == routes.size())
+			throw std::runtime_error("Truncated routes");
+		return routes[at++];
+	};
+	auto next_customer = [&]()
+	{
+		std::uint32_t customer = next();
+		if (customer == 0 || customer >= solution.graph().size() || solution.routed(customer))
+			throw std::runtime_error("Invalid customer in routes");
+		return customer;
+	};
+
+	solution.clear();
+	basic_solution<Graph>::for_each_type([&](auto type)
+	{
+		for (std::size_t r = 0; r < solution.template route_count<type>(); ++r)
+		{
+			std::uint32_t stops = next();
+			if (stops > routes.size() - at)
+				throw std::runtime_error("Truncated routes");
+			for (std::size_t i = 0; i < stops; ++i)
+			{
+				if constexpr (type == vehicle_type::drone)
+					solution.template insert<type>(r, next_customer());
+				else
+					solution.template insert<type>(r, i + 1, next_customer());
+			}
+
+			if constexpr (type == vehicle_type::truck_drone)
+			{
+				std::uint32_t sorties = next();
+				for (std::size_t k = 0; k < sorties; ++k)
+				{
+					std::uint32_t departure = next(), service = next_customer(), reunion = next();
+					if (departure == 0 || reunion == 0 || departure >= solution.graph().size() || reunion >= solution.graph().size())
+						throw std::runtime_error("Invalid sortie in routes");
+					solution.insert_rendevous(r, departure, service, reunion);
+				}
+			}
+		}
+	});
+	if (at != routes.size())
+		throw std::runtime_error("Trailing data after routes");
+}
+
+// compact binary file in the byte order of the machine that wrote it: a magic number and version, the number of
+// customers and searches, then every search's scalars, generator words and routes as length prefixed arrays
+// written to a temporary file renamed over path, so a run killed while writing keeps its previous checkpoint
+void save_checkpoint(const std::filesystem::path &path, const run_checkpoint &checkpoint);
+// throws std::runtime_error if path cannot be read or is not a checkpoint
+run_checkpoint load_checkpoint(const std::filesystem::path &path);
+
+// writes the checkpoints of the searches of a run to one file on its own thread, so a search only pays for saving its
+// state into memory. submit and the writer only swap buffers under the lock, never copy or write while holding it.
+// states submitted while a write is in progress are coalesced into the next one
+class checkpoint_writer
+{
+public:
+	checkpoint_writer(std::filesystem::path path, std::size_t customers, std::size_t searches);
+	// writes what is still pending
+	~checkpoint_writer();
+
+	checkpoint_writer(const checkpoint_writer &) = delete;
+	checkpoint_writer &operator=(const checkpoint_writer &) = delete;
+
+	// state replaces the last state of search, and the file is rewritten with it soon. state is swapped with a buffer of
+	// the writer, so it comes back holding an older state whose storage the next save reuses
+	void submit(std::size_t search, search_checkpoint &state);
+	// waits until every state submitted so far is in the file, rethrows the error of a failed write
+	void flush();
+
+	// files written so far
+	std::size_t written() const;
+	const std::filesystem::path &path() const { return M_path; }
+
+private:
+	std::filesystem::path M_path;
+	run_checkpoint M_pending; // states submitted since the last write, where M_fresh is set
+	run_checkpoint M_writing; // latest state of every search, the file the writer thread saves, only touched by it
+	std::vector<char> M_fresh; // per search, whether M_pending holds a state newer than M_writing
+	mutable std::mutex M_mutex;
+	std::condition_variable M_changed, M_idle;
+	bool M_dirty, M_busy, M_stop;
+	std::size_t M_written;
+	std::exception_ptr M_error;
+	std::jthread M_thread; // last, so it starts once the rest is built
+
+	void write_loop();
+};
+
+VRP_END
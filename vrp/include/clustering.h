@@ -0,0 +1,171 @@
+#pragma once
+#include <span>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <cmath>
+
+#include "info.h"
+#include "parallel.h"
+#include "spatial.h"
+
+VRP_BEG
+
+// k-means clusters of the customer positions (depot excluded), computed once
+// members of a cluster are contiguous in one flat array, so a cluster is read in time proportional to its size
+// the centers are seeded from a sweep of a spatial grid over the customers and every customer finds its nearest center
+// through a grid over the centers, so a Lloyd step takes about linear time however many clusters there are
+class customer_clusters
+{
+public:
+	customer_clusters() : M_count{} {}
+	// about cluster_size customers per cluster, refined by at most iterations Lloyd steps whose assignments run on
+	// thread_count threads (0 for all cores)
+	customer_clusters(const customer_info &customers, std::size_t cluster_size, std::size_t thread_count = 0, std::size_t iterations = 20)
+	{
+		position_view positions = customers.positions();
+		std::size_t n = positions.size;
+		std::size_t points = n > 1 ? n - 1 : 0;
+		cluster_size = std::max<std::size_t>(cluster_size, 1);
+		M_count = points ? std::clamp<std::size_t>((points + cluster_size - 1) / cluster_size, 1, points) : 0;
+		M_cluster_of.assign(n, 0);
+		M_offsets.assign(M_count + 1, 0);
+		M_members.resize(points);
+		M_x.assign(M_count, 0);
+		M_y.assign(M_count, 0);
+		if (!points)
+			return;
+
+		// seeds, the centroids of runs of cluster_size customers along a boustrophedon sweep of a grid with about
+		// cluster_size customers per cell, so every seed starts among customers near each other
+		{
+			spatial_grid grid(positions, cluster_size);
+			std::vector<std::size_t> sizes(M_count);
+			std::size_t at = 0;
+			for (std::size_t y = 0; y < grid.cells_y(); ++y)
+			{
+				for (std::size_t column = 0; column < grid.cells_x(); ++column)
+				{
+					std::size_t x = y % 2 ? grid.cells_x() - 1 - column : column;
+					for (std::uint32_t i : grid.cell_points(x, y))
+					{
+						if (i == 0)
+							continue;
+						std::size_t c = at++ * M_count / points;
+						M_x[c] += positions.x[i];
+						M_y[c] += positions.y[i];
+						++sizes[c];
+					}
+				}
+			}
+			for (std::size_t c = 0; c < M_count; ++c)
+			{
+				M_x[c] /= static_cast<double>(sizes[c]);
+				M_y[c] /= static_cast<double>(sizes[c]);
+			}
+		}
+
+		// Lloyd, until no customer changes cluster
+		std::vector<double> sum_x(M_count), sum_y(M_count);
+		std::vector<std::size_t> sizes(M_count);
+		for (std::size_t step = 0; step < iterations; ++step)
+		{
+			spatial_grid centers(position_view{M_x.data(), M_y.data(), M_count});
+			std::atomic<bool> changed{step == 0};
+			parallel_for(1, n, [&](std::size_t i)
+			{
+				std::uint32_t best = 0;
+				centers.nearest_to<distance_type::euclidean>(vec2{positions.x[i], positions.y[i]}, 1, &best);
+				if (best != M_cluster_of[i])
+				{
+					M_cluster_of[i] = best;
+					changed.store(true, std::memory_order_relaxed);
+				}
+			}, thread_count, 256);
+			if (!changed.load(std::memory_order_relaxed))
+				break;
+
+			std::ranges::fill(sum_x, 0);
+			std::ranges::fill(sum_y, 0);
+			std::ranges::fill(sizes, 0);
+			for (std::size_t i = 1; i < n; ++i)
+			{
+				sum_x[M_cluster_of[i]] += positions.x[i];
+				sum_y[M_cluster_of[i]] += positions.y[i];
+				++sizes[M_cluster_of[i]];
+			}
+			for (std::size_t c = 0; c < M_count; ++c)
+			{
+				if (sizes[c]) // an empty cluster keeps its center
+				{
+					M_x[c] = sum_x[c] / static_cast<double>(sizes[c]);
+					M_y[c] = sum_y[c] / static_cast<double>(sizes[c]);
+				}
+			}
+		}
+
+		// counting sort of the customers by cluster
+		for (std::size_t i = 1; i < n; ++i)
+			++M_offsets[M_cluster_of[i] + 1];
+		for (std::size_t c = 1; c <= M_count; ++c)
+			M_offsets[c] += M_offsets[c - 1];
+		std::vector<std::uint32_t> fill(M_offsets.begin(), M_offsets.end() - 1);
+		for (std::size_t i = 1; i < n; ++i)
+			M_members[fill[M_cluster_of[i]]++] = static_cast<std::uint32_t>(i);
+	}
+
+	std::size_t count() const { return M_count; }
+	std::size_t cluster_of(std::size_t customer) const { return M_cluster_of[customer]; }
+	std::span<const std::uint32_t> members(std::size_t cluster) const { return {M_members.data() + M_offsets[cluster], M_members.data() + M_offsets[cluster + 1]}; }
+	vec2 center(std::size_t cluster) const { return {M_x[cluster], M_y[cluster]}; }
+
+	std::size_t memory_usage() const
+	{
+		return (M_cluster_of.size() + M_offsets.size() + M_members.size()) * sizeof(std::uint32_t) + (M_x.size() + M_y.size()) * sizeof(double);
+	}
+
+private:
+	std::size_t M_count;
+	std::vector<std::uint32_t> M_cluster_of; // indexed by customer, the depot is in cluster 0 but not among its members
+	std::vector<std::uint32_t> M_offsets;
+	std::vector<std::uint32_t> M_members;
+	std::vector<double> M_x, M_y; // centers
+};
+
+// splits points in two around two far apart poles, the first found as the point farthest from points[seed] and the
+// second as the point farthest from the first. moves the side of points[seed] to the front and returns its size
+// three linear passes, for splitting one route at a time
+template <typename Distance>
+std::size_t split_in_two(std::span<std::uint32_t> points, std::size_t seed, Distance &&distance)
+{
+	if (points.size() < 2)
+		return points.size();
+
+	auto farthest = [&](std::uint32_t from)
+	{
+		std::uint32_t res = from;
+		double best = -1;
+		for (std::uint32_t p : points)
+		{
+			double d = distance(from, p);
+			if (d > best)
+			{
+				best = d;
+				res = p;
+			}
+		}
+		return res;
+	};
+
+	std::uint32_t origin = points[seed];
+	std::uint32_t a = farthest(origin);
+	std::uint32_t b = farthest(a);
+	auto near_b = [&](std::uint32_t p) { return distance(p, b) <= distance(p, a); };
+	bool seed_near_b = near_b(origin);
+
+	auto middle = std::partition(points.begin(), points.end(), [&](std::uint32_t p) { return near_b(p) == seed_near_b; });
+	return static_cast<std::size_t>(middle - points.begin());
+}
+
+VRP_END
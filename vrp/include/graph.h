@@ -1,22 +1,109 @@
 #pragma once
 #include "info.h"
+#include "spatial.h"
+#include "arena.h"
 #include <optional>
+#include <concepts>
+#include <cstdint>
 
 VRP_BEG
 
-class graph
+// Matrix is the storage used for both distance matrices, see matrix, symmetric_matrix and compact_symmetric_matrix
+template <typename Matrix>
+class basic_graph
 {
 public:
-	constexpr graph() : M_manhattan{}, M_euclidean{}, M_customers{} {}
-	constexpr graph(const customer_info &customers) :
-		M_manhattan{customers.distance_matrix<distance_type::manhattan>()},
-		M_euclidean{customers.distance_matrix<distance_type::euclidean>()},
+	using matrix_type = Matrix;
+
+	constexpr basic_graph() : M_manhattan{}, M_euclidean{}, M_customers{} {}
+	// the distance matrices are built by thread_count threads (0 for all cores)
+	basic_graph(const customer_info &customers, std::size_t thread_count = 0) :
+		M_manhattan{customers.distance_matrix<distance_type::manhattan, Matrix>(thread_count)},
+		M_euclidean{customers.distance_matrix<distance_type::euclidean, Matrix>(thread_count)},
 		M_customers{&customers}
 	{
 	}
 
-	matrix::value_type drone_distance(std::size_t a, std::size_t b) const { return M_euclidean[a][b]; }
-	matrix::value_type van_distance(std::size_t a, std::size_t b) const { return M_manhattan[a][b]; }
+	double drone_distance(std::size_t a, std::size_t b) const { return M_euclidean(a, b); }
+	double van_distance(std::size_t a, std::size_t b) const { return M_manhattan(a, b); }
+
+	const customer_info &customers() const
+	{
+		#ifdef DO_CHECKING
+		if (!M_customers)
+			throw std::logic_error("Graph has no customers");
+		#endif
+		return *M_customers;
+	}
+	std::size_t size() const
+	{
+		#ifdef DO_CHECKING
+		if (!M_customers)
+			throw std::logic_error("Graph has no customers");
+		#endif
+		return M_customers->size();
+	}
+
+	// bytes held by the distance matrices and neighbor lists
+	std::size_t memory_usage() const { return M_manhattan.memory_usage() + M_euclidean.memory_usage() + M_neighbors.memory_usage(); }
+
+	const Matrix &van_matrix() const { return M_manhattan; }
+	const Matrix &drone_matrix() const { return M_euclidean; }
+
+	// sorted k nearest neighbors of customer by each metric, empty until build_neighbors is called
+	std::span<const std::uint32_t> van_neighbors(std::size_t customer) const { return M_neighbors.van(customer); }
+	std::span<const std::uint32_t> drone_neighbors(std::size_t customer) const { return M_neighbors.drone(customer); }
+	const neighbor_lists &neighbors() const { return M_neighbors; }
+
+	// builds the neighbor lists of every customer, the depot included, using thread_count threads (0 for all cores)
+	void build_neighbors(std::size_t k, std::size_t thread_count = 0) { M_neighbors = neighbor_lists(customers(), k, thread_count); }
+private:
+	Matrix M_manhattan, M_euclidean;
+	const customer_info *M_customers;
+	neighbor_lists M_neighbors;
+};
+
+using graph = basic_graph<matrix>;
+using packed_graph = basic_graph<symmetric_matrix>; // half the memory of graph
+using compact_graph = basic_graph<compact_symmetric_matrix>; // a quarter of the memory of graph, distances are stored as float
+
+// computes distances on demand from the customer positions instead of materializing O(n^2) matrices
+// optionally keeps a bounded cache of recently used tile_size x tile_size blocks of distances
+// lookups modify the cache, so a caching lazy_graph must not be shared between threads
+class lazy_graph
+{
+public:
+	static constexpr std::size_t tile_size = 32;
+	static constexpr std::size_t tile_ways = 4; // tiles per cache set, the least recently used one is evicted
+
+	lazy_graph() : M_customers{}, M_positions{}, M_tiles_per_row{}, M_sets{}, M_clock{} {}
+	// cached_tiles is the maximum number of tiles kept, 0 disables the cache
+	lazy_graph(const customer_info &customers, std::size_t cached_tiles = 0) :
+		M_customers{&customers}, M_positions{customers.positions()},
+		M_tiles_per_row{(customers.size() + tile_size - 1) / tile_size},
+		M_sets{(cached_tiles + tile_ways - 1) / tile_ways}, M_clock{}
+	{
+		M_keys.assign(M_sets * tile_ways, empty_key);
+		M_stamps.assign(M_sets * tile_ways, 0);
+		M_tiles.resize(M_sets * tile_ways * tile_elements);
+	}
+
+	double drone_distance(std::size_t a, std::size_t b) const
+	{
+		if (a == b)
+			return 0;
+		if (M_sets)
+			return lookup(a, b)[tile_size * tile_size];
+		return distance<distance_type::euclidean>(pos(a), pos(b));
+	}
+	double van_distance(std::size_t a, std::size_t b) const
+	{
+		if (a == b)
+			return 0;
+		if (M_sets)
+			return *lookup(a, b);
+		return distance<distance_type::manhattan>(pos(a), pos(b));
+	}
 
 	const customer_info &customers() const
 	{
@@ -34,38 +121,193 @@ public:
 		#endif
 		return M_customers->size();
 	}
+
+	// bytes held by the tile cache and neighbor lists
+	std::size_t memory_usage() const { return M_tiles.size() * sizeof(double) + M_keys.size() * 2 * sizeof(std::uint64_t) + M_neighbors.memory_usage(); }
+
+	// sorted k nearest neighbors of customer by each metric, empty until build_neighbors is called
+	std::span<const std::uint32_t> van_neighbors(std::size_t customer) const { return M_neighbors.van(customer); }
+	std::span<const std::uint32_t> drone_neighbors(std::size_t customer) const { return M_neighbors.drone(customer); }
+	const neighbor_lists &neighbors() const { return M_neighbors; }
+
+	// builds the neighbor lists of every customer, the depot included, using thread_count threads (0 for all cores)
+	void build_neighbors(std::size_t k, std::size_t thread_count = 0) { M_neighbors = neighbor_lists(customers(), k, thread_count); }
 private:
-	matrix M_manhattan, M_euclidean;
+	static constexpr std::uint64_t empty_key = static_cast<std::uint64_t>(-1);
+	static constexpr std::size_t tile_elements = 2 * tile_size * tile_size; // manhattan block followed by euclidean block
+
 	const customer_info *M_customers;
+	position_view M_positions;
+	std::size_t M_tiles_per_row;
+	std::size_t M_sets;
+	neighbor_lists M_neighbors;
+
+	mutable std::vector<std::uint64_t> M_keys; // tile held by each slot
+	mutable std::vector<std::uint64_t> M_stamps; // last use of each slot
+	mutable std::vector<double> M_tiles;
+	mutable std::uint64_t M_clock;
+
+	vec2 pos(std::size_t i) const { return {M_positions.x[i], M_positions.y[i]}; }
+
+	// returns the manhattan distance between a and b inside its cached tile, the euclidean one is tile_size * tile_size after it
+	const double *lookup(std::size_t a, std::size_t b) const
+	{
+		std::size_t row_tile = a / tile_size, col_tile = b / tile_size;
+		if (row_tile > col_tile) // only the upper triangle of tiles is cached
+		{
+			std::swap(a, b);
+			std::swap(row_tile, col_tile);
+		}
+
+		std::uint64_t key = row_tile * M_tiles_per_row + col_tile;
+		std::size_t set = ((key * 0x9E3779B97F4A7C15ull) >> 17) % M_sets;
+		std::size_t first = set * tile_ways, slot = first;
+		for (std::size_t way = first; way < first + tile_ways; ++way)
+		{
+			if (M_keys[way] == key)
+			{
+				slot = way;
+				break;
+			}
+			if (M_stamps[way] < M_stamps[slot])
+				slot = way;
+		}
+
+		double *tile = M_tiles.data() + slot * tile_elements;
+		if (M_keys[slot] != key)
+		{
+			std::size_t row_end = std::min((row_tile + 1) * tile_size, size());
+			std::size_t col_begin = col_tile * tile_size, col_end = std::min(col_begin + tile_size, size());
+			for (std::size_t row = row_tile * tile_size; row < row_end; ++row)
+			{
+				double *out = tile + (row % tile_size) * tile_size;
+				distance_row<distance_type::manhattan>(M_positions.x, M_positions.y, row, col_begin, col_end, out);
+				distance_row<distance_type::euclidean>(M_positions.x, M_positions.y, row, col_begin, col_end, out + tile_size * tile_size);
+			}
+			M_keys[slot] = key;
+		}
+		M_stamps[slot] = ++M_clock;
+
+		return tile + (a % tile_size) * tile_size + b % tile_size;
+	}
+};
+
+// anything routes and solutions can be built on
+template <typename G>
+concept graph_backend = requires(const G &graph, std::size_t a, std::size_t b)
+{
+	{ graph.van_distance(a, b) } -> std::convertible_to<double>;
+	{ graph.drone_distance(a, b) } -> std::convertible_to<double>;
+	{ graph.size() } -> std::convertible_to<std::size_t>;
+	{ graph.customers() } -> std::same_as<const customer_info &>;
 };
 
+template <graph_backend Graph>
 class abstract_vehicle
 {
 public:
+	using graph_type = Graph;
+
 	// abstract_vehicle() : M_graph{} {}
-	abstract_vehicle(const vrp::graph &graph) : M_graph{&graph} {}
+	abstract_vehicle(const Graph &graph) : M_graph{&graph} {}
 
-	const vrp::graph &graph() const { return *M_graph; }
+	const Graph &graph() const { return *M_graph; }
 
 	virtual double cost() const = 0;
 	virtual std::size_t size() const = 0;
 
 	virtual ~abstract_vehicle() = default;
 protected:
-	const vrp::graph *M_graph;
+	const Graph *M_graph;
 };
 
-template <vehicle_type type>
+template <vehicle_type type, graph_backend Graph = vrp::graph>
 class vehicle_route;
 
-template <>
-class vehicle_route<vehicle_type::base> : public abstract_vehicle
+template <graph_backend Graph>
+class basic_solution;
+
+// splitmix64 finalizer, a bijection of the 64 bit integers that spreads every input bit over the whole output
+constexpr std::uint64_t mix_bits(std::uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// zobrist keys of the parts of a route, computed on the fly instead of stored in a table
+// a truck leg hashes the xor of the keys of its edges, which determine the order of its stops and change in O(1) per insertion
+constexpr std::uint64_t edge_key(std::size_t from, std::size_t to) { return mix_bits((static_cast<std::uint64_t>(from) << 32 | to) + 0x9e3779b97f4a7c15ull); }
+// a drone trip starts and ends at the depot, so a drone route hashes the set of its customers
+constexpr std::uint64_t trip_key(std::size_t customer) { return mix_bits(static_cast<std::uint64_t>(customer) + 0x632be59bd9b4e019ull); }
+constexpr std::uint64_t sortie_key(std::size_t departure, std::size_t service, std::size_t reunion)
+{
+	return mix_bits((static_cast<std::uint64_t>(departure) << 42 ^ static_cast<std::uint64_t>(service) << 21 ^ reunion) + 0x8cb92ba72f3d8dd7ull);
+}
+
+// exact cost and load fields of a route, saved by the solution's journal so undoing a change does not accumulate rounding errors
+struct route_cost_state
+{
+	double cost, load;
+	double drone_cost, drone_load; // only used by truck_drone routes
+};
+
+// where to insert a customer and how much it changes the route's cost
+struct route_insertion
+{
+	std::size_t index;
+	double delta;
+};
+
+// drone trip of a truck_drone route
+struct drone_node
+{
+	std::uint32_t departure; // customer where the drone departs from the truck
+	std::uint32_t service; // customer where the drone delivers the package
+	std::uint32_t reunion; // customer where the drone returns to the truck
+};
+
+// storage shared by the routes of a solution, so that routes only hold what they use and a solution is copied
+// with a few contiguous copies
+struct route_arenas
+{
+	arena<std::uint32_t> customers; // stops of every route
+	arena<double> distances; // edge and prefix distances of every truck leg
+	arena<drone_node> sorties;
+
+	void clear()
+	{
+		customers.clear();
+		distances.clear();
+		sorties.clear();
+	}
+
+	std::size_t memory_usage() const { return customers.memory_usage() + distances.memory_usage() + sorties.memory_usage(); }
+};
+
+// selects the route constructor that refers to another route's storage inside a wholesale copy of its route_arenas
+struct rebind_t
+{
+	explicit rebind_t() = default;
+};
+inline constexpr rebind_t rebind{};
+
+template <typename Graph>
+class vehicle_route<vehicle_type::base, Graph> : public abstract_vehicle<Graph>
 {
 public:
-	vehicle_route(const vrp::graph &graph) : abstract_vehicle(graph), M_cost{0}
+	vehicle_route(const Graph &graph, route_arenas &arenas) :
+		abstract_vehicle<Graph>(graph), M_route(arenas.customers), M_edges(arenas.distances), M_prefix(arenas.distances), M_cost{0}, M_load{0}, M_hash{edge_key(0, 0)}
 	{
-		M_route.reserve(graph.size());
 		M_route.push_back(0);
+		M_edges.push_back(0);
+		M_prefix.push_back(0);
+	}
+	vehicle_route(rebind_t, const vehicle_route &other, route_arenas &arenas) :
+		abstract_vehicle<Graph>(other),
+		M_route(other.M_route, arenas.customers), M_edges(other.M_edges, arenas.distances), M_prefix(other.M_prefix, arenas.distances),
+		M_cost{other.M_cost}, M_load{other.M_load}, M_hash{other.M_hash}
+	{
 	}
 
 	void insert(std::size_t index, std::size_t customer)
@@ -79,11 +321,21 @@ public:
 			throw std::invalid_argument("Invalid customer");
 		#endif
 		
-		std::size_t before = M_route[(index + M_route.size() - 1) % M_route.size()];
-
-		M_cost -= M_graph->van_distance(before, M_route[index % M_route.size()]); // how much this node and the previous one cost
-		M_route.insert(M_route.begin() + index, customer);
-		M_cost += M_graph->van_distance(before, customer) + M_graph->van_distance(customer, M_route[(index + 1) % M_route.size()]); // how much this node and its new neighbors cost
+		std::size_t before_index = (index + M_route.size() - 1) % M_route.size();
+		std::size_t before = M_route[before_index];
+		std::size_t after = M_route[index % M_route.size()];
+
+		double to_customer = M_graph->van_distance(before, customer);
+		double from_customer = M_graph->van_distance(customer, after);
+
+		M_cost += to_customer + from_customer - M_edges[before_index]; // the edge from before to after is replaced by two through customer
+		M_load += M_graph->customers().node(customer).demand();
+		M_hash ^= edge_key(before, after) ^ edge_key(before, customer) ^ edge_key(customer, after);
+		M_edges[before_index] = to_customer;
+		M_edges.insert(index, from_customer);
+		M_route.insert(index, static_cast<std::uint32_t>(customer));
+		M_prefix.insert(index, 0);
+		update_prefix(index);
 	}
 
 	void remove(std::size_t index)
@@ -95,27 +347,141 @@ public:
 			throw std::length_error("Route is empty");
 		#endif
 
-		std::size_t before = M_route[(index + M_route.size() - 1) % M_route.size()];
-		std::size_t current = M_route[index % M_route.size()];
+		std::size_t before_index = (index + M_route.size() - 1) % M_route.size();
+		std::size_t before = M_route[before_index];
 		std::size_t after = M_route[(index + 1) % M_route.size()];
-		M_cost -= M_graph->van_distance(before, current) + M_graph->van_distance(current, after);
-		M_route.erase(M_route.begin() + index);
-		M_cost += M_graph->van_distance(before, after);
+
+		double bridge = M_graph->van_distance(before, after);
+
+		M_cost += bridge - M_edges[before_index] - M_edges[index];
+		M_load -= M_graph->customers().node(M_route[index]).demand();
+		M_hash ^= edge_key(before, M_route[index]) ^ edge_key(M_route[index], after) ^ edge_key(before, after);
+		M_edges[before_index] = bridge;
+		M_edges.erase(index);
+		M_route.erase(index);
+		M_prefix.pop_back();
+		update_prefix(index);
+	}
+
+	// change in cost insert(index, customer) would cause, without modifying the route
+	double insertion_delta(std::size_t index, std::size_t customer) const
+	{
+		#if DO_CHECKING
+		if (index > M_route.size())
+			throw std::out_of_range("Invalid index");
+		if (customer >= M_graph->size() || customer == 0)
+			throw std::invalid_argument("Invalid customer");
+		#endif
+
+		std::size_t before_index = (index + M_route.size() - 1) % M_route.size();
+		return M_graph->van_distance(M_route[before_index], customer) + M_graph->van_distance(customer, M_route[index % M_route.size()]) - M_edges[before_index];
+	}
+
+	// change in cost remove(index) would cause, without modifying the route
+	double removal_delta(std::size_t index) const
+	{
+		#if DO_CHECKING
+		if (index >= M_route.size())
+			throw std::out_of_range("Invalid index");
+		#endif
+
+		std::size_t before_index = (index + M_route.size() - 1) % M_route.size();
+		return M_graph->van_distance(M_route[before_index], M_route[(index + 1) % M_route.size()]) - M_edges[before_index] - M_edges[index];
+	}
+
+	// cheapest index in [1, size()] to insert customer at, so the depot stays first
+	// distances to customer are gathered once, then every position is priced in one branch free sweep over the edge costs
+	route_insertion best_insertion(std::size_t customer) const
+	{
+		#if DO_CHECKING
+		if (customer >= M_graph->size() || customer == 0)
+			throw std::invalid_argument("Invalid customer");
+		#endif
+
+		thread_local std::vector<double> scratch;
+		std::size_t n = M_route.size();
+		scratch.resize(2 * n + 1);
+
+		double *to_customer = scratch.data(); // to_customer[k] = distance from stop k to customer, wrapping at n
+		double *delta = scratch.data() + n + 1; // delta[k] = cost of inserting between stop k and k + 1
+
+		for (std::size_t k = 0; k < n; ++k)
+			to_customer[k] = M_graph->van_distance(M_route[k], customer);
+		to_customer[n] = to_customer[0];
+
+		const double *edges = M_edges.data();
+		for (std::size_t k = 0; k < n; ++k)
+			delta[k] = to_customer[k] + to_customer[k + 1] - edges[k];
+
+		std::size_t best = 0;
+		for (std::size_t k = 1; k < n; ++k)
+			if (delta[k] < delta[best])
+				best = k;
+
+		return {best + 1, delta[best]};
+	}
+
+	// total demand of the customers on the route
+	double load() const { return M_load; }
+
+	// distance along the route from its first stop to stop index
+	double distance_to(std::size_t index) const { return M_prefix[index]; }
+	// distance along the route from stop index back to the first stop
+	double distance_from(std::size_t index) const { return M_prefix.back() + M_edges.back() - M_prefix[index]; }
+	// distance along the route from stop first to stop last, first <= last
+	double distance_between(std::size_t first, std::size_t last) const { return M_prefix[last] - M_prefix[first]; }
+
+	// capacity check, needs no distances so infeasible moves are pruned before they are priced
+	bool fits(std::size_t customer, const vehicle &limits) const { return M_load + M_graph->customers().node(customer).demand() <= limits.capacity; }
+	// range check of a move that changes the cost by delta
+	bool within_range(double delta, const vehicle &limits) const { return M_cost + delta <= limits.max_range; }
+
+	// insertion_delta if the route stays within the capacity and range of limits
+	std::optional<double> feasible_insertion_delta(std::size_t index, std::size_t customer, const vehicle &limits) const
+	{
+		if (!fits(customer, limits))
+			return std::nullopt;
+		double delta = insertion_delta(index, customer);
+		if (!within_range(delta, limits))
+			return std::nullopt;
+		return delta;
+	}
+
+	// best_insertion if the route stays within the capacity and range of limits
+	// the range only depends on the delta, so if the cheapest position is out of range every position is
+	std::optional<route_insertion> best_feasible_insertion(std::size_t customer, const vehicle &limits) const
+	{
+		if (!fits(customer, limits))
+			return std::nullopt;
+		route_insertion insertion = best_insertion(customer);
+		if (!within_range(insertion.delta, limits))
+			return std::nullopt;
+		return insertion;
 	}
 
 	double cost() const override { return M_cost; }
 	std::size_t size() const override { return M_route.size(); }
+	// zobrist hash of the stops in order, equal for equal routes
+	std::uint64_t hash() const { return M_hash; }
+
+	std::uint64_t manual_hash() const // only for testing. for checking to make sure the hash is kept up to date
+	{
+		std::uint64_t res = 0;
+		for (std::size_t i = 0; i < M_route.size(); ++i)
+			res ^= edge_key(M_route[i], M_route[(i + 1) % M_route.size()]);
+		return res;
+	}
 
 	double manual_cost() const // only for testing. for checking to make sure cost calculation is correct
 	{
 		double sum = 0;
 		for (std::size_t i = 0; i < M_route.size() - 1; ++i)
 			sum += M_graph->van_distance(M_route[i], M_route[i + 1]);
-		sum += M_graph->van_distance(M_route.back(), M_route.front());
+		sum += M_graph->van_distance(M_route.back(), M_route[0]);
 		return sum;
 	}
 
-	const std::size_t &operator[](std::size_t index) const
+	std::size_t operator[](std::size_t index) const
 	{
 		#if DO_CHECKING
 		if (index >= M_route.size())
@@ -125,31 +491,63 @@ public:
 	}
 	
 private:
-	std::vector<std::size_t> M_route;
+	using abstract_vehicle<Graph>::M_graph;
+
+	arena_vector<std::uint32_t> M_route;
+	arena_vector<double> M_edges; // M_edges[k] is the cost from M_route[k] to the next stop, the last one returns to M_route[0]
+	arena_vector<double> M_prefix; // M_prefix[k] is the sum of M_edges[0 .. k), recomputed from M_edges so it never drifts
 	double M_cost;
+	double M_load;
+	std::uint64_t M_hash; // xor of the edge keys
+
+	// recomputes the prefix distances of stops from index onward
+	void update_prefix(std::size_t index)
+	{
+		for (std::size_t k = std::max<std::size_t>(index, 1); k < M_prefix.size(); ++k)
+			M_prefix[k] = M_prefix[k - 1] + M_edges[k - 1];
+	}
+
+	route_cost_state cost_state() const { return {.cost = M_cost, .load = M_load, .drone_cost = 0, .drone_load = 0}; }
+	void restore_cost_state(route_cost_state state)
+	{
+		M_cost = state.cost;
+		M_load = state.load;
+	}
+
+	// moves the stops into new blocks of arenas, keeping their capacity
+	void relocate(route_arenas &arenas)
+	{
+		M_route.relocate(arenas.customers, M_route.capacity());
+		M_edges.relocate(arenas.distances, M_edges.capacity());
+		M_prefix.relocate(arenas.distances, M_prefix.capacity());
+	}
+
+	template <graph_backend> friend class basic_solution;
+	template <vehicle_type, graph_backend> friend class vehicle_route;
 };
 
-template <>
-class vehicle_route<vehicle_type::autonomous> : public vehicle_route<vehicle_type::base>
+template <typename Graph>
+class vehicle_route<vehicle_type::autonomous, Graph> final : public vehicle_route<vehicle_type::base, Graph>
 {
 public:
-	using vehicle_route<vehicle_type::base>::vehicle_route;
+	using vehicle_route<vehicle_type::base, Graph>::vehicle_route;
 };
 
-template <>
-class vehicle_route<vehicle_type::van> : public vehicle_route<vehicle_type::base>
+template <typename Graph>
+class vehicle_route<vehicle_type::van, Graph> final : public vehicle_route<vehicle_type::base, Graph>
 {
 public:
-	using vehicle_route<vehicle_type::base>::vehicle_route;
+	using vehicle_route<vehicle_type::base, Graph>::vehicle_route;
 };
 
-template <>
-class vehicle_route<vehicle_type::drone> : public abstract_vehicle
+template <typename Graph>
+class vehicle_route<vehicle_type::drone, Graph> final : public abstract_vehicle<Graph>
 {
 public:
-	vehicle_route(const vrp::graph &graph) : abstract_vehicle(graph), M_cost{0}
+	vehicle_route(const Graph &graph, route_arenas &arenas) : abstract_vehicle<Graph>(graph), M_route(arenas.customers), M_cost{0}, M_hash{0} {}
+	vehicle_route(rebind_t, const vehicle_route &other, route_arenas &arenas) :
+		abstract_vehicle<Graph>(other), M_route(other.M_route, arenas.customers), M_cost{other.M_cost}, M_hash{other.M_hash}
 	{
-		M_route.reserve(graph.size());
 	}
 
 	void insert(std::size_t customer)
@@ -161,7 +559,8 @@ public:
 			throw std::invalid_argument("Invalid customer");
 		#endif
 
-		M_route.push_back(customer);
+		M_route.push_back(static_cast<std::uint32_t>(customer));
+		M_hash ^= trip_key(customer);
 		M_cost += 2 * M_graph->drone_distance(0, customer); // how much it costs to go from the depot to the customer and back
 	}
 
@@ -173,11 +572,47 @@ public:
 		#endif
 
 		M_cost -= 2 * M_graph->drone_distance(0, M_route[index]); // how much it costs to go from the depot to the customer and back
-		M_route.erase(M_route.begin() + index);
+		M_hash ^= trip_key(M_route[index]);
+		M_route.erase(index);
 	}
 
+	// change in cost insert(customer) would cause, without modifying the route
+	double insertion_delta(std::size_t customer) const
+	{
+		#if DO_CHECKING
+		if (customer >= M_graph->size() || customer == 0)
+			throw std::invalid_argument("Invalid customer");
+		#endif
+
+		return 2 * M_graph->drone_distance(0, customer);
+	}
+
+	// change in cost remove(index) would cause, without modifying the route
+	double removal_delta(std::size_t index) const
+	{
+		#if DO_CHECKING
+		if (index >= M_route.size())
+			throw std::out_of_range("Invalid index");
+		#endif
+
+		return -2 * M_graph->drone_distance(0, M_route[index]);
+	}
+
+	// every trip starts and ends at the depot, so the position does not change the cost
+	route_insertion best_insertion(std::size_t customer) const { return {M_route.size(), insertion_delta(customer)}; }
+
 	double cost() const override { return M_cost; }
 	std::size_t size() const override { return M_route.size(); }
+	// zobrist hash of the set of customers, the order of independent trips does not matter
+	std::uint64_t hash() const { return M_hash; }
+
+	std::uint64_t manual_hash() const // only for testing. for checking to make sure the hash is kept up to date
+	{
+		std::uint64_t res = 0;
+		for (std::size_t i = 0; i < M_route.size(); ++i)
+			res ^= trip_key(M_route[i]);
+		return res;
+	}
 
 	double manual_cost() const // only for testing. for checking to make sure cost calculation is correct
 	{
@@ -187,26 +622,44 @@ public:
 		return sum;
 	}
 
-	const std::size_t &operator[](std::size_t index) const { return M_route[index]; }
+	std::size_t operator[](std::size_t index) const { return M_route[index]; }
 private:
-	std::vector<std::size_t> M_route;
+	using abstract_vehicle<Graph>::M_graph;
+
+	arena_vector<std::uint32_t> M_route;
 	double M_cost;
+	std::uint64_t M_hash; // xor of the trip keys
+
+	route_cost_state cost_state() const { return {.cost = M_cost, .load = 0, .drone_cost = 0, .drone_load = 0}; }
+	void restore_cost_state(route_cost_state state) { M_cost = state.cost; }
+
+	// puts a removed customer back where it was, the cost is restored separately
+	void undo_remove(std::size_t index, std::size_t customer)
+	{
+		M_route.insert(index, static_cast<std::uint32_t>(customer));
+		M_hash ^= trip_key(customer);
+	}
+
+	void relocate(route_arenas &arenas) { M_route.relocate(arenas.customers, M_route.capacity()); }
+
+	template <graph_backend> friend class basic_solution;
+	template <vehicle_type, graph_backend> friend class vehicle_route;
 };
 
-template <>
-class vehicle_route<vehicle_type::truck_drone> : public abstract_vehicle
+template <typename Graph>
+class vehicle_route<vehicle_type::truck_drone, Graph> final : public abstract_vehicle<Graph>
 {
 public:
-	struct drone_node
-	{
-		std::size_t departure; // customer where the drone departs from the truck
-		std::size_t service; // customer where the drone delivers the package
-		std::size_t reunion; // customer where the drone returns to the truck
-	};
+	using drone_node = vrp::drone_node;
 
-	vehicle_route(const vrp::graph &graph) : abstract_vehicle(graph), M_truck_route(graph), M_drone_cost{0}
+	vehicle_route(const Graph &graph, route_arenas &arenas) :
+		abstract_vehicle<Graph>(graph), M_truck_route(graph, arenas), M_drones(arenas.sorties), M_drone_cost{0}, M_drone_load{0}, M_drone_hash{0}
+	{
+	}
+	vehicle_route(rebind_t, const vehicle_route &other, route_arenas &arenas) :
+		abstract_vehicle<Graph>(other), M_truck_route(rebind, other.M_truck_route, arenas), M_drones(other.M_drones, arenas.sorties),
+		M_drone_cost{other.M_drone_cost}, M_drone_load{other.M_drone_load}, M_drone_hash{other.M_drone_hash}
 	{
-		M_drones.reserve(graph.size()); // actual max capacity should be less than graph size
 	}
 
 	void insert(std::size_t index, std::size_t customer) { M_truck_route.insert(index, customer); }
@@ -220,26 +673,88 @@ public:
 			throw std::invalid_argument("Invalid customer");
 		#endif
 
-		M_drones.push_back({.departure = departure_customer, .service = service_customer, .reunion = reunion_customer});
+		M_drones.push_back({
+			.departure = static_cast<std::uint32_t>(departure_customer),
+			.service = static_cast<std::uint32_t>(service_customer),
+			.reunion = static_cast<std::uint32_t>(reunion_customer),
+		});
 
-		M_drone_cost += M_graph->drone_distance(departure_customer, service_customer) + M_graph->drone_distance(service_customer, reunion_customer);
+		M_drone_cost += rendevous_delta(departure_customer, service_customer, reunion_customer);
+		M_drone_load += M_graph->customers().node(service_customer).demand();
+		M_drone_hash ^= sortie_key(departure_customer, service_customer, reunion_customer);
 	}
 
 	void remove(std::size_t index) { M_truck_route.remove(index); }
+
 	void remove_rendevous(std::size_t index)
 	{
 		#if DO_CHECKING
 		if (index >= M_drones.size())
 			throw std::out_of_range("Invalid index");
 		#endif
-		drone_node &node = M_drones[index];
+		const drone_node &node = M_drones[index];
 		M_drone_cost -= M_graph->drone_distance(node.departure, node.service) + M_graph->drone_distance(node.service, node.reunion);
-		M_drones.erase(M_drones.begin() + index);
+		M_drone_load -= M_graph->customers().node(node.service).demand();
+		M_drone_hash ^= sortie_key(node.departure, node.service, node.reunion);
+		M_drones.erase(index);
+	}
+
+	// change in cost insert_rendevous would cause, the truck leg is not changed by a sortie
+	double rendevous_delta(std::size_t departure_customer, std::size_t service_customer, std::size_t reunion_customer) const
+	{
+		return M_graph->drone_distance(departure_customer, service_customer) + M_graph->drone_distance(service_customer, reunion_customer);
+	}
+
+	// deltas of the truck leg, see base_route
+	double insertion_delta(std::size_t index, std::size_t customer) const { return M_truck_route.insertion_delta(index, customer); }
+	double removal_delta(std::size_t index) const { return M_truck_route.removal_delta(index); }
+	route_insertion best_insertion(std::size_t customer) const { return M_truck_route.best_insertion(customer); }
+
+	// the truck carries the packages of the customers its drone serves too
+	double load() const { return M_truck_route.load() + M_drone_load; }
+
+	// distances along the truck leg, see base_route
+	double distance_to(std::size_t index) const { return M_truck_route.distance_to(index); }
+	double distance_from(std::size_t index) const { return M_truck_route.distance_from(index); }
+	double distance_between(std::size_t first, std::size_t last) const { return M_truck_route.distance_between(first, last); }
+
+	// feasibility of the truck leg against the truck's capacity and range, see base_route
+	bool fits(std::size_t customer, const vehicle &limits) const { return load() + M_graph->customers().node(customer).demand() <= limits.capacity; }
+	bool within_range(double delta, const vehicle &limits) const { return M_truck_route.within_range(delta, limits); }
+
+	std::optional<double> feasible_insertion_delta(std::size_t index, std::size_t customer, const vehicle &limits) const
+	{
+		if (!fits(customer, limits))
+			return std::nullopt;
+		double delta = insertion_delta(index, customer);
+		if (!within_range(delta, limits))
+			return std::nullopt;
+		return delta;
+	}
+
+	std::optional<route_insertion> best_feasible_insertion(std::size_t customer, const vehicle &limits) const
+	{
+		if (!fits(customer, limits))
+			return std::nullopt;
+		route_insertion insertion = best_insertion(customer);
+		if (!within_range(insertion.delta, limits))
+			return std::nullopt;
+		return insertion;
 	}
 
 	double cost() const override { return M_drone_cost + M_truck_route.cost(); }
 	std::size_t size() const override { return M_truck_route.size(); }
 	std::size_t size_rendevous() const { return M_drones.size(); }
+	// zobrist hash of the truck leg and the set of sorties
+	std::uint64_t hash() const { return M_truck_route.hash() ^ M_drone_hash; }
+
+	std::uint64_t manual_hash() const // only for testing. for checking to make sure the hash is kept up to date
+	{
+		std::uint64_t res = M_truck_route.manual_hash();
+		for (const drone_node &node : M_drones)
+			res ^= sortie_key(node.departure, node.service, node.reunion);
+		return res;
+	}
 
 	double manual_cost() const // only for testing. for checking to make sure cost calculation is correct
 	{
@@ -249,13 +764,41 @@ public:
 		return sum;
 	}
 
-	const std::size_t &truck_stop(std::size_t index) const { return M_truck_route[index]; }
+	std::size_t truck_stop(std::size_t index) const { return M_truck_route[index]; }
 	const drone_node &rendevous(std::size_t index) const { return M_drones[index]; }
 
 private:
-	vehicle_route<vehicle_type::base> M_truck_route;
-	std::vector<drone_node> M_drones;
+	using abstract_vehicle<Graph>::M_graph;
+
+	vehicle_route<vehicle_type::base, Graph> M_truck_route;
+	arena_vector<drone_node> M_drones;
 	double M_drone_cost;
+	double M_drone_load; // demand of the customers served by the drone
+	std::uint64_t M_drone_hash; // xor of the sortie keys
+
+	route_cost_state cost_state() const { return {.cost = M_truck_route.M_cost, .load = M_truck_route.M_load, .drone_cost = M_drone_cost, .drone_load = M_drone_load}; }
+	void restore_cost_state(route_cost_state state)
+	{
+		M_truck_route.restore_cost_state(state);
+		M_drone_cost = state.drone_cost;
+		M_drone_load = state.drone_load;
+	}
+
+	// puts a removed rendevous back where it was, the cost is restored separately
+	void undo_remove_rendevous(std::size_t index, const drone_node &node)
+	{
+		M_drones.insert(index, node);
+		M_drone_hash ^= sortie_key(node.departure, node.service, node.reunion);
+	}
+
+	void relocate(route_arenas &arenas)
+	{
+		M_truck_route.relocate(arenas);
+		M_drones.relocate(arenas.sorties, M_drones.capacity());
+	}
+
+	template <graph_backend> friend class basic_solution;
+	template <vehicle_type, graph_backend> friend class vehicle_route;
 };
 
 using base_route = vehicle_route<vehicle_type::base>;
@@ -264,17 +807,4 @@ using van_route = vehicle_route<vehicle_type::van>;
 using drone_route = vehicle_route<vehicle_type::drone>;
 using truck_drone_route = vehicle_route<vehicle_type::truck_drone>;
 
-class solution
-{
-public:
-	constexpr solution() : M_graph{}, M_fleet{} {}
-	constexpr solution(const graph &graph, const fleet_info &fleet) : M_graph{&graph}, M_fleet{&fleet} {}
-
-	const vrp::graph &graph() const { return *M_graph; }
-	const fleet_info &fleet() const { return *M_fleet; }
-private:
-	const vrp::graph *M_graph;
-	const fleet_info *M_fleet;
-};
-
 VRP_END
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+#include "graph.h"
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+
+VRP_BEG
+
+// storage of the distance matrices in a graph file
+struct graph_file_format
+{
+	bool symmetric; // strict upper triangle only, as basic_symmetric_matrix stores it
+	std::uint32_t element_size; // 4 for float, 8 for double
+
+	template <typename Matrix>
+	static constexpr graph_file_format of()
+	{
+		return {.symmetric = requires(const Matrix &m) { m.upper_row(0); }, .element_size = sizeof(typename Matrix::value_type)};
+	}
+
+	bool operator==(const graph_file_format &) const = default;
+};
+
+// binary file of a graph in the byte order of the machine that wrote it: a 64 byte header (magic number, version,
+// byte order mark, format, node count and neighbor count k), then on 64 byte boundaries the customers as x, y, demand
+// doubles, the manhattan and euclidean matrices in their storage order and the neighbor lists as neighbor_lists lays
+// them out, absent when k is 0. written through write_replacing, so a process mapping the file never sees it half
+// written
+void write_graph_file(const std::filesystem::path &path, graph_file_format format, const customer_info &customers,
+                      std::span<const std::byte> manhattan, std::span<const std::byte> euclidean, const neighbor_lists &neighbors);
+
+// the sections of a mapped graph file
+class graph_file
+{
+public:
+	graph_file() : M_format{}, M_size{}, M_k{}, M_manhattan{}, M_euclidean{}, M_neighbors{} {}
+	// throws std::runtime_error if path is not a graph file whose matrices are stored as format
+	graph_file(const std::filesystem::path &path, graph_file_format format);
+
+	std::size_t size() const { return M_size; }
+	// copies of the customers and neighbor lists, which are small next to the matrices
+	customer_info customers() const;
+	neighbor_lists neighbors() const;
+
+	template <typename T>
+	const T *manhattan() const { return reinterpret_cast<const T *>(M_file.bytes().data() + M_manhattan); }
+	template <typename T>
+	const T *euclidean() const { return reinterpret_cast<const T *>(M_file.bytes().data() + M_euclidean); }
+
+	// bytes of the file, shared with every process that maps it
+	std::size_t mapped_size() const { return M_file.size(); }
+
+private:
+	mapped_file M_file;
+	graph_file_format M_format;
+	std::size_t M_size, M_k;
+	std::size_t M_manhattan, M_euclidean, M_neighbors; // offsets of the sections
+};
+
+// writes graph and its neighbor lists, if built, to path for basic_mapped_graph<Matrix> to open
+template <typename Matrix>
+void save_graph(const std::filesystem::path &path, const basic_graph<Matrix> &graph)
+{
+	write_graph_file(path, graph_file_format::of<Matrix>(), graph.customers(), std::as_bytes(graph.van_matrix().data()),
+	                 std::as_bytes(graph.drone_matrix().data()), graph.neighbors());
+}
+
+// basic_graph<Matrix> read from a file save_graph wrote. the matrices are read straight from a read only mapping of the
+// file, so opening it costs a copy of the customers and neighbor lists and processes opening the same file share one
+// copy of the matrices in the page cache. safe to read concurrently, like basic_graph
+template <typename Matrix>
+class basic_mapped_graph
+{
+public:
+	using matrix_type = Matrix;
+	using view_type = typename Matrix::view_type;
+
+	basic_mapped_graph() = default;
+	// throws std::runtime_error if path is not a graph file written from a basic_graph<Matrix>
+	explicit basic_mapped_graph(const std::filesystem::path &path) :
+		M_file(path, graph_file_format::of<Matrix>()), M_customers{M_file.customers()},
+		M_manhattan(M_file.manhattan<typename Matrix::value_type>(), M_file.size(), M_file.size()),
+		M_euclidean(M_file.euclidean<typename Matrix::value_type>(), M_file.size(), M_file.size()),
+		M_neighbors{M_file.neighbors()}
+	{
+	}
+
+	basic_mapped_graph(basic_mapped_graph &&) = default;
+	basic_mapped_graph &operator=(basic_mapped_graph &&) = default;
+
+	double drone_distance(std::size_t a, std::size_t b) const { return M_euclidean(a, b); }
+	double van_distance(std::size_t a, std::size_t b) const { return M_manhattan(a, b); }
+
+	const customer_info &customers() const { return M_customers; }
+	std::size_t size() const { return M_customers.size(); }
+
+	// bytes of the mapping and neighbor lists, the mapping is counted although other processes share it
+	std::size_t memory_usage() const { return M_file.mapped_size() + M_neighbors.memory_usage(); }
+
+	// sorted k nearest neighbors of customer by each metric, empty if the file has none and build_neighbors was not called
+	std::span<const std::uint32_t> van_neighbors(std::size_t customer) const { return M_neighbors.van(customer); }
+	std::span<const std::uint32_t> drone_neighbors(std::size_t customer) const { return M_neighbors.drone(customer); }
+	const neighbor_lists &neighbors() const { return M_neighbors; }
+
+	// builds the neighbor lists of every customer, the depot included, using thread_count threads (0 for all cores)
+	void build_neighbors(std::size_t k, std::size_t thread_count = 0) { M_neighbors = neighbor_lists(customers(), k, thread_count); }
+private:
+	graph_file M_file;
+	customer_info M_customers;
+	view_type M_manhattan, M_euclidean;
+	neighbor_lists M_neighbors;
+};
+
+using mapped_graph = basic_mapped_graph<matrix>;
+using mapped_packed_graph = basic_mapped_graph<symmetric_matrix>;
+using mapped_compact_graph = basic_mapped_graph<compact_symmetric_matrix>;
+
+VRP_END
@@ -7,6 +7,8 @@
 #include <random>
 
 #include "nodes.h"
+#include "kernels.h"
+#include "parallel.h"
 #include "macro.h"
 
 VRP_BEG
@@ -31,7 +33,7 @@ public:
 	constexpr fleet_info() :
 		M_vehicles{},
 		M_cost{},
-		M_auto_count{}, M_van_count{}, M_drone_count{}, M_truck_drone_count{}, M_fleet_count{},
+		M_base_count{}, M_auto_count{}, M_van_count{}, M_drone_count{}, M_truck_drone_count{}, M_fleet_count{},
 		M_fleet_capacity{}
 	{
 	}
@@ -41,7 +43,7 @@ public:
 		     		     const vehicle &auto_data, const vehicle &van_data, const vehicle &drone_data, const vehicle &truck_drone_data) :
 		M_vehicles{{{}, auto_data, van_data, drone_data, truck_drone_data}},
 		M_cost{{labor_cost, electric_cost, fuel_cost, emmision_cost}},
-		M_auto_count{auto_count}, M_van_count{van_count}, M_drone_count{drone_count}, M_truck_drone_count{truck_drone_count}, M_fleet_count{auto_count + van_count + drone_count}
+		M_base_count{0}, M_auto_count{auto_count}, M_van_count{van_count}, M_drone_count{drone_count}, M_truck_drone_count{truck_drone_count}, M_fleet_count{auto_count + van_count + drone_count}
 	{
 		if (van_count + drone_count < truck_drone_count)
 			throw std::runtime_error("Invalid fleet");
@@ -54,12 +56,13 @@ public:
 		     		     const vehicle &base_data) :
 		M_vehicles{{base_data}},
 		M_cost{{labor_cost, electric_cost, fuel_cost, emmision_cost}},
-		M_auto_count{0}, M_van_count{0}, M_drone_count{0}, M_truck_drone_count{0}, M_fleet_count{base_count}
+		M_base_count{base_count}, M_auto_count{0}, M_van_count{0}, M_drone_count{0}, M_truck_drone_count{0}, M_fleet_count{base_count}
 	{
 		M_fleet_capacity = base_count * base_data.capacity;
 	}
 
 	constexpr std::size_t fleet_count() const { return M_fleet_count; }
+	constexpr std::size_t base_count() const { return M_base_count; }
 	constexpr std::size_t auto_count() const { return M_auto_count; }
 	constexpr std::size_t van_count() const { return M_van_count; }
 	constexpr std::size_t drone_count() const { return M_drone_count; }
@@ -70,10 +73,26 @@ public:
 
 	constexpr double fleet_capacity() const { return M_fleet_capacity; }
 
+	constexpr std::size_t count(vehicle_type type) const
+	{
+		switch (type)
+		{
+		case vehicle_type::base: return M_base_count;
+		case vehicle_type::autonomous: return M_auto_count;
+		case vehicle_type::van: return M_van_count;
+		case vehicle_type::drone: return M_drone_count;
+		case vehicle_type::truck_drone: return M_truck_drone_count;
+		}
+		return 0;
+	}
+
+	constexpr const vehicle &vehicle_data(vehicle_type type) const { return M_vehicles[static_cast<std::size_t>(type)]; }
+
 private:
 	std::array<vehicle, 5> M_vehicles;
 	std::array<cost_data, 5> M_cost;
 
+	std::size_t M_base_count; // number of generic vehicles, only used by single vehicle type fleets
 	std::size_t M_auto_count; // number of autonomous vehicles
 	std::size_t M_van_count; // number of electric vehicles
 	std::size_t M_drone_count; // number of standalone drones (maybe unused?)
@@ -84,11 +103,19 @@ private:
 	double M_fleet_capacity;
 };
 
+// structure of arrays view of customer positions, x[i] and y[i] are the coordinates of customer i
+struct position_view
+{
+	const double *x;
+	const double *y;
+	std::size_t size;
+};
+
 class customer_info
 {
 public:
 	constexpr customer_info() :
-		M_customers{}
+		M_customers{}, M_x{}, M_y{}
 	{
 	}
 
@@ -97,18 +124,36 @@ public:
 	{
 		auto range = std::ranges::single_view(customer{depot, 0}) | customers;
 		M_customers.assign(std::ranges::begin(range), std::ranges::end(range));
+		build_positions();
+	}
+
+	// nodes[0] is the depot
+	explicit constexpr customer_info(std::vector<customer> nodes) :
+		M_customers{std::move(nodes)}
+	{
+		build_positions();
 	}
 
 	// returns a distance matrix of customers where index 0 is the depot
-	template <distance_type type>
-	matrix distance_matrix() const
+	// Matrix can be any of matrix, symmetric_matrix or compact_symmetric_matrix
+	// rows are filled in parallel by thread_count threads (0 for all cores)
+	template <distance_type type, typename Matrix = matrix>
+	Matrix distance_matrix(std::size_t thread_count = 0) const
 	{
 		auto size = M_customers.size();
-		matrix res(size, size);
-
-		for (std::size_t i = 0; i < size; ++i)
-			for (std::size_t j = 0; j < size; ++j)
-				res[i][j] = res[j][i] = vrp::distance<type>(M_customers[i], M_customers[j]);
+		Matrix res(size, size);
+
+		position_view pos = positions();
+		if constexpr (requires { res.upper_row(0); })
+		{
+			// packed storage, only the upper triangle is computed
+			parallel_for(0, size, [&](std::size_t i) { distance_row<type>(pos.x, pos.y, i, i + 1, size, res.upper_row(i)); }, thread_count);
+		}
+		else
+		{
+			// full rows are cheaper to compute than mirroring the upper triangle with strided writes
+			parallel_for(0, size, [&](std::size_t i) { distance_row<type>(pos.x, pos.y, i, 0, size, res[i]); }, thread_count);
+		}
 
 		return res;
 	}
@@ -120,8 +165,22 @@ public:
 
 	constexpr const std::vector<customer> &nodes() const { return M_customers; }
 
+	constexpr position_view positions() const { return {M_x.data(), M_y.data(), M_x.size()}; }
+
 private:
 	std::vector<customer> M_customers;
+	std::vector<double> M_x, M_y; // positions of M_customers as a structure of arrays
+
+	constexpr void build_positions()
+	{
+		M_x.resize(M_customers.size());
+		M_y.resize(M_customers.size());
+		for (std::size_t i = 0; i < M_customers.size(); ++i)
+		{
+			M_x[i] = M_customers[i].pos().x;
+			M_y[i] = M_customers[i].pos().y;
+		}
+	}
 
 	friend customer_info random_customers(std::size_t count, geographic_vec2 center, double box_size, std::size_t min_demand, std::size_t max_demand, std::size_t seed);
 };
@@ -131,7 +190,7 @@ private:
 /// @param box_size size of box in miles
 /// @param seed random number generator seed
 /// @returns randomly generated customers
-customer_info random_customers(std::size_t count, geographic_vec2 center, double box_size, std::size_t min_demand, std::size_t max_demand, std::size_t seed = static_cast<std::size_t>(-1))
+inline customer_info random_customers(std::size_t count, geographic_vec2 center, double box_size, std::size_t min_demand, std::size_t max_demand, std::size_t seed = static_cast<std::size_t>(-1))
 {
 	if (seed == static_cast<std::size_t>(-1))
 		seed = std::random_device{}();
@@ -159,6 +218,7 @@ customer_info random_customers(std::size_t count, geographic_vec2 center, double
 		res.M_customers.emplace_back(new_pos, demand_dist(gen));
 	}
 
+	res.build_positions();
 	return res;
 }
 
@@ -0,0 +1,43 @@
+#pragma once
+#include "info.h"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+VRP_BEG
+
+// customers and fleet of a problem read from a file
+struct instance
+{
+	std::string name;
+	customer_info customers; // node 0 is the depot
+	fleet_info fleet;
+};
+
+// reads a CVRPLIB/TSPLIB file or a native one, told apart by their first line. the file is memory mapped and parsed in
+// place, only the name is copied out of it
+//
+// CVRPLIB/TSPLIB: NAME, TYPE (CVRP or TSP), DIMENSION, CAPACITY, EDGE_WEIGHT_TYPE (only MAN_2D, since truck routes
+// are priced with unrounded manhattan distances), DISTANCE (route length limit, unlimited if missing) and VEHICLES headers,
+// then NODE_COORD_SECTION, DEMAND_SECTION and DEPOT_SECTION. the first depot becomes node 0 and the other nodes follow in
+// file order. the fleet is VEHICLES base vehicles, or the k of a "-k<count>" name suffix, or one more than the bound
+// total demand / CAPACITY. a TSP is one vehicle without a capacity
+//
+// native, one directive per line and # to the end of a line is a comment:
+//     PSVRP 1
+//     NAME <name>
+//     COST <labor|electric|fuel|emissions> <cost> <cost rate>
+//     VEHICLE <base|autonomous|van|drone|truck_drone> <count> <capacity> <max range> <cost>
+//     COORDINATES <planar|geographic>
+//     NODES <count>
+//     <x> <y> <demand>    count lines, the depot first
+// a base fleet cannot be mixed with the other vehicle types. geographic nodes are <latitude> <longitude> <demand> and
+// are projected around the depot with equirectangular_projection, in miles
+//
+// throws std::runtime_error naming the file and line of the first error
+instance read_instance(const std::filesystem::path &path);
+// the same as read_instance on text, source names it in errors
+instance parse_instance(std::string_view text, std::string_view source = "<memory>");
+
+VRP_END
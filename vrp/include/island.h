@@ -0,0 +1,225 @@
+#pragma once
+#include "multistart.h"
+#include "bounded_queue.h"
+
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <vector>
+
+VRP_BEG
+
+// which islands an island sends its best solution to
+enum class migration_topology
+{
+	ring, // to the next island, every improvement travels around the ring
+	broadcast_best, // the island holding the global best sends it to every other island
+};
+
+struct island_parameters
+{
+	std::size_t migration_interval = 500; // iterations between migrations
+	migration_topology topology = migration_topology::ring;
+	bool merge_weights = false; // a received migrant also pulls the operator weights halfway towards the sender's
+	std::size_t queue_capacity = 4; // migrants waiting per island, a migrant sent to a full island is dropped
+};
+
+// ALNS searches on one thread each that periodically exchange elite solutions (island model)
+// each island has a bounded lock free inbox of preallocated migrants, so sending and receiving never waits or
+// allocates once the migrants have grown to the size of a solution. an island adopts a migrant better than its
+// current solution and different from it. the islands share one visited set, so a solution one island accepted
+// is a revisit on every island. which migrants arrive when depends on thread timing, so unlike basic_multistart the result is
+// not reproducible from the seed
+template <graph_backend Graph>
+class basic_islands
+{
+public:
+	basic_islands(const Graph &graph, const fleet_info &fleet, const alns_parameters &parameters, const island_parameters &islands, std::size_t thread_count) :
+		M_graph{&graph}, M_fleet{&fleet}, M_parameters{parameters}, M_islands{islands},
+		M_searches(thread_count ? thread_count : default_thread_count()), M_reports(M_searches.size()), M_indexes(graph, fleet, parameters, M_searches.size()),
+		M_visited(parameters.visited_capacity * M_searches.size()), M_best{}
+	{
+		if (islands.migration_interval == 0)
+			throw std::invalid_argument("Migration interval must be positive");
+		M_inboxes.reserve(M_searches.size());
+		for (std::size_t i = 0; i < M_searches.size(); ++i)
+			M_inboxes.push_back(std::make_unique<bounded_queue<migrant>>(islands.queue_capacity));
+	}
+
+	// runs parameters.iterations iterations on every island within parameters.time_limit, migrating every
+	// migration_interval iterations
+	void run()
+	{
+		auto deadline = basic_alns<Graph>::deadline(M_parameters, std::chrono::steady_clock::now());
+		{
+			std::vector<std::jthread> threads;
+			threads.reserve(M_searches.size());
+			for (std::size_t i = 0; i < M_searches.size(); ++i)
+				threads.emplace_back([this, i, deadline]() { run_island(i, deadline); });
+		}
+		M_resume.searches.clear();
+
+		M_best = 0;
+		for (std::size_t i = 1; i < M_searches.size(); ++i)
+			if (M_reports[i].best_objective < M_reports[M_best].best_objective)
+				M_best = i;
+	}
+
+	// the next run continues every island from checkpoint and runs what is left of its parameters.iterations, the
+	// migrants in flight when it was taken are lost
+	void resume(run_checkpoint checkpoint)
+	{
+		check_checkpoint(checkpoint, M_graph->size(), M_searches.size());
+		M_resume = std::move(checkpoint);
+	}
+	// every island hands its state to writer every parameters.checkpoint_interval iterations and when a run ends, the
+	// writer must outlive the islands and hold thread_count() searches
+	void checkpoint_to(checkpoint_writer &writer) { M_checkpoint = &writer; }
+
+	std::size_t thread_count() const { return M_searches.size(); }
+	std::span<const search_report> reports() const { return M_reports; }
+	// migrants sent, received and adopted over every island
+	std::size_t sent() const { return M_sent.load(std::memory_order_relaxed); }
+	std::size_t received() const { return M_received.load(std::memory_order_relaxed); }
+	std::size_t adopted() const { return M_adopted.load(std::memory_order_relaxed); }
+
+	double best_objective() const { return M_incumbent.objective(); }
+	// copy of the best solution found by any search, readable while the searches run, empty before any was found
+	basic_solution<Graph> incumbent() const
+	{
+		basic_solution<Graph> res(*M_graph, *M_fleet);
+		std::vector<std::uint32_t> routes;
+		if (M_incumbent.snapshot(routes) < std::numeric_limits<double>::infinity())
+			read_routes(res, routes);
+		return res;
+	}
+	const basic_solution<Graph> &best() const { return M_searches[M_best]->best(); }
+	const basic_alns<Graph> &search(std::size_t index) const { return *M_searches[index]; }
+
+private:
+	struct migrant
+	{
+		double objective;
+		std::array<double, 4> destroy_weights;
+		std::array<double, 3> repair_weights;
+		basic_solution<Graph> solution;
+	};
+
+	const Graph *M_graph;
+	const fleet_info *M_fleet;
+	alns_parameters M_parameters;
+	island_parameters M_islands;
+
+	std::vector<std::unique_ptr<basic_alns<Graph>>> M_searches;
+	std::vector<std::unique_ptr<bounded_queue<migrant>>> M_inboxes; // indexed by receiving island
+	std::vector<search_report> M_reports;
+	search_indexes M_indexes; // built once on every thread and shared by the searches
+	visited_set M_visited;
+	shared_incumbent M_incumbent;
+	std::atomic<std::size_t> M_sent{0}, M_received{0}, M_adopted{0};
+	run_checkpoint M_resume; // states the next run starts from, empty for none
+	checkpoint_writer *M_checkpoint = nullptr;
+	std::size_t M_best;
+
+	void run_island(std::size_t i, std::chrono::steady_clock::time_point deadline)
+	{
+		alns_parameters parameters = M_parameters;
+		parameters.seed = derive_seed(M_parameters.seed, i);
+		auto &search = M_searches[i];
+		if (!search)
+		{
+			search = std::make_unique<basic_alns<Graph>>(*M_graph, *M_fleet, parameters, &M_indexes);
+			search->publish_to(M_incumbent);
+			search->share_visited(M_visited);
+		}
+
+		std::size_t iterations = parameters.iterations;
+		if (!M_resume.searches.empty() && !M_resume.searches[i].empty())
+		{
+			search->restore(M_resume.searches[i]);
+			iterations -= std::min(search->iteration(), iterations);
+		}
+		if (M_checkpoint)
+			search->checkpoint_to(*M_checkpoint, i);
+
+		alns_statistics statistics{.iterations = 0, .improvements = 0, .duplicates = 0, .seconds = 0};
+		std::optional<std::uint64_t> last_sent; // hash of the last best sent
+		std::size_t sent = 0, received = 0, adopted = 0;
+		while (statistics.iterations < iterations && std::chrono::steady_clock::now() < deadline)
+		{
+			alns_statistics segment = search->run(std::min(M_islands.migration_interval, iterations - statistics.iterations), deadline);
+			statistics.iterations += segment.iterations;
+			statistics.improvements += segment.improvements;
+			statistics.duplicates += segment.duplicates;
+			statistics.seconds += segment.seconds;
+
+			// only improvements are sent, an unchanged best has already been sent
+			if (search->best().hash() != last_sent)
+			{
+				last_sent = search->best().hash();
+				for (std::size_t target : targets(i, *search))
+					sent += send(*search, target);
+			}
+
+			while (M_inboxes[i]->try_pop([&](migrant &m) { ++received; adopt(*search, m, adopted); }));
+		}
+
+		search->checkpoint();
+		M_sent.fetch_add(sent, std::memory_order_relaxed);
+		M_received.fetch_add(received, std::memory_order_relaxed);
+		M_adopted.fetch_add(adopted, std::memory_order_relaxed);
+		M_reports[i] = {.seed = parameters.seed, .statistics = statistics, .best_objective = search->best_objective()};
+	}
+
+	void adopt(basic_alns<Graph> &search, const migrant &m, std::size_t &adopted) const
+	{
+		if (M_islands.merge_weights)
+			search.merge_weights(m.destroy_weights, m.repair_weights);
+		// costs are accumulated in different orders on different islands, so the same solution can look a rounding
+		// error better. equal hashes tell it is the one the island already holds
+		if (m.objective < search.current_objective() && m.solution.hash() != search.current().hash())
+		{
+			search.adopt(m.solution, m.objective);
+			++adopted;
+		}
+	}
+
+	// islands that island i sends its best solution to, by topology
+	auto targets(std::size_t i, const basic_alns<Graph> &search) const
+	{
+		std::size_t n = M_searches.size();
+		std::size_t first = 0, count = 0;
+		if (n > 1)
+		{
+			if (M_islands.topology == migration_topology::ring)
+			{
+				first = i + 1;
+				count = 1;
+			}
+			else if (search.best_objective() <= M_incumbent.objective())
+			{
+				first = i + 1;
+				count = n - 1;
+			}
+		}
+		return std::views::iota(first, first + count) | std::views::transform([n](std::size_t t) { return t % n; });
+	}
+
+	// copies the best solution of search into the inbox of target, false if the inbox is full
+	bool send(const basic_alns<Graph> &search, std::size_t target)
+	{
+		return M_inboxes[target]->try_push([&](migrant &m)
+		{
+			m.objective = search.best_objective();
+			m.destroy_weights = search.destroy_weights();
+			m.repair_weights = search.repair_weights();
+			m.solution = search.best();
+		});
+	}
+};
+
+using islands = basic_islands<graph>;
+
+VRP_END
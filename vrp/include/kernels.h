@@ -0,0 +1,27 @@
+#pragma once
+#include "vectors.h"
+
+VRP_BEG
+
+enum class simd_level
+{
+	scalar,
+	avx2,
+	avx512,
+};
+
+// best instruction set supported by this cpu
+simd_level detected_simd_level();
+
+// instruction set used by the distance kernels, defaults to detected_simd_level()
+simd_level active_simd_level();
+// levels above detected_simd_level() are clamped
+void set_simd_level(simd_level level);
+
+// out[k] = distance((x[i], y[i]), (x[begin + k], y[begin + k])) for k in [0, end - begin)
+template <distance_type type>
+void distance_row(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, double *out);
+template <distance_type type>
+void distance_row(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, float *out);
+
+VRP_END
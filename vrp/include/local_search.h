@@ -0,0 +1,501 @@
+#pragma once
+#include "solution.h"
+#include "two_level_list.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+VRP_BEG
+
+// local search over the truck routes of a solution: the base, autonomous and van routes and the truck legs of the
+// truck_drone routes. intra route 2-opt and Or-opt, inter route relocate (of chains of up to three customers), swap and
+// 2-opt*. only moves that make a customer adjacent to one of its k nearest neighbors are tried, and a customer whose
+// moves failed is not looked at again until one of its edges changes (don't look bits)
+// every route is a path of one giant tour in a two_level_list, from a copy of the depot to the next copy, so 2-opt on a
+// long route costs O(sqrt(n)) per move. distances must be symmetric, since 2-opt reverses paths
+// drone routes and sorties are left alone. the truck stops a sortie departs from or returns to never leave their route
+// and keep their order, so every sortie stays valid
+template <graph_backend Graph>
+class basic_local_search
+{
+public:
+	// neighbors are the candidate lists by van distance and must outlive the local search
+	basic_local_search(const Graph &graph, const fleet_info &fleet, const neighbor_lists &neighbors) :
+		M_graph{&graph}, M_neighbors{&neighbors}, M_customers{graph.size()}, M_moves{}, M_queue_head{}, M_queue_size{}
+	{
+		basic_solution<Graph>::for_each_type([&](auto type)
+		{
+			if constexpr (type != vehicle_type::drone)
+			{
+				const vehicle &limits = fleet.vehicle_data(type);
+				for (std::size_t r = 0; r < fleet.count(type); ++r)
+					M_slots.push_back({.type = type, .route = static_cast<std::uint32_t>(r), .capacity = limits.capacity, .max_range = limits.max_range});
+			}
+		});
+
+		std::size_t nodes = M_customers + M_slots.size();
+		M_tour = two_level_list(nodes);
+		M_order.reserve(nodes);
+		M_route_of.resize(nodes);
+		M_anchored.resize(nodes);
+		M_anchors.reserve(2 * M_customers);
+		M_lifted.reserve(M_customers);
+		M_queue.resize(nodes);
+		M_queued.resize(nodes);
+	}
+
+	// applies improving moves until none of the candidate lists improves the solution, returns the cost saved
+	// only the routes that changed are rewritten, through the solution's own modifications
+	double improve(basic_solution<Graph> &solution)
+	{
+		double before = solution.cost();
+		load(solution);
+
+		// a move only requeues the stops at its ends, while a reversal also gives the stops inside it new neighbors on the
+		// tour, so passes over every customer repeat until one of them finds nothing
+		for (std::size_t moves = M_moves - 1; moves != M_moves;)
+		{
+			moves = M_moves;
+			for (std::size_t c = 1; c < M_customers; ++c)
+				activate(static_cast<std::uint32_t>(c));
+			while (M_queue_size)
+			{
+				std::uint32_t u = M_queue[M_queue_head];
+				M_queue_head = (M_queue_head + 1) % M_queue.size();
+				--M_queue_size;
+				M_queued[u] = 0;
+
+				for (std::uint32_t v : M_neighbors->van(u))
+				{
+					if (v == 0 || !M_tour.contains(v))
+						continue;
+					if (try_pair(u, v))
+					{
+						++M_moves;
+						activate(u);
+						break;
+					}
+				}
+			}
+		}
+
+		store(solution);
+		return before - solution.cost();
+	}
+
+	// moves applied over every call
+	std::size_t moves() const { return M_moves; }
+
+private:
+	// a truck route of the solution, with its cost and load as they change during the search
+	struct slot
+	{
+		vehicle_type type;
+		std::uint32_t route;
+		double capacity, max_range;
+		double load = 0, cost = 0;
+		std::uint32_t anchors_begin = 0, anchors_end = 0; // its sortie stops in M_anchors
+		bool dirty = false;
+	};
+
+	static constexpr double epsilon = 1e-9;
+
+	const Graph *M_graph;
+	const neighbor_lists *M_neighbors;
+	std::size_t M_customers; // node ids below are customers, node M_customers + s is the depot copy that starts slot s
+
+	std::vector<slot> M_slots;
+	two_level_list M_tour;
+	std::vector<std::uint32_t> M_order; // scratch to build the tour
+	std::vector<std::uint32_t> M_route_of; // indexed by node
+	std::vector<std::uint8_t> M_anchored; // truck stops sorties depart from or return to, indexed by node
+	std::vector<std::uint32_t> M_anchors;
+	std::vector<drone_node> M_lifted; // sorties of the routes store rewrites, in the order of the routes
+	std::size_t M_moves;
+
+	// customers to look at, each at most once, as a ring buffer
+	std::vector<std::uint32_t> M_queue;
+	std::vector<std::uint8_t> M_queued;
+	std::size_t M_queue_head, M_queue_size;
+
+	bool customer(std::uint32_t node) const { return node < M_customers; }
+	std::uint32_t depot(std::size_t s) const { return static_cast<std::uint32_t>(M_customers + s); }
+	double distance(std::uint32_t a, std::uint32_t b) const { return M_graph->van_distance(customer(a) ? a : 0, customer(b) ? b : 0); }
+	double demand(std::uint32_t node) const { return customer(node) ? M_graph->customers().node(node).demand() : 0; }
+	// a customer that can leave its place without reordering the stops of a sortie
+	bool movable(std::uint32_t node) const { return customer(node) && !M_anchored[node]; }
+
+	// puts node back in the queue
+	void activate(std::uint32_t node)
+	{
+		if (!customer(node) || M_queued[node] || !M_tour.contains(node))
+			return;
+		M_queued[node] = 1;
+		M_queue[(M_queue_head + M_queue_size) % M_queue.size()] = node;
+		++M_queue_size;
+	}
+
+	// whether a route can end up with load and cost, a route already over its limits may still get better
+	bool allowed(const slot &s, double load, double cost) const
+	{
+		return (load <= s.capacity || load <= s.load) && (cost <= s.max_range + epsilon || cost <= s.cost);
+	}
+
+	// whether a comes before b on their route
+	bool before(std::uint32_t a, std::uint32_t b) const { return M_tour.between(depot(M_route_of[a]), a, b); }
+
+	void load(const basic_solution<Graph> &solution)
+	{
+		for (std::uint32_t node : M_anchors)
+			M_anchored[node] = 0;
+		M_anchors.clear();
+		M_order.clear();
+
+		for (std::size_t s = 0; s < M_slots.size(); ++s)
+		{
+			slot &sl = M_slots[s];
+			sl.dirty = false;
+			M_order.push_back(depot(s));
+			M_route_of[depot(s)] = static_cast<std::uint32_t>(s);
+			basic_solution<Graph>::for_each_type([&](auto type)
+			{
+				if constexpr (type != vehicle_type::drone)
+				{
+					if (type != sl.type)
+						return;
+					const auto &route = solution.template route<type>(sl.route);
+					sl.load = route.load();
+					sl.cost = route.distance_from(0);
+					for (std::size_t i = 1; i < route.size(); ++i)
+					{
+						std::uint32_t c;
+						if constexpr (type == vehicle_type::truck_drone)
+							c = static_cast<std::uint32_t>(route.truck_stop(i));
+						else
+							c = static_cast<std::uint32_t>(route[i]);
+						M_order.push_back(c);
+						M_route_of[c] = static_cast<std::uint32_t>(s);
+					}
+
+					sl.anchors_begin = static_cast<std::uint32_t>(M_anchors.size());
+					if constexpr (type == vehicle_type::truck_drone)
+					{
+						for (std::size_t k = 0; k < route.size_rendevous(); ++k)
+						{
+							M_anchors.push_back(route.rendevous(k).departure);
+							M_anchors.push_back(route.rendevous(k).reunion);
+						}
+					}
+					sl.anchors_end = static_cast<std::uint32_t>(M_anchors.size());
+				}
+			});
+		}
+
+		for (std::uint32_t node : M_anchors)
+			M_anchored[node] = 1;
+		M_tour.assign(M_order);
+	}
+
+	// rewrites the routes that changed, all are emptied before any is refilled since customers moved between them
+	// the sorties of a truck_drone route are lifted off first and flown again from the same stops once it is refilled,
+	// since a stop must not leave its route while a sortie departs from or returns to it
+	void store(basic_solution<Graph> &solution)
+	{
+		M_lifted.clear();
+		for_each_dirty([&](auto type, std::size_t route, std::size_t)
+		{
+			if constexpr (type == vehicle_type::truck_drone)
+			{
+				const auto &r = solution.template route<type>(route);
+				for (std::size_t k = 0; k < r.size_rendevous(); ++k)
+					M_lifted.push_back(r.rendevous(k));
+				for (std::size_t k = r.size_rendevous(); k-- > 0;)
+					solution.template remove_rendevous<type>(route, k);
+			}
+			for (std::size_t i = solution.template route<type>(route).size(); i-- > 1;)
+				solution.template remove<type>(route, i);
+		});
+		for_each_dirty([&](auto type, std::size_t route, std::size_t s)
+		{
+			std::size_t index = 1;
+			for (std::uint32_t node = M_tour.next(depot(s)); customer(node); node = M_tour.next(node))
+				solution.template insert<type>(route, index++, node);
+		});
+
+		std::size_t next = 0;
+		for_each_dirty([&](auto type, std::size_t route, std::size_t s)
+		{
+			if constexpr (type == vehicle_type::truck_drone)
+				for (std::uint32_t k = M_slots[s].anchors_begin; k < M_slots[s].anchors_end; k += 2, ++next)
+					solution.template insert_rendevous<type>(route, M_lifted[next].departure, M_lifted[next].service, M_lifted[next].reunion);
+		});
+	}
+
+	// calls fn(type, route, slot) for every slot that changed
+	template <typename Fn>
+	void for_each_dirty(Fn &&fn)
+	{
+		for (std::size_t s = 0; s < M_slots.size(); ++s)
+		{
+			if (!M_slots[s].dirty)
+				continue;
+			basic_solution<Graph>::for_each_type([&](auto type)
+			{
+				if constexpr (type != vehicle_type::drone)
+					if (type == M_slots[s].type)
+						fn(type, M_slots[s].route, s);
+			});
+		}
+	}
+
+	// the moves that put v next to u, the first improving one is applied
+	bool try_pair(std::uint32_t u, std::uint32_t v)
+	{
+		std::uint32_t pu = M_tour.prev(u), pv = M_tour.prev(v);
+		if (M_route_of[u] == M_route_of[v])
+		{
+			bool forward = before(u, v);
+			if (forward ? two_opt(u, v) || two_opt(pu, pv) : two_opt(v, u) || two_opt(pv, pu))
+				return true;
+		}
+		else if (exchange_tails(u, pv) || exchange_tails(pu, v))
+			return true;
+
+		return move_chains(u, v) || swap(u, M_tour.next(v)) || swap(u, pv);
+	}
+
+	// 2-opt, replaces the edges leaving a and b by (a, b) and their successors' edge, a before b on the same route
+	bool two_opt(std::uint32_t a, std::uint32_t b)
+	{
+		std::uint32_t an = M_tour.next(a), bn = M_tour.next(b);
+		if (an == b || a == b)
+			return false;
+		double delta = distance(a, b) + distance(an, bn) - distance(a, an) - distance(b, bn);
+		if (delta >= -epsilon)
+			return false;
+
+		// the path from an to b is reversed, which may hold at most one anchored stop: with two, such as the departure and
+		// reunion of a sortie, the reversal would swap their order
+		slot &s = M_slots[M_route_of[a]];
+		std::uint32_t inside = 0;
+		for (std::uint32_t k = s.anchors_begin; k < s.anchors_end; ++k)
+		{
+			std::uint32_t stop = M_anchors[k];
+			if (M_tour.between(an, stop, b))
+			{
+				if (inside && inside != stop)
+					return false;
+				inside = stop;
+			}
+		}
+
+		M_tour.reverse(an, b);
+		s.cost += delta;
+		s.dirty = true;
+		for (std::uint32_t node : {a, an, b, bn})
+			activate(node);
+		return true;
+	}
+
+	// distance and load of the customers after node on its route, false if one of them cannot leave its route
+	bool measure_tail(std::uint32_t node, double &length, double &load, std::uint32_t &last) const
+	{
+		length = load = 0;
+		last = node;
+		for (std::uint32_t x = M_tour.next(node); customer(x); x = M_tour.next(x))
+		{
+			if (M_anchored[x])
+				return false;
+			length += distance(x, M_tour.next(x));
+			load += demand(x);
+			last = x;
+		}
+		return true;
+	}
+
+	// 2-opt*, the customers after x and the customers after y change routes, x and y on different routes
+	bool exchange_tails(std::uint32_t x, std::uint32_t y)
+	{
+		std::uint32_t xn = M_tour.next(x), yn = M_tour.next(y);
+		double delta = distance(x, yn) + distance(y, xn) - distance(x, xn) - distance(y, yn);
+		if (delta >= -epsilon)
+			return false;
+
+		double x_length, x_load, y_length, y_load;
+		std::uint32_t x_last, y_last;
+		if (!measure_tail(x, x_length, x_load, x_last) || !measure_tail(y, y_length, y_load, y_last))
+			return false;
+
+		slot &a = M_slots[M_route_of[x]], &b = M_slots[M_route_of[y]];
+		double a_cost = a.cost - distance(x, xn) - x_length + distance(x, yn) + y_length;
+		double b_cost = b.cost - distance(y, yn) - y_length + distance(y, xn) + x_length;
+		double a_load = a.load - x_load + y_load, b_load = b.load - y_load + x_load;
+		if (!allowed(a, a_load, a_cost) || !allowed(b, b_load, b_cost))
+			return false;
+
+		bool x_tail = x_last != x, y_tail = y_last != y;
+		for (std::uint32_t node = xn; x_tail && customer(node); node = M_tour.next(node))
+			M_route_of[node] = M_route_of[y];
+		for (std::uint32_t node = yn; y_tail && customer(node); node = M_tour.next(node))
+			M_route_of[node] = M_route_of[x];
+
+		// the tour reads x P W Q from x on, with P and Q the tails and W everything from the end of P to y
+		std::uint32_t w_first = x_tail ? M_tour.next(x_last) : xn;
+		if (x_tail && y_tail)
+		{
+			M_tour.reverse(xn, y_last);
+			M_tour.reverse(y_last, yn);
+			M_tour.reverse(y, w_first);
+			M_tour.reverse(x_last, xn);
+		}
+		else if (y_tail)
+		{
+			M_tour.reverse(w_first, y_last);
+			M_tour.reverse(y_last, yn);
+			M_tour.reverse(y, w_first);
+		}
+		else
+		{
+			M_tour.reverse(xn, y);
+			M_tour.reverse(y, w_first);
+			M_tour.reverse(x_last, xn);
+		}
+
+		a.cost = a_cost;
+		a.load = a_load;
+		b.cost = b_cost;
+		b.load = b_load;
+		a.dirty = b.dirty = true;
+		for (std::uint32_t node : {x, xn, y, yn})
+			activate(node);
+		return true;
+	}
+
+	// Or-opt and relocate, moves a chain of up to three customers ending at u next to v, reversed if that puts u next to v
+	bool move_chains(std::uint32_t u, std::uint32_t v)
+	{
+		if (!movable(u))
+			return false;
+
+		std::array<std::uint32_t, 3> chain{u, u, u};
+		for (bool forward : {true, false})
+		{
+			for (std::size_t length = 1; length <= chain.size(); ++length)
+			{
+				if (length > 1)
+				{
+					std::uint32_t end = forward ? M_tour.next(chain[length - 2]) : M_tour.prev(chain[length - 2]);
+					if (!movable(end))
+						break;
+					chain[length - 1] = end;
+				}
+				else if (!forward) // u alone was tried going forward
+					continue;
+
+				std::uint32_t first = forward ? u : chain[length - 1], last = forward ? chain[length - 1] : u;
+				auto in_chain = [&](std::uint32_t node) { return std::find(chain.begin(), chain.begin() + length, node) != chain.begin() + length; };
+				if (in_chain(v))
+					break;
+
+				// after v with u first, or before v with u last
+				std::uint32_t pv = M_tour.prev(v), nv = M_tour.next(v);
+				if ((!in_chain(nv) && move_chain(first, last, v, nv, u != first)) ||
+					(!in_chain(pv) && move_chain(first, last, pv, v, u != last)))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	// moves the chain from first forward to last between t and tn, reversed if reversed
+	bool move_chain(std::uint32_t first, std::uint32_t last, std::uint32_t t, std::uint32_t tn, bool reversed)
+	{
+		std::uint32_t p = M_tour.prev(first), n = M_tour.next(last);
+		double removal = distance(p, n) - distance(p, first) - distance(last, n);
+		double insertion = (reversed ? distance(t, last) + distance(first, tn) : distance(t, first) + distance(last, tn)) - distance(t, tn);
+		if (removal + insertion >= -epsilon)
+			return false;
+
+		slot &from = M_slots[M_route_of[first]], &to = M_slots[M_route_of[t]];
+		if (&from == &to)
+			from.cost += removal + insertion;
+		else
+		{
+			// the chain takes its own edges along to the other route
+			double load = 0, length = 0;
+			for (std::uint32_t node = first; ; node = M_tour.next(node))
+			{
+				load += demand(node);
+				if (node == last)
+					break;
+				length += distance(node, M_tour.next(node));
+			}
+			if (!allowed(to, to.load + load, to.cost + insertion + length) || !allowed(from, from.load - load, from.cost + removal - length))
+				return false;
+			for (std::uint32_t node = first; ; node = M_tour.next(node))
+			{
+				M_route_of[node] = M_route_of[t];
+				if (node == last)
+					break;
+			}
+			from.load -= load;
+			from.cost += removal - length;
+			to.load += load;
+			to.cost += insertion + length;
+		}
+
+		// from first on the tour reads S M with M ending at t, reversing both and then M alone leaves M S reversed
+		M_tour.reverse(first, t);
+		M_tour.reverse(t, n);
+		if (!reversed)
+			M_tour.reverse(last, first);
+
+		from.dirty = to.dirty = true;
+		for (std::uint32_t node : {p, n, t, tn, first, last})
+			activate(node);
+		return true;
+	}
+
+	// swap, u and w exchange places
+	bool swap(std::uint32_t u, std::uint32_t w)
+	{
+		if (u == w || !movable(u) || !movable(w))
+			return false;
+		std::uint32_t pu = M_tour.prev(u), nu = M_tour.next(u), pw = M_tour.prev(w), nw = M_tour.next(w);
+		if (nu == w || pu == w) // adjacent customers are 2-opt and Or-opt moves
+			return false;
+
+		double u_delta = distance(pu, w) + distance(w, nu) - distance(pu, u) - distance(u, nu);
+		double w_delta = distance(pw, u) + distance(u, nw) - distance(pw, w) - distance(w, nw);
+		if (u_delta + w_delta >= -epsilon)
+			return false;
+
+		slot &a = M_slots[M_route_of[u]], &b = M_slots[M_route_of[w]];
+		if (&a == &b)
+			a.cost += u_delta + w_delta;
+		else
+		{
+			double difference = demand(w) - demand(u);
+			if (!allowed(a, a.load + difference, a.cost + u_delta) || !allowed(b, b.load - difference, b.cost + w_delta))
+				return false;
+			a.load += difference;
+			a.cost += u_delta;
+			b.load -= difference;
+			b.cost += w_delta;
+			std::swap(M_route_of[u], M_route_of[w]);
+		}
+
+		M_tour.swap(u, w);
+		a.dirty = b.dirty = true;
+		for (std::uint32_t node : {pu, nu, pw, nw, u, w})
+			activate(node);
+		return true;
+	}
+};
+
+using local_search = basic_local_search<graph>;
+
+VRP_END
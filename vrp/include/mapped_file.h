@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string_view>
+
+#include "macro.h"
+
+VRP_BEG
+
+// read only memory mapping of a whole file, pages are loaded on first touch and shared with every other process that
+// maps the same file, so reading through it copies nothing into the process
+class mapped_file
+{
+public:
+	mapped_file() : M_data{}, M_size{} {}
+	// throws std::runtime_error if path cannot be opened or mapped
+	explicit mapped_file(const std::filesystem::path &path);
+	~mapped_file();
+
+	mapped_file(mapped_file &&other) noexcept;
+	mapped_file &operator=(mapped_file &&other) noexcept;
+	mapped_file(const mapped_file &) = delete;
+	mapped_file &operator=(const mapped_file &) = delete;
+
+	std::span<const std::byte> bytes() const { return {static_cast<const std::byte *>(M_data), M_size}; }
+	std::string_view text() const { return {static_cast<const char *>(M_data), M_size}; }
+	std::size_t size() const { return M_size; }
+	bool empty() const { return M_size == 0; }
+
+private:
+	void *M_data;
+	std::size_t M_size;
+};
+
+// replaces the file at path by what write writes, atomically: write fills a new file of its own next to path, named after
+// it, the process id and a random suffix, which is synced to the disk and then renamed over path. concurrent writers of
+// the same path each publish a whole file and readers only ever see a whole one. the new file is removed if write
+// throws, which is thrown again. throws std::runtime_error if the file cannot be created, written or synced
+void write_replacing(const std::filesystem::path &path, const std::function<void(std::ostream &)> &write);
+
+VRP_END
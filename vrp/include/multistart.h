@@ -0,0 +1,133 @@
+#pragma once
+#include "alns.h"
+#include "parallel.h"
+
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+VRP_BEG
+
+// seed of the search at index, spread by splitmix64 so neighboring indices give unrelated streams
+constexpr std::uint64_t derive_seed(std::uint64_t seed, std::size_t index)
+{
+	return mix_bits(seed + (static_cast<std::uint64_t>(index) + 1) * 0x9e3779b97f4a7c15ull);
+}
+
+// throws std::invalid_argument unless checkpoint was taken by searches searches on a graph of customers nodes
+inline void check_checkpoint(const run_checkpoint &checkpoint, std::size_t customers, std::size_t searches)
+{
+	if (checkpoint.customers != customers || checkpoint.searches.size() != searches)
+		throw std::invalid_argument("Checkpoint was taken on another graph or with another number of searches");
+}
+
+// what one search of a parallel run did
+struct search_report
+{
+	std::uint64_t seed;
+	alns_statistics statistics;
+	double best_objective;
+};
+
+// independent ALNS searches on one thread each, all reading the same graph, which must be safe to read concurrently
+// (basic_graph is, lazy_graph is not). each search owns its solutions and scratch, they only share the incumbent
+template <graph_backend Graph>
+class basic_multistart
+{
+public:
+	// thread_count searches (0 for one per core), search i is seeded with derive_seed(parameters.seed, i)
+	basic_multistart(const Graph &graph, const fleet_info &fleet, const alns_parameters &parameters, std::size_t thread_count) :
+		M_graph{&graph}, M_fleet{&fleet}, M_parameters{parameters}, M_searches(thread_count ? thread_count : default_thread_count()), M_reports(M_searches.size()), M_indexes(graph, fleet, parameters, M_searches.size()), M_best{}
+	{
+	}
+
+	// runs parameters.iterations iterations in every search within parameters.time_limit, each search is built on the
+	// thread that runs it
+	void run()
+	{
+		auto deadline = basic_alns<Graph>::deadline(M_parameters, std::chrono::steady_clock::now());
+		{
+			std::vector<std::jthread> threads;
+			threads.reserve(M_searches.size());
+			for (std::size_t i = 0; i < M_searches.size(); ++i)
+			{
+				threads.emplace_back([this, i, deadline]()
+				{
+					alns_parameters parameters = M_parameters;
+					parameters.seed = derive_seed(M_parameters.seed, i);
+					auto &search = M_searches[i];
+					if (!search)
+					{
+						search = std::make_unique<basic_alns<Graph>>(*M_graph, *M_fleet, parameters, &M_indexes);
+						search->publish_to(M_incumbent);
+					}
+
+					std::size_t iterations = parameters.iterations;
+					if (!M_resume.searches.empty() && !M_resume.searches[i].empty())
+					{
+						search->restore(M_resume.searches[i]);
+						iterations -= std::min(search->iteration(), iterations);
+					}
+					if (M_checkpoint)
+						search->checkpoint_to(*M_checkpoint, i);
+
+					alns_statistics statistics = search->run(iterations, deadline);
+					search->checkpoint();
+					M_reports[i] = {.seed = parameters.seed, .statistics = statistics, .best_objective = search->best_objective()};
+				});
+			}
+		}
+		M_resume.searches.clear();
+
+		M_best = 0;
+		for (std::size_t i = 1; i < M_searches.size(); ++i)
+			if (M_reports[i].best_objective < M_reports[M_best].best_objective)
+				M_best = i;
+	}
+
+	// the next run continues every search from checkpoint and runs what is left of its parameters.iterations
+	void resume(run_checkpoint checkpoint)
+	{
+		check_checkpoint(checkpoint, M_graph->size(), M_searches.size());
+		M_resume = std::move(checkpoint);
+	}
+	// every search hands its state to writer every parameters.checkpoint_interval iterations and when a run ends, the
+	// writer must outlive the searches and hold thread_count() searches
+	void checkpoint_to(checkpoint_writer &writer) { M_checkpoint = &writer; }
+
+	std::size_t thread_count() const { return M_searches.size(); }
+	std::span<const search_report> reports() const { return M_reports; }
+
+	// objective of the best solution found by any search, readable while the searches run
+	double best_objective() const { return M_incumbent.objective(); }
+	// copy of the best solution found by any search, readable while the searches run, empty before any was found
+	basic_solution<Graph> incumbent() const
+	{
+		basic_solution<Graph> res(*M_graph, *M_fleet);
+		std::vector<std::uint32_t> routes;
+		if (M_incumbent.snapshot(routes) < std::numeric_limits<double>::infinity())
+			read_routes(res, routes);
+		return res;
+	}
+	// best solution over every search, after run
+	const basic_solution<Graph> &best() const { return M_searches[M_best]->best(); }
+	const basic_alns<Graph> &search(std::size_t index) const { return *M_searches[index]; }
+
+private:
+	const Graph *M_graph;
+	const fleet_info *M_fleet;
+	alns_parameters M_parameters;
+
+	std::vector<std::unique_ptr<basic_alns<Graph>>> M_searches; // each on its own allocation, so searches do not share cache lines
+	std::vector<search_report> M_reports;
+	search_indexes M_indexes; // built once on every thread and shared by the searches
+	shared_incumbent M_incumbent;
+	run_checkpoint M_resume; // states the next run starts from, empty for none
+	checkpoint_writer *M_checkpoint = nullptr;
+	std::size_t M_best;
+};
+
+using multistart = basic_multistart<graph>;
+
+VRP_END
@@ -0,0 +1,186 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "macro.h"
+
+VRP_BEG
+
+// number of threads used when 0 is requested
+inline std::size_t default_thread_count()
+{
+	return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+// calls fn(i) for every i in [begin, end) across thread_count threads (0 for all cores)
+// indices are handed out in chunks of chunk_size so uneven work per index balances itself
+template <typename Fn>
+void parallel_for(std::size_t begin, std::size_t end, Fn &&fn, std::size_t thread_count = 0, std::size_t chunk_size = 16)
+{
+	if (begin >= end)
+		return;
+
+	if (thread_count == 0)
+		thread_count = default_thread_count();
+	thread_count = std::min(thread_count, (end - begin + chunk_size - 1) / chunk_size);
+
+	std::atomic<std::size_t> next{begin};
+	auto work = [&]()
+	{
+		for (std::size_t chunk = next.fetch_add(chunk_size, std::memory_order_relaxed); chunk < end; chunk = next.fetch_add(chunk_size, std::memory_order_relaxed))
+			for (std::size_t i = chunk, last = std::min(chunk + chunk_size, end); i < last; ++i)
+				fn(i);
+	};
+
+	if (thread_count <= 1)
+	{
+		work();
+		return;
+	}
+
+	std::vector<std::jthread> threads;
+	threads.reserve(thread_count - 1);
+	for (std::size_t t = 1; t < thread_count; ++t)
+		threads.emplace_back(work);
+	work();
+}
+
+// persistent threads that split index ranges between them, for parallel loops too short to pay for starting threads
+// every participant starts on its own share of the range and, once it runs out, steals half of what is left of another
+// participant's share, so uneven work per index balances itself without a shared counter
+class work_stealing_pool
+{
+public:
+	// thread_count participants including the thread calling run (0 for all cores)
+	explicit work_stealing_pool(std::size_t thread_count) :
+		M_shares(thread_count ? thread_count : default_thread_count()), M_generation{0}, M_pending{0}, M_stop{false}, M_call{}, M_context{}
+	{
+		M_threads.reserve(M_shares.size() - 1);
+		for (std::size_t p = 1; p < M_shares.size(); ++p)
+			M_threads.emplace_back([this, p]() { work_loop(p); });
+	}
+	work_stealing_pool(const work_stealing_pool &) = delete;
+	work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+	~work_stealing_pool()
+	{
+		M_stop.store(true, std::memory_order_relaxed);
+		M_generation.fetch_add(1, std::memory_order_release);
+		M_generation.notify_all();
+		M_threads.clear(); // joined before the state they wait on is destroyed
+	}
+
+	std::size_t thread_count() const { return M_shares.size(); }
+
+	// calls fn(i) for every i in [0, count) and returns once every call has returned, does not allocate
+	template <typename Fn>
+	void run(std::size_t count, Fn &&fn)
+	{
+		using function = std::remove_reference_t<Fn>;
+		if (M_threads.empty() || count < 2)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+				fn(i);
+			return;
+		}
+
+		std::size_t parts = M_shares.size();
+		for (std::size_t p = 0; p < parts; ++p)
+			M_shares[p].range.store(pack(count * p / parts, count * (p + 1) / parts), std::memory_order_relaxed);
+		M_context = const_cast<void *>(static_cast<const void *>(&fn));
+		M_call = [](void *context, std::size_t i) { (*static_cast<function *>(context))(i); };
+		M_pending.store(parts - 1, std::memory_order_relaxed);
+
+		M_generation.fetch_add(1, std::memory_order_release);
+		M_generation.notify_all();
+		work(0);
+
+		for (std::size_t pending = M_pending.load(std::memory_order_acquire); pending; pending = M_pending.load(std::memory_order_acquire))
+			M_pending.wait(pending, std::memory_order_acquire);
+	}
+
+private:
+	struct alignas(64) share
+	{
+		std::atomic<std::uint64_t> range; // first index in the high half, one past the last in the low half
+	};
+
+	std::vector<share> M_shares;
+	std::vector<std::jthread> M_threads;
+	std::atomic<std::uint64_t> M_generation; // bumped to start a run or to stop
+	std::atomic<std::size_t> M_pending; // workers still in the current run
+	std::atomic<bool> M_stop;
+	void (*M_call)(void *, std::size_t);
+	void *M_context;
+
+	static constexpr std::uint64_t pack(std::uint64_t begin, std::uint64_t end) { return begin << 32 | end; }
+	static constexpr std::uint64_t begin_of(std::uint64_t range) { return range >> 32; }
+	static constexpr std::uint64_t end_of(std::uint64_t range) { return range & 0xffffffff; }
+
+	void work_loop(std::size_t participant)
+	{
+		std::uint64_t seen = 0;
+		for (;;)
+		{
+			M_generation.wait(seen, std::memory_order_acquire);
+			seen = M_generation.load(std::memory_order_acquire);
+			if (M_stop.load(std::memory_order_relaxed))
+				return;
+			work(participant);
+			if (M_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				M_pending.notify_one();
+		}
+	}
+
+	void work(std::size_t participant)
+	{
+		std::size_t index;
+		while (next(participant, index))
+			M_call(M_context, index);
+	}
+
+	// takes the first index of the participant's share, stealing into it when it is empty
+	bool next(std::size_t participant, std::size_t &index)
+	{
+		std::atomic<std::uint64_t> &own = M_shares[participant].range;
+		for (;;)
+		{
+			std::uint64_t range = own.load(std::memory_order_acquire);
+			while (begin_of(range) < end_of(range))
+			{
+				if (own.compare_exchange_weak(range, pack(begin_of(range) + 1, end_of(range)), std::memory_order_acq_rel))
+				{
+					index = begin_of(range);
+					return true;
+				}
+			}
+			if (!steal(participant))
+				return false;
+		}
+	}
+
+	// moves the back half of another participant's share into the empty share of participant
+	bool steal(std::size_t participant)
+	{
+		for (std::size_t offset = 1; offset < M_shares.size(); ++offset)
+		{
+			std::atomic<std::uint64_t> &victim = M_shares[(participant + offset) % M_shares.size()].range;
+			std::uint64_t range = victim.load(std::memory_order_acquire);
+			while (begin_of(range) < end_of(range))
+			{
+				std::uint64_t half = (end_of(range) - begin_of(range) + 1) / 2;
+				if (victim.compare_exchange_weak(range, pack(begin_of(range), end_of(range) - half), std::memory_order_acq_rel))
+				{
+					M_shares[participant].range.store(pack(end_of(range) - half, end_of(range)), std::memory_order_release);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+};
+
+VRP_END
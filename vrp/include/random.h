@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "macro.h"
+
+VRP_BEG
+
+// xoshiro256** random generator, a uniform random bit generator whose whole state is four words that can be copied in
+// and out directly, so a checkpoint saves it without formatting anything
+class xoshiro256
+{
+public:
+	using result_type = std::uint64_t;
+	using state_type = std::array<std::uint64_t, 4>;
+
+	// the state is expanded from seed by splitmix64, so close seeds still give unrelated sequences
+	explicit xoshiro256(std::uint64_t seed = 0)
+	{
+		for (std::uint64_t &word : M_state)
+		{
+			seed += 0x9e3779b97f4a7c15;
+			std::uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			word = z ^ (z >> 31);
+		}
+	}
+	// the state must not be all zeros, which no seed produces
+	explicit xoshiro256(const state_type &state) : M_state{state} {}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()()
+	{
+		result_type res = rotate(M_state[1] * 5, 7) * 9;
+		std::uint64_t t = M_state[1] << 17;
+		M_state[2] ^= M_state[0];
+		M_state[3] ^= M_state[1];
+		M_state[1] ^= M_state[2];
+		M_state[0] ^= M_state[3];
+		M_state[2] ^= t;
+		M_state[3] = rotate(M_state[3], 45);
+		return res;
+	}
+
+	const state_type &state() const { return M_state; }
+
+	bool operator==(const xoshiro256 &) const = default;
+
+private:
+	state_type M_state;
+
+	static std::uint64_t rotate(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+VRP_END
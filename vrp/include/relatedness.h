@@ -0,0 +1,93 @@
+#pragma once
+#include "graph.h"
+#include "parallel.h"
+#include "spatial.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+VRP_BEG
+
+// the k customers most related to each customer (Shaw), most related first, in one flat array
+// relatedness of i and j is distance_weight * d(i, j) / max d + demand_weight * |q_i - q_j| / max |q_a - q_b|, lower is more related
+// each list is the k most related of the candidates nearest customers by van distance, found through a spatial grid, so
+// the index is built in about O(n candidates log candidates) rather than by scoring every pair. a customer further away
+// than all of them could only be more related through a much closer demand, which the distance weight rarely repays.
+// the depot is in no list and its own list is empty
+class relatedness_index
+{
+public:
+	relatedness_index() : M_k{} {}
+	// k is clamped to the number of other customers, candidates to at least k (0 for 4 k). lists are built in parallel by
+	// thread_count threads (0 for all cores) so the graph must be safe to read concurrently unless thread_count is 1.
+	// van distances must be manhattan over the customer positions
+	template <graph_backend Graph>
+	relatedness_index(const Graph &graph, std::size_t k, std::size_t thread_count = 0, std::size_t candidates = 0, double distance_weight = 9, double demand_weight = 2) :
+		M_k{std::min(k, graph.size() > 2 ? graph.size() - 2 : 0)}
+	{
+		std::size_t n = graph.size();
+		M_lists.resize(n * M_k);
+		if (M_k == 0)
+			return;
+		candidates = std::clamp(candidates ? candidates : 4 * M_k, M_k, n - 2);
+
+		const customer_info &customers = graph.customers();
+		position_view positions = customers.positions();
+		double min_demand = customers.node(1).demand(), max_demand = min_demand;
+		// the largest manhattan distance is the widest spread of x + y or of x - y, one pass instead of every pair
+		double min_sum = positions.x[1] + positions.y[1], max_sum = min_sum;
+		double min_difference = positions.x[1] - positions.y[1], max_difference = min_difference;
+		for (std::size_t i = 2; i < n; ++i)
+		{
+			min_demand = std::min(min_demand, customers.node(i).demand());
+			max_demand = std::max(max_demand, customers.node(i).demand());
+			min_sum = std::min(min_sum, positions.x[i] + positions.y[i]);
+			max_sum = std::max(max_sum, positions.x[i] + positions.y[i]);
+			min_difference = std::min(min_difference, positions.x[i] - positions.y[i]);
+			max_difference = std::max(max_difference, positions.x[i] - positions.y[i]);
+		}
+
+		double distance_scale = distance_weight / std::max(std::max(max_sum - min_sum, max_difference - min_difference), 1e-12);
+		double demand_scale = demand_weight / std::max(max_demand - min_demand, 1e-12);
+
+		spatial_grid grid(positions);
+		parallel_for(1, n, [&](std::size_t i)
+		{
+			thread_local std::vector<std::uint32_t> nearest;
+			thread_local std::vector<std::pair<double, std::uint32_t>> scores;
+			nearest.resize(candidates);
+			scores.clear();
+			std::size_t found = grid.nearest_customers<distance_type::manhattan>(i, candidates, nearest.data());
+
+			double demand = customers.node(i).demand();
+			for (std::size_t r = 0; r < found; ++r)
+				scores.emplace_back(distance_scale * graph.van_distance(i, nearest[r]) + demand_scale * std::abs(demand - customers.node(nearest[r]).demand()), nearest[r]);
+
+			std::ranges::partial_sort(scores, scores.begin() + M_k); // ties go to the lower index
+			std::uint32_t *list = M_lists.data() + i * M_k;
+			for (std::size_t r = 0; r < M_k; ++r)
+				list[r] = scores[r].second;
+		}, thread_count);
+	}
+
+	std::size_t k() const { return M_k; }
+	bool empty() const { return M_lists.empty(); }
+
+	std::span<const std::uint32_t> related(std::size_t customer) const
+	{
+		if (customer == 0)
+			return {};
+		return {M_lists.data() + customer * M_k, M_k};
+	}
+
+	std::size_t memory_usage() const { return M_lists.size() * sizeof(std::uint32_t); }
+
+private:
+	std::size_t M_k;
+	std::vector<std::uint32_t> M_lists;
+};
+
+VRP_END
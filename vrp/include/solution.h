@@ -0,0 +1,575 @@
+#pragma once
+#include "graph.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+
+VRP_BEG
+
+// where a customer is served
+struct customer_location
+{
+	static constexpr std::uint32_t unrouted = static_cast<std::uint32_t>(-1);
+
+	vehicle_type type;
+	bool sortie; // served by the drone of a truck_drone route, index is then the rendevous index
+	bool flying; // a truck stop of a truck_drone route whose drone flies over the leg from it to the next stop
+	std::uint32_t route;
+	std::uint32_t index; // position in the route
+
+	constexpr bool routed() const { return route != unrouted; }
+};
+
+// owns every route of a fleet, grouped by vehicle type in contiguous per type storage
+// the stops of every route live in the solution's route_arenas, so copying a solution copies a few buffers
+// routes are modified through the solution so that the cached costs stay up to date
+template <graph_backend Graph>
+class basic_solution
+{
+public:
+	using graph_type = Graph;
+
+	template <vehicle_type type>
+	using route_type = vehicle_route<type, Graph>;
+
+	static constexpr std::array<vehicle_type, 5> types{vehicle_type::base, vehicle_type::autonomous, vehicle_type::van, vehicle_type::drone, vehicle_type::truck_drone};
+
+	basic_solution() : M_graph{}, M_fleet{}, M_arenas{}, M_spare{}, M_routes{}, M_type_cost{}, M_cost{}, M_hash{} {}
+	basic_solution(const Graph &graph, const fleet_info &fleet) :
+		M_graph{&graph}, M_fleet{&fleet}, M_arenas{std::make_unique<route_arenas>()}, M_spare{}, M_routes{}, M_type_cost{}, M_cost{0}, M_hash{}
+	{
+		make_routes();
+		M_locations.assign(graph.size(), unrouted_location);
+	}
+
+	basic_solution(const basic_solution &other) :
+		M_graph{other.M_graph}, M_fleet{other.M_fleet},
+		M_arenas{other.M_arenas ? std::make_unique<route_arenas>(*other.M_arenas) : nullptr}, M_spare{},
+		M_routes{}, M_type_cost{other.M_type_cost}, M_cost{other.M_cost}, M_hash{other.M_hash},
+		M_locations{other.M_locations}, M_journal{other.M_journal}, M_recording{other.M_recording}
+	{
+		rebind_routes(other);
+	}
+	basic_solution(basic_solution &&) noexcept = default;
+
+	// reuses this solution's buffers, so copying into a scratch solution does not allocate once it is large enough
+	basic_solution &operator=(const basic_solution &other)
+	{
+		if (this == &other)
+			return *this;
+
+		M_graph = other.M_graph;
+		M_fleet = other.M_fleet;
+		if (!other.M_arenas)
+			M_arenas.reset();
+		else if (M_arenas)
+			*M_arenas = *other.M_arenas;
+		else
+			M_arenas = std::make_unique<route_arenas>(*other.M_arenas);
+		rebind_routes(other);
+		M_type_cost = other.M_type_cost;
+		M_cost = other.M_cost;
+		M_hash = other.M_hash;
+		M_locations = other.M_locations;
+		M_journal = other.M_journal;
+		M_recording = other.M_recording;
+		return *this;
+	}
+	basic_solution &operator=(basic_solution &&) noexcept = default;
+
+	const Graph &graph() const { return *M_graph; }
+	const fleet_info &fleet() const { return *M_fleet; }
+
+	template <vehicle_type type>
+	std::span<const route_type<type>> routes() const { return std::get<static_cast<std::size_t>(type)>(M_routes); }
+
+	template <vehicle_type type>
+	const route_type<type> &route(std::size_t index) const
+	{
+		#if DO_CHECKING
+		if (index >= route_count<type>())
+			throw std::out_of_range("Invalid route");
+		#endif
+		return std::get<static_cast<std::size_t>(type)>(M_routes)[index];
+	}
+
+	template <vehicle_type type>
+	std::size_t route_count() const { return std::get<static_cast<std::size_t>(type)>(M_routes).size(); }
+
+	// capacity and range of the vehicles of one type, for the routes' feasibility checks
+	template <vehicle_type type>
+	const vehicle &limits() const { return M_fleet->vehicle_data(type); }
+
+	// total cost of every route
+	double cost() const { return M_cost; }
+	// total cost of the routes of one vehicle type
+	template <vehicle_type type>
+	double cost() const { return M_type_cost[static_cast<std::size_t>(type)]; }
+
+	double manual_cost() const // only for testing. for checking to make sure cost calculation is correct
+	{
+		double sum = 0;
+		for_each_route([&](const auto &route) { sum += route.manual_cost(); });
+		return sum;
+	}
+
+	// zobrist hash of every route, kept up to date in O(1) per modification. equal solutions hash equally, so
+	// different hashes prove two solutions differ and equal ones mean they are the same but for a 2^-64 collision
+	std::uint64_t hash() const { return M_hash; }
+
+	std::uint64_t manual_hash() const // only for testing. for checking to make sure the hash is kept up to date
+	{
+		std::uint64_t res = 0;
+		for_each_type([&](auto type)
+		{
+			for (std::size_t r = 0; r < route_count<type>(); ++r)
+				res ^= route_key(type, r, routes<type>()[r].manual_hash());
+		});
+		return res;
+	}
+
+	// calls fn(std::integral_constant<vehicle_type, type>) for every vehicle type
+	template <typename Fn>
+	static constexpr void for_each_type(Fn &&fn)
+	{
+		[&]<std::size_t... i>(std::index_sequence<i...>) { (fn(std::integral_constant<vehicle_type, types[i]>{}), ...); }(std::make_index_sequence<types.size()>{});
+	}
+
+	// calls fn(route) for every route, fn is instantiated once per route type
+	template <typename Fn>
+	void for_each_route(Fn &&fn) const
+	{
+		for_each_type([&](auto type)
+		{
+			for (const auto &route : routes<type>())
+				fn(route);
+		});
+	}
+
+	// where customer is currently served, kept up to date by every modification
+	const customer_location &location(std::size_t customer) const
+	{
+		#if DO_CHECKING
+		if (customer >= M_locations.size() || customer == 0)
+			throw std::invalid_argument("Invalid customer");
+		#endif
+		return M_locations[customer];
+	}
+	bool routed(std::size_t customer) const { return location(customer).routed(); }
+
+	// whether the drone of a truck_drone route can carry service from truck stop departure to the later truck stop
+	// reunion within its capacity and range while it is not flying another sortie, through the locations of the stops
+	// in O(1) and one look per leg between them
+	bool sortie_feasible(std::size_t route, std::size_t departure, std::size_t service, std::size_t reunion) const
+	{
+		if (departure == 0 || reunion == 0)
+			return false;
+		auto on_route = [&](const customer_location &loc) { return loc.type == vehicle_type::truck_drone && !loc.sortie && loc.route == route; };
+		const customer_location &from = location(departure), &to = location(reunion);
+		if (!on_route(from) || !on_route(to) || from.index >= to.index)
+			return false;
+
+		const auto &r = this->route<vehicle_type::truck_drone>(route);
+		for (std::size_t k = from.index; k < to.index; ++k)
+			if (M_locations[r.truck_stop(k)].flying)
+				return false;
+
+		const vehicle &drone = limits<vehicle_type::drone>();
+		return M_graph->customers().node(service).demand() <= drone.capacity && r.rendevous_delta(departure, service, reunion) <= drone.max_range;
+	}
+
+	// modifications, see the method of the same name of the route
+	// a customer can only be served once, inserting one that is already routed is an error
+	template <vehicle_type type> requires (type != vehicle_type::drone)
+	void insert(std::size_t route, std::size_t index, std::size_t customer)
+	{
+		check_unrouted(customer);
+		record<type>(journal_operation::insert, route, index, customer);
+		modify<type>(route, [&](auto &r) { r.insert(index, customer); });
+		index_stops<type>(route, index);
+		index_flight<type>(route, index);
+	}
+	template <vehicle_type type> requires (type == vehicle_type::drone)
+	void insert(std::size_t route, std::size_t customer)
+	{
+		check_unrouted(customer);
+		std::size_t index = this->route<type>(route).size();
+		record<type>(journal_operation::insert, route, index, customer);
+		modify<type>(route, [&](auto &r) { r.insert(customer); });
+		index_stops<type>(route, index);
+	}
+	template <vehicle_type type>
+	void remove(std::size_t route, std::size_t index)
+	{
+		std::size_t customer = stop<type>(this->route<type>(route), index);
+		record<type>(journal_operation::remove, route, index, customer);
+		modify<type>(route, [&](auto &r) { r.remove(index); });
+		M_locations[customer] = unrouted_location;
+		index_stops<type>(route, index);
+	}
+	// the sortie must be one sortie_feasible accepts, a truck stop it departs from or returns to must not be removed
+	// before it
+	template <vehicle_type type = vehicle_type::truck_drone>
+	void insert_rendevous(std::size_t route, std::size_t departure_customer, std::size_t service_customer, std::size_t reunion_customer)
+	{
+		check_unrouted(service_customer);
+		#if DO_CHECKING
+		if (!sortie_feasible(route, departure_customer, service_customer, reunion_customer))
+			throw std::invalid_argument("Infeasible sortie");
+		#endif
+		std::size_t index = this->route<type>(route).size_rendevous();
+		record<type>(journal_operation::insert_rendevous, route, index, departure_customer, service_customer, reunion_customer);
+		modify<type>(route, [&](auto &r) { r.insert_rendevous(departure_customer, service_customer, reunion_customer); });
+		index_sorties<type>(route, index);
+		mark_flight(route, departure_customer, reunion_customer, true);
+	}
+	template <vehicle_type type = vehicle_type::truck_drone>
+	void remove_rendevous(std::size_t route, std::size_t index)
+	{
+		const auto node = this->route<type>(route).rendevous(index);
+		record<type>(journal_operation::remove_rendevous, route, index, node.departure, node.service, node.reunion);
+		modify<type>(route, [&](auto &r) { r.remove_rendevous(index); });
+		M_locations[node.service] = unrouted_location;
+		index_sorties<type>(route, index);
+		mark_flight(route, node.departure, node.reunion, false);
+	}
+
+	// removes a customer from wherever it is served, found in O(1) through its location
+	void remove_customer(std::size_t customer)
+	{
+		customer_location loc = location(customer);
+		#if DO_CHECKING
+		if (!loc.routed())
+			throw std::invalid_argument("Customer is not routed");
+		#endif
+
+		for_each_type([&](auto type)
+		{
+			if (type != loc.type)
+				return;
+			if constexpr (type == vehicle_type::truck_drone)
+			{
+				if (loc.sortie)
+				{
+					remove_rendevous<type>(loc.route, loc.index);
+					return;
+				}
+			}
+			remove<type>(loc.route, loc.index);
+		});
+	}
+
+	// while recording, every modification is logged so it can be rolled back without copying the solution
+	// the log keeps its capacity between moves, so a steady state of begin/rollback/commit does not allocate
+	void begin_journal()
+	{
+		M_journal.clear();
+		M_recording = true;
+	}
+	// keeps the changes made since begin_journal and stops recording
+	void commit()
+	{
+		M_journal.clear();
+		M_recording = false;
+	}
+	// undoes every change made since begin_journal, most recent first, and stops recording
+	void rollback() { rollback_to(0); M_recording = false; }
+	// undoes the changes after the first mark entries of the journal, recording continues
+	void rollback_to(std::size_t mark)
+	{
+		while (M_journal.size() > mark)
+		{
+			undo(M_journal.back());
+			M_journal.pop_back();
+		}
+	}
+
+	bool recording() const { return M_recording; }
+	std::size_t journal_size() const { return M_journal.size(); }
+	void reserve_journal(std::size_t entries) { M_journal.reserve(entries); }
+
+	// empties every route at once, keeping the storage for the next solution built in place
+	// a default constructed or moved from solution has no routes and is left as it is
+	void clear()
+	{
+		if (!M_arenas)
+			return;
+		M_arenas->clear();
+		make_routes();
+		M_type_cost = {};
+		M_cost = 0;
+		std::ranges::fill(M_locations, unrouted_location);
+		M_journal.clear();
+		M_recording = false;
+	}
+
+	// moves every route into the spare storage, dropping the blocks left behind by routes that grew
+	// the two storages are swapped, so compacting regularly stops allocating once both are large enough
+	void compact()
+	{
+		if (!M_arenas)
+			return;
+		if (!M_spare)
+			M_spare = std::make_unique<route_arenas>();
+		M_spare->clear();
+		M_spare->customers.reserve(M_arenas->customers.size());
+		M_spare->distances.reserve(M_arenas->distances.size());
+		M_spare->sorties.reserve(M_arenas->sorties.size());
+		for_each_type([&](auto type) {
+			for (auto &r : routes_of<type>())
+				r.relocate(*M_spare);
+		});
+		std::swap(M_arenas, M_spare);
+	}
+
+	// elements of route storage in use, including blocks that routes have outgrown
+	std::size_t storage_size() const { return M_arenas ? M_arenas->customers.size() + M_arenas->distances.size() + M_arenas->sorties.size() : 0; }
+	// bytes held by the route storage
+	std::size_t memory_usage() const { return (M_arenas ? M_arenas->memory_usage() : 0) + (M_spare ? M_spare->memory_usage() : 0); }
+
+private:
+	const Graph *M_graph;
+	const fleet_info *M_fleet;
+
+	std::unique_ptr<route_arenas> M_arenas; // behind a pointer so that moving a solution keeps the routes' arena pointers valid
+	std::unique_ptr<route_arenas> M_spare; // target of compact, never copied
+
+	std::tuple<
+		std::vector<route_type<vehicle_type::base>>,
+		std::vector<route_type<vehicle_type::autonomous>>,
+		std::vector<route_type<vehicle_type::van>>,
+		std::vector<route_type<vehicle_type::drone>>,
+		std::vector<route_type<vehicle_type::truck_drone>>
+	> M_routes; // indexed by vehicle_type
+
+	std::array<double, 5> M_type_cost; // indexed by vehicle_type
+	double M_cost;
+	std::uint64_t M_hash; // xor of the route keys of every route
+
+	static constexpr customer_location unrouted_location{vehicle_type::base, false, false, customer_location::unrouted, customer_location::unrouted};
+	std::vector<customer_location> M_locations; // indexed by customer
+
+	void check_unrouted(std::size_t customer) const
+	{
+		#if DO_CHECKING
+		if (routed(customer))
+			throw std::invalid_argument("Customer is already routed");
+		#endif
+	}
+
+	template <vehicle_type type>
+	static std::size_t stop(const route_type<type> &r, std::size_t index)
+	{
+		if constexpr (type == vehicle_type::truck_drone)
+			return r.truck_stop(index);
+		else
+			return r[index];
+	}
+
+	// updates the locations of the stops of a route from index onward, after they shifted. a shifted stop still starts
+	// the same leg, so it keeps its flying mark
+	template <vehicle_type type>
+	void index_stops(std::size_t route, std::size_t index)
+	{
+		const route_type<type> &r = routes_of<type>()[route];
+		for (std::size_t k = index; k < r.size(); ++k)
+		{
+			if (std::size_t customer = stop<type>(r, k); customer != 0) // the depot is the first stop of non drone routes
+			{
+				customer_location &loc = M_locations[customer];
+				loc = {type, false, loc.flying, static_cast<std::uint32_t>(route), static_cast<std::uint32_t>(k)};
+			}
+		}
+	}
+
+	// updates the locations of the customers served by the rendevous of a route from index onward
+	template <vehicle_type type>
+	void index_sorties(std::size_t route, std::size_t index)
+	{
+		const route_type<type> &r = routes_of<type>()[route];
+		for (std::size_t k = index; k < r.size_rendevous(); ++k)
+			M_locations[r.rendevous(k).service] = {type, true, false, static_cast<std::uint32_t>(route), static_cast<std::uint32_t>(k)};
+	}
+
+	// a truck stop inserted at index splits a leg, the drone flies over both halves if it flew over the whole. no sortie
+	// departs from the depot, so the leg after it is never flown
+	template <vehicle_type type>
+	void index_flight(std::size_t route, std::size_t index)
+	{
+		if constexpr (type == vehicle_type::truck_drone)
+		{
+			const route_type<type> &r = routes_of<type>()[route];
+			M_locations[r.truck_stop(index)].flying = index > 1 && M_locations[r.truck_stop(index - 1)].flying;
+		}
+	}
+
+	// marks the legs of a truck_drone route between the stops a sortie departs from and returns to as flown or not
+	void mark_flight(std::size_t route, std::size_t departure, std::size_t reunion, bool flying)
+	{
+		const auto &r = routes_of<vehicle_type::truck_drone>()[route];
+		for (std::size_t k = M_locations[departure].index; k < M_locations[reunion].index; ++k)
+			M_locations[r.truck_stop(k)].flying = flying;
+	}
+
+	enum class journal_operation : std::uint8_t
+	{
+		insert,
+		remove,
+		insert_rendevous,
+		remove_rendevous,
+	};
+
+	struct journal_entry
+	{
+		journal_operation operation;
+		vehicle_type type;
+		std::uint32_t route;
+		std::uint32_t index; // position of the customer or rendevous
+		std::uint32_t customer; // the departure customer for rendevous
+		std::uint32_t service, reunion; // only for rendevous
+		route_cost_state route_cost; // costs before the operation, restored exactly on undo
+		double type_cost, cost;
+	};
+
+	std::vector<journal_entry> M_journal;
+	bool M_recording = false;
+
+	template <vehicle_type type>
+	void record(journal_operation operation, std::size_t route, std::size_t index, std::size_t customer, std::size_t service = 0, std::size_t reunion = 0)
+	{
+		if (!M_recording)
+			return;
+
+		M_journal.push_back({
+			.operation = operation,
+			.type = type,
+			.route = static_cast<std::uint32_t>(route),
+			.index = static_cast<std::uint32_t>(index),
+			.customer = static_cast<std::uint32_t>(customer),
+			.service = static_cast<std::uint32_t>(service),
+			.reunion = static_cast<std::uint32_t>(reunion),
+			.route_cost = this->route<type>(route).cost_state(),
+			.type_cost = M_type_cost[static_cast<std::size_t>(type)],
+			.cost = M_cost,
+		});
+	}
+
+	void undo(const journal_entry &entry)
+	{
+		for_each_type([&](auto type)
+		{
+			if (type == entry.type)
+				undo<type>(entry);
+		});
+	}
+
+	template <vehicle_type type>
+	void undo(const journal_entry &entry)
+	{
+		route_type<type> &r = routes_of<type>()[entry.route];
+		std::uint64_t before_hash = r.hash();
+		switch (entry.operation)
+		{
+		case journal_operation::insert:
+			r.remove(entry.index);
+			M_locations[entry.customer] = unrouted_location;
+			index_stops<type>(entry.route, entry.index);
+			break;
+		case journal_operation::remove:
+			if constexpr (type == vehicle_type::drone)
+				r.undo_remove(entry.index, entry.customer);
+			else
+				r.insert(entry.index, entry.customer);
+			index_stops<type>(entry.route, entry.index);
+			index_flight<type>(entry.route, entry.index);
+			break;
+		case journal_operation::insert_rendevous:
+			if constexpr (type == vehicle_type::truck_drone)
+			{
+				r.remove_rendevous(entry.index);
+				M_locations[entry.service] = unrouted_location;
+				mark_flight(entry.route, entry.customer, entry.reunion, false);
+			}
+			break;
+		case journal_operation::remove_rendevous:
+			if constexpr (type == vehicle_type::truck_drone)
+			{
+				r.undo_remove_rendevous(entry.index, {.departure = entry.customer, .service = entry.service, .reunion = entry.reunion});
+				index_sorties<type>(entry.route, entry.index);
+				mark_flight(entry.route, entry.customer, entry.reunion, true);
+			}
+			break;
+		}
+
+		r.restore_cost_state(entry.route_cost);
+		M_type_cost[static_cast<std::size_t>(type)] = entry.type_cost;
+		M_cost = entry.cost;
+		M_hash ^= route_key(type, entry.route, before_hash) ^ route_key(type, entry.route, r.hash()); // xor undoes exactly
+	}
+
+	template <vehicle_type type>
+	std::vector<route_type<type>> &routes_of() { return std::get<static_cast<std::size_t>(type)>(M_routes); }
+
+	// one empty route per vehicle of the fleet
+	void make_routes()
+	{
+		M_hash = 0;
+		for_each_type([&](auto type) {
+			auto &routes = routes_of<type>();
+			routes.clear();
+			routes.reserve(M_fleet->count(type));
+			for (std::size_t i = 0; i < M_fleet->count(type); ++i)
+			{
+				routes.emplace_back(*M_graph, *M_arenas);
+				M_hash ^= route_key(type, i, routes.back().hash());
+			}
+		});
+	}
+
+	// key of a route of hash at position route of its type, a bijection of hash so two different routes of the same
+	// slot never cancel out, and salted by the slot so equal routes in different slots do not either
+	static constexpr std::uint64_t route_key(vehicle_type type, std::size_t route, std::uint64_t hash)
+	{
+		return mix_bits(hash ^ mix_bits(static_cast<std::uint64_t>(type) << 32 | route));
+	}
+
+	// points the routes at the blocks they occupy in other's arenas, which M_arenas is a copy of
+	void rebind_routes(const basic_solution &other)
+	{
+		for_each_type([&](auto type) {
+			auto &routes = routes_of<type>();
+			routes.clear();
+			routes.reserve(other.template route_count<type>());
+			for (const auto &r : other.template routes<type>())
+				routes.emplace_back(rebind, r, *M_arenas);
+		});
+	}
+
+	// applies fn to a route and updates the cached costs, cost() is called qualified so it is bound statically
+	template <vehicle_type type, typename Fn>
+	void modify(std::size_t route, Fn &&fn)
+	{
+		#if DO_CHECKING
+		if (route >= route_count<type>())
+			throw std::out_of_range("Invalid route");
+		#endif
+
+		route_type<type> &r = routes_of<type>()[route];
+		double before = r.route_type<type>::cost();
+		std::uint64_t before_hash = r.hash();
+		fn(r);
+		double delta = r.route_type<type>::cost() - before;
+
+		M_type_cost[static_cast<std::size_t>(type)] += delta;
+		M_cost += delta;
+		M_hash ^= route_key(type, route, before_hash) ^ route_key(type, route, r.hash());
+	}
+};
+
+using solution = basic_solution<graph>;
+
+VRP_END
@@ -0,0 +1,109 @@
+#pragma once
+#include "graph.h"
+#include "parallel.h"
+#include "spatial.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+VRP_BEG
+
+// truck stop a sortie can depart from or return to, with its drone distance to the customer served
+struct sortie_candidate
+{
+	std::uint32_t customer;
+	double distance;
+};
+
+// the nearest customers a drone can reach from each customer it can carry, nearest first, in one flat array
+// a sortie departure -> service -> reunion is at least drone_distance(departure, service) + reach(service) long, since
+// reunion is another customer, so a customer is only listed for service if that bound is within the drone's range.
+// the lists are drawn from the k nearest customers of the service by drone distance through a spatial grid, so the table
+// holds at most k candidates per customer and is built in about O(n k log k) however much of the area the drone covers.
+// searching the stops of a route for a sortie visits the few listed ones instead of every pair, sorties departing from a
+// stop further away than the k nearest are not considered. the depot and the customers heavier than the drone's
+// capacity have empty lists. drone distances must be symmetric and euclidean over the customer positions, a listed stop
+// may be either end
+class sortie_table
+{
+public:
+	sortie_table() = default;
+	// built by thread_count threads (0 for all cores) reading the graph at once, as for relatedness_index
+	template <graph_backend Graph>
+	sortie_table(const Graph &graph, const vehicle &drone, std::size_t k, std::size_t thread_count = 0)
+	{
+		std::size_t n = graph.size();
+		M_begin.assign(n + 1, 0);
+		M_reach.assign(n, std::numeric_limits<double>::infinity());
+		if (n < 4 || k == 0) // a sortie needs two other customers
+			return;
+
+		const customer_info &customers = graph.customers();
+		spatial_grid grid(customers.positions());
+		k = std::min(k, n - 2); // the depot and the service itself are never listed
+		M_candidates.resize(n * k);
+
+		// each list is written in place with room for k, then the lists are packed
+		std::vector<std::uint32_t> counts(n);
+		parallel_for(1, n, [&](std::size_t s)
+		{
+			if (customers.node(s).demand() > drone.capacity)
+				return;
+
+			thread_local std::vector<std::uint32_t> nearest;
+			nearest.resize(k);
+			std::size_t size = grid.nearest_customers<distance_type::euclidean>(s, k, nearest.data());
+
+			sortie_candidate *list = M_candidates.data() + s * k;
+			for (std::size_t i = 0; i < size; ++i)
+				list[i] = {nearest[i], graph.drone_distance(nearest[i], s)};
+			std::sort(list, list + size, [](const sortie_candidate &a, const sortie_candidate &b)
+			{
+				return a.distance < b.distance || (a.distance == b.distance && a.customer < b.customer);
+			});
+			if (size == 0)
+				return;
+
+			double reach = list[0].distance;
+			M_reach[s] = reach;
+			while (size > 0 && list[size - 1].distance + reach > drone.max_range)
+				--size;
+			counts[s] = static_cast<std::uint32_t>(size);
+		}, thread_count);
+
+		for (std::size_t s = 0; s < n; ++s)
+		{
+			M_begin[s + 1] = M_begin[s] + counts[s];
+			std::copy_n(M_candidates.begin() + s * k, counts[s], M_candidates.begin() + M_begin[s]); // never ahead of s * k
+		}
+		M_candidates.resize(M_begin[n]);
+		M_candidates.shrink_to_fit();
+	}
+
+	bool empty() const { return M_candidates.empty(); }
+
+	// the stops a sortie serving service can depart from or return to, nearest first
+	std::span<const sortie_candidate> candidates(std::size_t service) const
+	{
+		if (M_begin.empty())
+			return {};
+		return {M_candidates.data() + M_begin[service], M_candidates.data() + M_begin[service + 1]};
+	}
+	// drone distance from service to its nearest other customer, infinity if the drone cannot carry it
+	double reach(std::size_t service) const { return M_reach.empty() ? std::numeric_limits<double>::infinity() : M_reach[service]; }
+
+	std::size_t memory_usage() const
+	{
+		return M_candidates.size() * sizeof(sortie_candidate) + M_begin.size() * sizeof(std::size_t) + M_reach.size() * sizeof(double);
+	}
+
+private:
+	std::vector<std::size_t> M_begin; // the list of s is M_candidates[M_begin[s] .. M_begin[s + 1])
+	std::vector<sortie_candidate> M_candidates;
+	std::vector<double> M_reach;
+};
+
+VRP_END
@@ -0,0 +1,205 @@
+#pragma once
+#include <span>
+#include <cstdint>
+#include <algorithm>
+
+#include "info.h"
+
+VRP_BEG
+
+// uniform grid over customer positions, each cell holds about points_per_cell customers
+class spatial_grid
+{
+public:
+	spatial_grid() : M_cells_x{}, M_cells_y{}, M_cell_width{}, M_cell_height{} {}
+	spatial_grid(position_view positions, std::size_t points_per_cell = 2) : M_positions{positions}
+	{
+		if (positions.size == 0)
+		{
+			M_cells_x = M_cells_y = 0;
+			M_cell_width = M_cell_height = 0;
+			return;
+		}
+
+		M_min = M_max = vec2{positions.x[0], positions.y[0]};
+		for (std::size_t i = 1; i < positions.size; ++i)
+		{
+			M_min = {std::min(M_min.x, positions.x[i]), std::min(M_min.y, positions.y[i])};
+			M_max = {std::max(M_max.x, positions.x[i]), std::max(M_max.y, positions.y[i])};
+		}
+
+		M_cells_x = M_cells_y = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(positions.size) / std::max<std::size_t>(points_per_cell, 1)))));
+		M_cell_width = std::max(M_max.x - M_min.x, 1e-9) / M_cells_x;
+		M_cell_height = std::max(M_max.y - M_min.y, 1e-9) / M_cells_y;
+
+		// counting sort of the customers by cell
+		M_cell_begin.assign(M_cells_x * M_cells_y + 1, 0);
+		for (std::size_t i = 0; i < positions.size; ++i)
+			++M_cell_begin[cell(vec2{positions.x[i], positions.y[i]}) + 1];
+		for (std::size_t c = 1; c < M_cell_begin.size(); ++c)
+			M_cell_begin[c] += M_cell_begin[c - 1];
+
+		M_points.resize(positions.size);
+		std::vector<std::uint32_t> fill(M_cell_begin.begin(), M_cell_begin.end() - 1);
+		for (std::size_t i = 0; i < positions.size; ++i)
+			M_points[fill[cell(vec2{positions.x[i], positions.y[i]})]++] = static_cast<std::uint32_t>(i);
+	}
+
+	std::size_t cells_x() const { return M_cells_x; }
+	std::size_t cells_y() const { return M_cells_y; }
+
+	// customers inside cell (x, y)
+	std::span<const std::uint32_t> cell_points(std::size_t x, std::size_t y) const
+	{
+		std::size_t c = y * M_cells_x + x;
+		return {M_points.data() + M_cell_begin[c], M_points.data() + M_cell_begin[c + 1]};
+	}
+
+	// writes the (at most) k nearest customers to customer i by metric type into out, closest first, ties broken by index
+	// customer i itself is excluded, returns the number written
+	template <distance_type type>
+	std::size_t nearest(std::size_t i, std::size_t k, std::uint32_t *out) const
+	{
+		return nearest_to<type>(vec2{M_positions.x[i], M_positions.y[i]}, k, out, i);
+	}
+
+	// the same for any position pos, which may lie outside the grid, skipping the customer exclude
+	template <distance_type type>
+	std::size_t nearest_to(vec2 pos, std::size_t k, std::uint32_t *out, std::size_t exclude = static_cast<std::size_t>(-1)) const
+	{
+		return collect<type>(pos, k, out, [exclude](std::uint32_t p) { return p == exclude; });
+	}
+
+	// the (at most) k nearest customers to customer i other than i and the depot (point 0), as nearest writes them
+	template <distance_type type>
+	std::size_t nearest_customers(std::size_t i, std::size_t k, std::uint32_t *out) const
+	{
+		return collect<type>(vec2{M_positions.x[i], M_positions.y[i]}, k, out, [i](std::uint32_t p) { return p == i || p == 0; });
+	}
+
+private:
+	position_view M_positions;
+	vec2 M_min, M_max;
+	std::size_t M_cells_x, M_cells_y;
+	double M_cell_width, M_cell_height;
+
+	std::vector<std::uint32_t> M_cell_begin; // customers of cell c are M_points[M_cell_begin[c] .. M_cell_begin[c + 1])
+	std::vector<std::uint32_t> M_points;
+
+	// ring search around pos for the k nearest points that skip does not reject
+	template <distance_type type, typename Skip>
+	std::size_t collect(vec2 pos, std::size_t k, std::uint32_t *out, Skip &&skip) const
+	{
+		thread_local std::vector<std::pair<double, std::uint32_t>> heap; // max heap of the best k so far
+		heap.clear();
+		if (k == 0 || M_positions.size == 0)
+			return 0;
+
+		auto [cx, cy] = cell_coords(pos);
+		std::size_t max_ring = std::max(M_cells_x, M_cells_y);
+		double min_cell = std::min(M_cell_width, M_cell_height);
+
+		auto visit = [&](std::size_t x, std::size_t y)
+		{
+			for (std::uint32_t p : cell_points(x, y))
+			{
+				if (skip(p))
+					continue;
+
+				std::pair<double, std::uint32_t> candidate{distance<type>(pos, vec2{M_positions.x[p], M_positions.y[p]}), p};
+				if (heap.size() < k)
+				{
+					heap.push_back(candidate);
+					std::push_heap(heap.begin(), heap.end());
+				}
+				else if (candidate < heap.front())
+				{
+					std::pop_heap(heap.begin(), heap.end());
+					heap.back() = candidate;
+					std::push_heap(heap.begin(), heap.end());
+				}
+			}
+		};
+
+		for (std::size_t ring = 0; ring <= max_ring; ++ring)
+		{
+			// everything in this ring is at least (ring - 1) cells away along some axis, which bounds both metrics
+			if (ring > 1 && heap.size() == k && heap.front().first < (ring - 1) * min_cell)
+				break;
+
+			std::ptrdiff_t r = static_cast<std::ptrdiff_t>(ring);
+			for (std::ptrdiff_t dy = -r; dy <= r; ++dy)
+			{
+				std::ptrdiff_t y = static_cast<std::ptrdiff_t>(cy) + dy;
+				if (y < 0 || y >= static_cast<std::ptrdiff_t>(M_cells_y))
+					continue;
+
+				// interior rows of the ring only have their two end cells
+				std::ptrdiff_t step = (dy == -r || dy == r) ? 1 : std::max<std::ptrdiff_t>(2 * r, 1);
+				for (std::ptrdiff_t dx = -r; dx <= r; dx += step)
+				{
+					std::ptrdiff_t x = static_cast<std::ptrdiff_t>(cx) + dx;
+					if (x >= 0 && x < static_cast<std::ptrdiff_t>(M_cells_x))
+						visit(static_cast<std::size_t>(x), static_cast<std::size_t>(y));
+				}
+			}
+		}
+
+		std::sort_heap(heap.begin(), heap.end());
+		for (std::size_t n = 0; n < heap.size(); ++n)
+			out[n] = heap[n].second;
+		return heap.size();
+	}
+
+	std::pair<std::size_t, std::size_t> cell_coords(vec2 pos) const
+	{
+		auto x = static_cast<std::size_t>(std::max(0.0, (pos.x - M_min.x) / M_cell_width));
+		auto y = static_cast<std::size_t>(std::max(0.0, (pos.y - M_min.y) / M_cell_height));
+		return {std::min(x, M_cells_x - 1), std::min(y, M_cells_y - 1)};
+	}
+
+	std::size_t cell(vec2 pos) const
+	{
+		auto [x, y] = cell_coords(pos);
+		return y * M_cells_x + x;
+	}
+};
+
+// sorted k nearest neighbors of every customer (the depot included) by van and by drone distance
+// both lists of every customer live in one flat array: [van list of 0][drone list of 0][van list of 1]...
+class neighbor_lists
+{
+public:
+	neighbor_lists() : M_k{} {}
+	// k is clamped to customers.size() - 1, lists are built in parallel by thread_count threads (0 for all cores)
+	neighbor_lists(const customer_info &customers, std::size_t k, std::size_t thread_count = 0) :
+		M_k{std::min(k, customers.size() ? customers.size() - 1 : 0)}
+	{
+		spatial_grid grid(customers.positions());
+		M_lists.resize(customers.size() * 2 * M_k);
+
+		parallel_for(0, customers.size(), [&](std::size_t i)
+		{
+			grid.nearest<distance_type::manhattan>(i, M_k, M_lists.data() + i * 2 * M_k);
+			grid.nearest<distance_type::euclidean>(i, M_k, M_lists.data() + i * 2 * M_k + M_k);
+		}, thread_count);
+	}
+
+	// lists laid out as data() returns them, such as read back from a file
+	neighbor_lists(std::size_t k, std::span<const std::uint32_t> lists) : M_k{k}, M_lists(lists.begin(), lists.end()) {}
+
+	std::size_t k() const { return M_k; }
+	bool empty() const { return M_lists.empty(); }
+	std::span<const std::uint32_t> data() const { return M_lists; }
+
+	std::span<const std::uint32_t> van(std::size_t customer) const { return {M_lists.data() + customer * 2 * M_k, M_k}; }
+	std::span<const std::uint32_t> drone(std::size_t customer) const { return {M_lists.data() + customer * 2 * M_k + M_k, M_k}; }
+
+	std::size_t memory_usage() const { return M_lists.size() * sizeof(std::uint32_t); }
+
+private:
+	std::size_t M_k;
+	std::vector<std::uint32_t> M_lists;
+};
+
+VRP_END
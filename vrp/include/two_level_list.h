@@ -0,0 +1,212 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "macro.h"
+
+VRP_BEG
+
+// cyclic order of nodes split into segments of about sqrt(n) nodes (two-level list)
+// the nodes of a segment are contiguous and read forward or backward by its reversed bit, and the segments are kept in
+// tour order, so reversing a path splits at most two segments and then reverses the order of the whole segments between:
+// O(sqrt(n)) instead of the O(n) of reversing an array. splitting adds segments, once there are too many the list is
+// regrouped in O(n), which amortizes to O(sqrt(n)) per reversal. every buffer is sized up front, nothing allocates after
+class two_level_list
+{
+public:
+	static constexpr std::uint32_t absent = static_cast<std::uint32_t>(-1);
+
+	two_level_list() : M_size{}, M_group{} {}
+	// nodes are ids below capacity
+	explicit two_level_list(std::size_t capacity) :
+		M_position(capacity, absent), M_nodes(capacity), M_scratch(capacity), M_segment_of(capacity), M_size{}, M_group{}
+	{
+		M_segments.reserve(capacity);
+		M_order.reserve(capacity);
+	}
+
+	// replaces the list by the nodes of order, in that order
+	void assign(std::span<const std::uint32_t> order)
+	{
+		for (std::size_t p = 0; p < M_size; ++p)
+			M_position[M_nodes[p]] = absent;
+		M_size = order.size();
+		std::ranges::copy(order, M_nodes.begin());
+		for (std::size_t p = 0; p < M_size; ++p)
+			M_position[M_nodes[p]] = static_cast<std::uint32_t>(p);
+		M_order.clear(); // already in order
+		regroup();
+	}
+
+	std::size_t size() const { return M_size; }
+	std::size_t capacity() const { return M_position.size(); }
+	bool contains(std::size_t node) const { return node < M_position.size() && M_position[node] != absent; }
+
+	std::uint32_t next(std::size_t node) const
+	{
+		std::uint32_t p = M_position[node];
+		const segment &s = M_segments[M_segment_of[p]];
+		if (!s.reversed ? p != s.last : p != s.first)
+			return M_nodes[s.reversed ? p - 1 : p + 1];
+		return M_nodes[head(M_order[(s.rank + 1) % M_order.size()])];
+	}
+	std::uint32_t prev(std::size_t node) const
+	{
+		std::uint32_t p = M_position[node];
+		const segment &s = M_segments[M_segment_of[p]];
+		if (!s.reversed ? p != s.first : p != s.last)
+			return M_nodes[s.reversed ? p + 1 : p - 1];
+		return M_nodes[tail(M_order[(s.rank + M_order.size() - 1) % M_order.size()])];
+	}
+
+	// whether b is on the path from a forward to c, both ends included
+	bool between(std::size_t a, std::size_t b, std::size_t c) const
+	{
+		std::uint64_t x = key(a), y = key(b), z = key(c);
+		return x <= z ? x <= y && y <= z : y >= x || y <= z;
+	}
+
+	// reverses the path from a forward to b
+	void reverse(std::size_t a, std::size_t b)
+	{
+		if (a == b)
+			return;
+
+		std::uint32_t pa = M_position[a], pb = M_position[b];
+		if (M_segment_of[pa] == M_segment_of[pb] && offset(pb) >= offset(pa))
+		{
+			// inside one segment, whose path is a contiguous range of positions
+			std::uint32_t lo = std::min(pa, pb), hi = std::max(pa, pb);
+			std::reverse(M_nodes.begin() + lo, M_nodes.begin() + hi + 1);
+			for (std::uint32_t p = lo; p <= hi; ++p)
+				M_position[M_nodes[p]] = p;
+			return;
+		}
+
+		std::uint32_t after = next(b);
+		split_before(a);
+		if (after != a)
+			split_before(after);
+
+		std::size_t count = M_order.size();
+		std::size_t first = M_segments[M_segment_of[M_position[a]]].rank;
+		std::size_t length = (M_segments[M_segment_of[M_position[b]]].rank + count - first) % count + 1;
+		for (std::size_t k = 0; k < length / 2; ++k)
+			std::swap(M_order[(first + k) % count], M_order[(first + length - 1 - k) % count]);
+		for (std::size_t k = 0; k < length; ++k)
+		{
+			segment &s = M_segments[M_order[(first + k) % count]];
+			s.reversed = !s.reversed;
+			s.rank = static_cast<std::uint32_t>((first + k) % count);
+		}
+
+		if (M_order.size() > 2 * (M_size / M_group + 1))
+			regroup();
+	}
+
+	// exchanges the places of a and b
+	void swap(std::size_t a, std::size_t b)
+	{
+		std::swap(M_nodes[M_position[a]], M_nodes[M_position[b]]);
+		std::swap(M_position[a], M_position[b]);
+	}
+
+private:
+	struct segment
+	{
+		std::uint32_t first, last; // range of positions, both included
+		std::uint32_t rank; // index in M_order
+		bool reversed; // read from last to first
+	};
+
+	std::vector<std::uint32_t> M_position; // indexed by node
+	std::vector<std::uint32_t> M_nodes; // indexed by position
+	std::vector<std::uint32_t> M_scratch;
+	std::vector<std::uint32_t> M_segment_of; // indexed by position
+	std::vector<segment> M_segments;
+	std::vector<std::uint32_t> M_order; // segments in tour order
+	std::size_t M_size;
+	std::size_t M_group; // size of the segments after regrouping
+
+	std::uint32_t head(std::uint32_t s) const { return M_segments[s].reversed ? M_segments[s].last : M_segments[s].first; }
+	std::uint32_t tail(std::uint32_t s) const { return M_segments[s].reversed ? M_segments[s].first : M_segments[s].last; }
+
+	// distance of position p from the head of its segment
+	std::uint32_t offset(std::uint32_t p) const
+	{
+		const segment &s = M_segments[M_segment_of[p]];
+		return s.reversed ? s.last - p : p - s.first;
+	}
+	// place of node in the tour, starting from the head of the first segment
+	std::uint64_t key(std::size_t node) const
+	{
+		std::uint32_t p = M_position[node];
+		return static_cast<std::uint64_t>(M_segments[M_segment_of[p]].rank) << 32 | offset(p);
+	}
+
+	// makes node the head of a segment, the part of its segment before it stays in place and the rest follows
+	void split_before(std::uint32_t node)
+	{
+		std::uint32_t p = M_position[node];
+		std::uint32_t id = M_segment_of[p];
+		if (head(id) == p)
+			return;
+
+		segment &s = M_segments[id];
+		segment t{.first = p, .last = s.last, .rank = s.rank + 1, .reversed = s.reversed};
+		if (s.reversed)
+		{
+			t = {.first = s.first, .last = p, .rank = s.rank + 1, .reversed = true};
+			s.first = p + 1;
+		}
+		else
+			s.last = p - 1;
+
+		auto created = static_cast<std::uint32_t>(M_segments.size());
+		for (std::uint32_t q = t.first; q <= t.last; ++q)
+			M_segment_of[q] = created;
+		M_order.insert(M_order.begin() + t.rank, created);
+		M_segments.push_back(t);
+		for (std::size_t r = t.rank + 1; r < M_order.size(); ++r)
+			M_segments[M_order[r]].rank = static_cast<std::uint32_t>(r);
+	}
+
+	// lays the nodes out in tour order again and cuts them into segments of M_group nodes
+	void regroup()
+	{
+		std::size_t n = 0;
+		for (std::uint32_t id : M_order)
+		{
+			const segment &s = M_segments[id];
+			if (s.reversed)
+				for (std::uint32_t p = s.last + 1; p-- > s.first;)
+					M_scratch[n++] = M_nodes[p];
+			else
+				for (std::uint32_t p = s.first; p <= s.last; ++p)
+					M_scratch[n++] = M_nodes[p];
+		}
+		if (!M_order.empty())
+		{
+			std::copy_n(M_scratch.begin(), M_size, M_nodes.begin());
+			for (std::size_t p = 0; p < M_size; ++p)
+				M_position[M_nodes[p]] = static_cast<std::uint32_t>(p);
+		}
+
+		M_group = std::max<std::size_t>(8, static_cast<std::size_t>(std::sqrt(static_cast<double>(M_size))));
+		M_segments.clear();
+		M_order.clear();
+		for (std::size_t first = 0; first < M_size; first += M_group)
+		{
+			auto id = static_cast<std::uint32_t>(M_segments.size());
+			std::size_t last = std::min(first + M_group, M_size) - 1;
+			M_segments.push_back({.first = static_cast<std::uint32_t>(first), .last = static_cast<std::uint32_t>(last), .rank = id, .reversed = false});
+			M_order.push_back(id);
+			std::fill(M_segment_of.begin() + first, M_segment_of.begin() + last + 1, id);
+		}
+	}
+};
+
+VRP_END
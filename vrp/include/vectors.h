@@ -1,8 +1,11 @@
 #pragma once
 #include <cmath>
+#include <span>
 #include <vector>
 #include <numbers>
 #include <type_traits>
+#include <stdexcept>
+#include <utility>
 #include "macro.h"
 
 VRP_BEG
@@ -52,7 +55,13 @@ template <distance_type type>
 inline vec2::value_type distance(vec2 a, vec2 b);
 
 template <>
-inline vec2::value_type distance<distance_type::euclidean>(vec2 a, vec2 b) { return std::hypot(a.x - b.x, a.y - b.y); }
+inline vec2::value_type distance<distance_type::euclidean>(vec2 a, vec2 b)
+{
+	// std::hypot guards against overflow, which is not a concern at map scale, and is several times slower
+	auto dx = a.x - b.x;
+	auto dy = a.y - b.y;
+	return std::sqrt(dx * dx + dy * dy);
+}
 
 template <>
 inline vec2::value_type distance<distance_type::manhattan>(vec2 a, vec2 b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); }
@@ -75,13 +84,77 @@ inline vec2 equirectangular_projection(geographic_vec2 pos, geographic_vec2 cent
 	return res;
 }
 
-class matrix
+// index of (row, col), row < col, in the strict upper triangle of a size x size matrix stored row by row
+// rows before this one hold (size - 1) + (size - 2) + ... + (size - row) elements
+constexpr std::size_t symmetric_index(std::size_t size, std::size_t row, std::size_t col) { return row * (2 * size - row - 3) / 2 + col - 1; }
+
+// read only basic_matrix over elements it does not own, such as a mapped file
+template <typename T>
+class basic_matrix_view
 {
 public:
-	using value_type = double;
+	using value_type = T;
+
+	constexpr basic_matrix_view() : M_data{}, M_rows{}, M_cols{} {}
+	constexpr basic_matrix_view(const value_type *data, std::size_t rows, std::size_t cols) : M_data{data}, M_rows{rows}, M_cols{cols} {}
+
+	constexpr std::size_t rows() const { return M_rows; }
+	constexpr std::size_t cols() const { return M_cols; }
+
+	constexpr const value_type *operator[](std::size_t row) const { return M_data + row * M_cols; }
+	constexpr value_type operator()(std::size_t row, std::size_t col) const { return M_data[row * M_cols + col]; }
+
+	// elements a matrix of this size stores
+	static constexpr std::size_t elements(std::size_t rows, std::size_t cols) { return rows * cols; }
+
+private:
+	const value_type *M_data;
+	std::size_t M_rows, M_cols;
+};
+
+// read only basic_symmetric_matrix over elements it does not own, such as a mapped file
+template <typename T>
+class basic_symmetric_matrix_view
+{
+public:
+	using value_type = T;
+
+	constexpr basic_symmetric_matrix_view() : M_data{}, M_size{} {}
+	constexpr basic_symmetric_matrix_view(const value_type *data, std::size_t rows, std::size_t cols) : M_data{data}, M_size{rows}
+	{
+		if (rows != cols)
+			throw std::invalid_argument("Symmetric matrix must be square");
+	}
+
+	constexpr std::size_t rows() const { return M_size; }
+	constexpr std::size_t cols() const { return M_size; }
+
+	constexpr value_type operator()(std::size_t row, std::size_t col) const
+	{
+		if (row == col)
+			return 0;
+		if (row > col)
+			std::swap(row, col);
+		return M_data[symmetric_index(M_size, row, col)];
+	}
+
+	// elements a matrix of this size stores
+	static constexpr std::size_t elements(std::size_t rows, std::size_t) { return rows * (rows - (rows != 0)) / 2; }
+
+private:
+	const value_type *M_data;
+	std::size_t M_size;
+};
+
+template <typename T>
+class basic_matrix
+{
+public:
+	using value_type = T;
+	using view_type = basic_matrix_view<T>;
 
-	constexpr matrix() : M_rows{}, M_cols{} {}
-	constexpr matrix(std::size_t rows, std::size_t cols) : M_data(rows * cols), M_rows{rows}, M_cols{cols} {}
+	constexpr basic_matrix() : M_rows{}, M_cols{} {}
+	constexpr basic_matrix(std::size_t rows, std::size_t cols) : M_data(rows * cols), M_rows{rows}, M_cols{cols} {}
 
 	constexpr std::size_t rows() const { return M_rows; }
 	constexpr std::size_t cols() const { return M_cols; }
@@ -89,9 +162,78 @@ public:
 	constexpr value_type *operator[](std::size_t row) { return M_data.data() + row * M_cols; }
 	constexpr const value_type *operator[](std::size_t row) const { return M_data.data() + row * M_cols; }
 
+	constexpr value_type operator()(std::size_t row, std::size_t col) const { return M_data[row * M_cols + col]; }
+
+	// sets both (row, col) and (col, row)
+	constexpr void set_symmetric(std::size_t row, std::size_t col, value_type value) { (*this)[row][col] = (*this)[col][row] = value; }
+
+	constexpr std::size_t memory_usage() const { return M_data.size() * sizeof(value_type); }
+
+	// elements in storage order
+	constexpr std::span<const value_type> data() const { return M_data; }
+	constexpr view_type view() const { return {M_data.data(), M_rows, M_cols}; }
+
 private:
 	std::vector<value_type> M_data;
 	std::size_t M_rows, M_cols;
 };
 
+// square symmetric matrix with a zero diagonal
+// only the strict upper triangle is stored, so it takes n * (n - 1) / 2 elements instead of n * n
+template <typename T>
+class basic_symmetric_matrix
+{
+public:
+	using value_type = T;
+	using view_type = basic_symmetric_matrix_view<T>;
+
+	constexpr basic_symmetric_matrix() : M_size{} {}
+	constexpr basic_symmetric_matrix(std::size_t rows, std::size_t cols) : M_data(rows * (rows - (rows != 0)) / 2), M_size{rows}
+	{
+		if (rows != cols)
+			throw std::invalid_argument("Symmetric matrix must be square");
+	}
+
+	constexpr std::size_t rows() const { return M_size; }
+	constexpr std::size_t cols() const { return M_size; }
+
+	constexpr value_type operator()(std::size_t row, std::size_t col) const
+	{
+		if (row == col)
+			return 0;
+		if (row > col)
+			std::swap(row, col);
+		return M_data[index(row, col)];
+	}
+
+	// sets both (row, col) and (col, row), row and col must differ
+	constexpr void set_symmetric(std::size_t row, std::size_t col, value_type value)
+	{
+		if (row > col)
+			std::swap(row, col);
+		M_data[index(row, col)] = value;
+	}
+
+	// elements (row, row + 1) ... (row, rows() - 1) are contiguous
+	constexpr value_type *upper_row(std::size_t row) { return M_data.data() + index(row, row + 1); }
+	constexpr const value_type *upper_row(std::size_t row) const { return M_data.data() + index(row, row + 1); }
+
+	constexpr std::size_t memory_usage() const { return M_data.size() * sizeof(value_type); }
+
+	// elements in storage order
+	constexpr std::span<const value_type> data() const { return M_data; }
+	constexpr view_type view() const { return {M_data.data(), M_size, M_size}; }
+
+private:
+	std::vector<value_type> M_data;
+	std::size_t M_size;
+
+	// row < col
+	constexpr std::size_t index(std::size_t row, std::size_t col) const { return symmetric_index(M_size, row, col); }
+};
+
+using matrix = basic_matrix<double>;
+using symmetric_matrix = basic_symmetric_matrix<double>;
+using compact_symmetric_matrix = basic_symmetric_matrix<float>; // reduced precision, a quarter of the memory of matrix
+
 VRP_END
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+#include "macro.h"
+
+VRP_BEG
+
+// bounded lock free set of 64 bit solution hashes, shared by any number of threads
+// open addressing with a short linear probe, a key whose probe window is full replaces the key at its home slot, so
+// the set never grows or waits and forgets old keys once it is full. contains can therefore miss a key that was
+// inserted, but never finds one that was not, up to hash collisions
+class visited_set
+{
+public:
+	static constexpr std::size_t probe_length = 8;
+
+	visited_set() : M_mask{} {}
+	// capacity is rounded up to a power of two, 0 makes a set that holds nothing
+	explicit visited_set(std::size_t capacity) :
+		M_slots{capacity ? std::make_unique<std::atomic<std::uint64_t>[]>(slots(capacity)) : nullptr},
+		M_mask{capacity ? slots(capacity) - 1 : 0}
+	{
+		clear();
+	}
+
+	// capacity of a set built with capacity
+	static constexpr std::size_t slots(std::size_t capacity) { return capacity ? std::bit_ceil(std::max(capacity, probe_length)) : 0; }
+
+	// adds key, false if it was already in the set
+	bool insert(std::uint64_t key)
+	{
+		if (!M_slots)
+			return true;
+
+		key = stored(key);
+		std::size_t home = static_cast<std::size_t>(key) & M_mask;
+		for (std::size_t probe = 0; probe < probe_length; ++probe)
+		{
+			std::atomic<std::uint64_t> &slot = M_slots[(home + probe) & M_mask];
+			std::uint64_t current = slot.load(std::memory_order_relaxed);
+			if (current == empty && slot.compare_exchange_strong(current, key, std::memory_order_relaxed))
+				return true;
+			if (current == key)
+				return false;
+		}
+
+		M_slots[home].store(key, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool contains(std::uint64_t key) const
+	{
+		if (!M_slots)
+			return false;
+
+		key = stored(key);
+		std::size_t home = static_cast<std::size_t>(key) & M_mask;
+		for (std::size_t probe = 0; probe < probe_length; ++probe)
+		{
+			std::uint64_t current = M_slots[(home + probe) & M_mask].load(std::memory_order_relaxed);
+			if (current == key)
+				return true;
+			if (current == empty)
+				return false;
+		}
+		return false;
+	}
+
+	// empties the set, not concurrently with insert or contains
+	void clear()
+	{
+		if (M_slots)
+			for (std::size_t i = 0; i <= M_mask; ++i)
+				M_slots[i].store(empty, std::memory_order_relaxed);
+	}
+
+	std::size_t capacity() const { return M_slots ? M_mask + 1 : 0; }
+	std::size_t memory_usage() const { return capacity() * sizeof(std::uint64_t); }
+
+private:
+	static constexpr std::uint64_t empty = 0;
+
+	std::unique_ptr<std::atomic<std::uint64_t>[]> M_slots;
+	std::size_t M_mask;
+
+	// 0 marks an empty slot, so the key 0 is stored as 1, the collision it adds is as likely as any other
+	static std::uint64_t stored(std::uint64_t key) { return key ? key : 1; }
+};
+
+VRP_END
@@ -0,0 +1,84 @@
+#include "alns_tuning.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+VRP_BEG
+
+namespace
+{
+	constexpr std::size_t scores = 4, reals = 4, destroys = 4, repairs = 3;
+}
+
+std::vector<tuning::parameter> alns_space()
+{
+	using tuning::parameter_kind;
+	return {
+		{"weight1", parameter_kind::integer, 0, 50},
+		{"weight2", parameter_kind::integer, 0, 50},
+		{"weight3", parameter_kind::integer, 0, 50},
+		{"weight4", parameter_kind::integer, 0, 50},
+		{"rf", parameter_kind::real, 0, 1},
+		{"dod", parameter_kind::real, .05, .9},
+		{"W", parameter_kind::real, 0, 10},
+		{"d_param", parameter_kind::real, 1, 20},
+		{"II", parameter_kind::boolean},
+		{"RD", parameter_kind::boolean},
+		{"WD", parameter_kind::boolean},
+		{"CD", parameter_kind::boolean},
+		{"CI", parameter_kind::boolean},
+		{"GR", parameter_kind::boolean},
+		{"RR", parameter_kind::boolean},
+	};
+}
+
+tuning::configuration alns_configuration(const alns_parameters &parameters)
+{
+	tuning::configuration res(parameters.scores.begin(), parameters.scores.end());
+	res.insert(res.end(), {parameters.reaction_factor, parameters.degree_of_destruction, parameters.start_worse, parameters.determinism});
+	res.insert(res.end(), parameters.destroy.begin(), parameters.destroy.end());
+	res.insert(res.end(), parameters.repair.begin(), parameters.repair.end());
+	return res;
+}
+
+alns_parameters with_configuration(alns_parameters parameters, const tuning::configuration &configuration)
+{
+	if (configuration.size() != scores + reals + destroys + repairs)
+		throw std::invalid_argument("Configuration is not one of alns_space");
+
+	auto value = configuration.begin();
+	for (double &score : parameters.scores)
+		score = *value++;
+	parameters.reaction_factor = *value++;
+	parameters.degree_of_destruction = *value++;
+	parameters.start_worse = *value++;
+	parameters.determinism = *value++;
+	for (bool &enabled : parameters.destroy)
+		enabled = *value++ != 0;
+	for (bool &enabled : parameters.repair)
+		enabled = *value++ != 0;
+	return parameters;
+}
+
+bool alns_allowed(const tuning::configuration &configuration)
+{
+	auto destroy = configuration.begin() + scores + reals, repair = destroy + destroys;
+	return std::any_of(destroy, repair, [](double v) { return v != 0; }) && std::any_of(repair, repair + repairs, [](double v) { return v != 0; });
+}
+
+void tuning_set::add(customer_info customers, const fleet_info &fleet, std::size_t thread_count)
+{
+	M_entries.push_back(std::make_unique<entry>(std::move(customers), fleet, M_base, thread_count));
+}
+
+double tuning_set::evaluate(const tuning::configuration &configuration, std::size_t instance, std::uint64_t seed) const
+{
+	alns_parameters parameters = with_configuration(M_base, configuration);
+	parameters.seed = seed;
+	const entry &set = *M_entries.at(instance);
+	alns search(set.graph, set.fleet, parameters, &set.indexes);
+	search.run();
+	return search.best_objective();
+}
+
+VRP_END
@@ -0,0 +1,155 @@
+#include "batch.h"
+#include "instance.h"
+#include "mapped_file.h"
+#include "multistart.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+VRP_BEG
+
+std::vector<batch_job> parse_manifest(std::string_view text, const std::filesystem::path &directory, double default_time_limit, std::string_view source)
+{
+	std::vector<batch_job> res;
+	std::size_t line = 0;
+	while (!text.empty())
+	{
+		++line;
+		std::size_t end = text.find('\n');
+		std::string_view current = text.substr(0, end);
+		text = end == std::string_view::npos ? std::string_view{} : text.substr(end + 1);
+		current = current.substr(0, current.find('#'));
+
+		auto fail = [&](const std::string &message) { throw std::runtime_error(std::string(source) + ':' + std::to_string(line) + ": " + message); };
+		auto token = [&]()
+		{
+			std::size_t begin = current.find_first_not_of(" \t\r");
+			if (begin == std::string_view::npos)
+				return current = {};
+			current.remove_prefix(begin);
+			std::size_t size = std::min(current.find_first_of(" \t\r"), current.size());
+			std::string_view res = current.substr(0, size);
+			current.remove_prefix(size);
+			return res;
+		};
+
+		std::string_view instance = token();
+		if (instance.empty())
+			continue;
+
+		batch_job job{.instance = directory / std::filesystem::path(instance), .time_limit = default_time_limit};
+		if (std::string_view seconds = token(); !seconds.empty())
+		{
+			auto [at, error] = std::from_chars(seconds.data(), seconds.data() + seconds.size(), job.time_limit);
+			if (error != std::errc{} || at != seconds.data() + seconds.size() || job.time_limit < 0)
+				fail("invalid time limit \"" + std::string(seconds) + '"');
+		}
+		if (!token().empty())
+			fail("expected an instance and a time limit");
+		res.push_back(std::move(job));
+	}
+	return res;
+}
+
+std::vector<batch_job> read_manifest(const std::filesystem::path &path, double default_time_limit)
+{
+	mapped_file file(path);
+	return parse_manifest(file.text(), path.parent_path(), default_time_limit, path.string());
+}
+
+std::vector<std::size_t> longest_first(const std::vector<batch_job> &jobs)
+{
+	struct key
+	{
+		double time_limit;
+		std::uintmax_t size;
+	};
+	std::vector<key> keys(jobs.size());
+	for (std::size_t i = 0; i < jobs.size(); ++i)
+	{
+		std::error_code error;
+		std::uintmax_t size = std::filesystem::file_size(jobs[i].instance, error);
+		keys[i] = {jobs[i].time_limit > 0 ? jobs[i].time_limit : std::numeric_limits<double>::infinity(), error ? 0 : size};
+	}
+
+	std::vector<std::size_t> res(jobs.size());
+	std::iota(res.begin(), res.end(), 0);
+	std::stable_sort(res.begin(), res.end(), [&](std::size_t a, std::size_t b)
+	{
+		return keys[a].time_limit > keys[b].time_limit || (keys[a].time_limit == keys[b].time_limit && keys[a].size > keys[b].size);
+	});
+	return res;
+}
+
+void solve_batch(const std::vector<batch_job> &jobs, const alns_parameters &parameters, std::size_t thread_count, const std::function<void(const batch_result &)> &done)
+{
+	std::vector<std::size_t> order = longest_first(jobs);
+	std::atomic<std::size_t> next{0};
+	std::mutex done_mutex;
+	std::exception_ptr failure; // the first exception done threw, guarded by done_mutex
+
+	auto work = [&]()
+	{
+		alns::scratch buffers;
+		for (std::size_t at = next++; at < order.size(); at = next++)
+		{
+			batch_result result{.job = order[at]};
+			try
+			{
+				instance problem = read_instance(jobs[result.job].instance);
+				graph distances(problem.customers, 1); // each job stays on its pool thread
+
+				alns_parameters job_parameters = parameters;
+				job_parameters.repair_threads = 1; // the pool already has a thread per job, repairs must not add their own
+				job_parameters.time_limit = jobs[result.job].time_limit;
+				job_parameters.seed = derive_seed(parameters.seed, result.job);
+
+				alns search(distances, problem.fleet, job_parameters, nullptr, &buffers);
+				result.statistics = search.run();
+				result.name = std::move(problem.name);
+				result.customers = problem.customers.size() - 1;
+				result.cost = search.best().cost();
+				result.unrouted = alns::unrouted(search.best());
+				search.release(buffers);
+			}
+			catch (const std::exception &e)
+			{
+				result.error = e.what();
+			}
+
+			std::lock_guard lock(done_mutex);
+			if (failure)
+				return;
+			try
+			{
+				done(result);
+			}
+			catch (...)
+			{
+				// an exception must not leave a pool thread, it is thrown again once every thread stopped
+				failure = std::current_exception();
+				next = order.size();
+				return;
+			}
+		}
+	};
+
+	std::size_t threads = std::min(thread_count ? thread_count : default_thread_count(), jobs.size());
+	std::vector<std::jthread> pool;
+	for (std::size_t t = 1; t < threads; ++t)
+		pool.emplace_back(work);
+	work();
+	pool.clear();
+
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+VRP_END
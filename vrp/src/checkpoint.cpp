@@ -0,0 +1,227 @@
+#include "checkpoint.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+VRP_BEG
+
+namespace
+{
+	constexpr char magic[8] = {'P', 'S', 'V', 'R', 'P', 'C', 'K', 'P'};
+	constexpr std::uint32_t version = 2;
+
+	class writer
+	{
+	public:
+		explicit writer(std::ostream &out) : M_out{&out} {}
+
+		template <typename T>
+		void value(const T &v) { M_out->write(reinterpret_cast<const char *>(&v), sizeof(T)); }
+
+		template <typename T, std::size_t n>
+		void values(const std::array<T, n> &v) { M_out->write(reinterpret_cast<const char *>(v.data()), sizeof(T) * n); }
+
+		template <typename T>
+		void array(const std::vector<T> &v)
+		{
+			value(static_cast<std::uint64_t>(v.size()));
+			M_out->write(reinterpret_cast<const char *>(v.data()), static_cast<std::streamsize>(sizeof(T) * v.size()));
+		}
+
+	private:
+		std::ostream *M_out;
+	};
+
+	class reader
+	{
+	public:
+		explicit reader(std::ifstream &in) : M_in{&in}
+		{
+			in.seekg(0, std::ios::end);
+			M_left = static_cast<std::uint64_t>(in.tellg());
+			in.seekg(0);
+		}
+
+		template <typename T>
+		T value()
+		{
+			T v;
+			read(&v, sizeof(T));
+			return v;
+		}
+
+		template <typename T, std::size_t n>
+		void values(std::array<T, n> &v) { read(v.data(), sizeof(T) * n); }
+
+		template <typename T>
+		void array(std::vector<T> &v)
+		{
+			auto size = value<std::uint64_t>();
+			if (size > M_left / sizeof(T)) // checked before allocating, a corrupt length must not allocate the world
+				throw std::runtime_error("Truncated checkpoint");
+			v.resize(size);
+			read(v.data(), sizeof(T) * v.size());
+		}
+
+		bool done() const { return M_left == 0; }
+
+	private:
+		std::ifstream *M_in;
+		std::uint64_t M_left;
+
+		void read(void *out, std::size_t bytes)
+		{
+			if (bytes > M_left || !M_in->read(static_cast<char *>(out), static_cast<std::streamsize>(bytes)))
+				throw std::runtime_error("Truncated checkpoint");
+			M_left -= bytes;
+		}
+	};
+}
+
+void save_checkpoint(const std::filesystem::path &path, const run_checkpoint &checkpoint)
+{
+	write_replacing(path, [&](std::ostream &out)
+	{
+		writer w(out);
+		out.write(magic, sizeof(magic));
+		w.value(version);
+		w.value(checkpoint.customers);
+		w.value(static_cast<std::uint32_t>(checkpoint.searches.size()));
+		for (const search_checkpoint &s : checkpoint.searches)
+		{
+			w.value(s.iteration);
+			w.value(s.temperature);
+			w.value(s.current_objective);
+			w.value(s.best_objective);
+			w.values(s.destroy_weights);
+			w.values(s.destroy_scores);
+			w.values(s.destroy_uses);
+			w.values(s.repair_weights);
+			w.values(s.repair_scores);
+			w.values(s.repair_uses);
+			w.values(s.generator);
+			w.array(s.current);
+			w.array(s.best);
+		}
+	});
+}
+
+run_checkpoint load_checkpoint(const std::filesystem::path &path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		throw std::runtime_error("Cannot open checkpoint \"" + path.string() + '"');
+
+	reader r(in);
+	std::array<char, sizeof(magic)> header;
+	r.values(header);
+	if (std::memcmp(header.data(), magic, sizeof(magic)) != 0)
+		throw std::runtime_error('"' + path.string() + "\" is not a checkpoint");
+	if (r.value<std::uint32_t>() != version)
+		throw std::runtime_error("Unsupported checkpoint version in \"" + path.string() + '"');
+
+	run_checkpoint res;
+	res.customers = r.value<std::uint32_t>();
+	res.searches.resize(r.value<std::uint32_t>());
+	for (search_checkpoint &s : res.searches)
+	{
+		s.iteration = r.value<std::uint64_t>();
+		s.temperature = r.value<double>();
+		s.current_objective = r.value<double>();
+		s.best_objective = r.value<double>();
+		r.values(s.destroy_weights);
+		r.values(s.destroy_scores);
+		r.values(s.destroy_uses);
+		r.values(s.repair_weights);
+		r.values(s.repair_scores);
+		r.values(s.repair_uses);
+		r.values(s.generator);
+		r.array(s.current);
+		r.array(s.best);
+	}
+
+	if (!r.done())
+		throw std::runtime_error("Trailing data in checkpoint \"" + path.string() + '"');
+	return res;
+}
+
+checkpoint_writer::checkpoint_writer(std::filesystem::path path, std::size_t customers, std::size_t searches) :
+	M_path{std::move(path)}, M_pending{.customers = static_cast<std::uint32_t>(customers), .searches = std::vector<search_checkpoint>(searches)},
+	M_writing{M_pending}, M_fresh(searches), M_dirty{false}, M_busy{false}, M_stop{false}, M_written{0}, M_thread{[this]() { write_loop(); }}
+{
+}
+
+checkpoint_writer::~checkpoint_writer()
+{
+	{
+		std::lock_guard lock(M_mutex);
+		M_stop = true;
+	}
+	M_changed.notify_one();
+}
+
+void checkpoint_writer::submit(std::size_t search, search_checkpoint &state)
+{
+	{
+		std::lock_guard lock(M_mutex);
+		std::swap(M_pending.searches.at(search), state);
+		M_fresh[search] = true;
+		M_dirty = true;
+	}
+	M_changed.notify_one();
+}
+
+void checkpoint_writer::flush()
+{
+	std::unique_lock lock(M_mutex);
+	M_idle.wait(lock, [&]() { return !M_dirty && !M_busy; });
+	if (M_error)
+		std::rethrow_exception(std::exchange(M_error, nullptr));
+}
+
+std::size_t checkpoint_writer::written() const
+{
+	std::lock_guard lock(M_mutex);
+	return M_written;
+}
+
+void checkpoint_writer::write_loop()
+{
+	std::unique_lock lock(M_mutex);
+	while (true)
+	{
+		M_changed.wait(lock, [&]() { return M_dirty || M_stop; });
+		if (!M_dirty)
+			return;
+
+		// only the searches submitted since the last write change, the others already hold their latest state in M_writing
+		for (std::size_t i = 0; i < M_fresh.size(); ++i)
+			if (std::exchange(M_fresh[i], false))
+				std::swap(M_writing.searches[i], M_pending.searches[i]);
+		M_dirty = false;
+		M_busy = true;
+		lock.unlock();
+
+		std::exception_ptr error;
+		try
+		{
+			save_checkpoint(M_path, M_writing);
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		lock.lock();
+		M_busy = false;
+		if (error)
+			M_error = error;
+		else
+			++M_written;
+		M_idle.notify_all();
+	}
+}
+
+VRP_END
@@ -0,0 +1,141 @@
+#include "graph_cache.h"
+
+#include <cstring>
+#include <vector>
+
+VRP_BEG
+
+namespace
+{
+	constexpr char magic[8] = {'P', 'S', 'V', 'R', 'P', 'G', 'R', 'F'};
+	constexpr std::uint32_t version = 1;
+	constexpr std::uint32_t byte_order = 0x01020304;
+	constexpr std::size_t alignment = 64;
+	constexpr std::uint64_t max_nodes = std::uint64_t{1} << 28; // keeps every section size far from overflowing
+
+	struct header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint32_t symmetric;
+		std::uint32_t element_size;
+		std::uint64_t nodes;
+		std::uint64_t k;
+		char padding[24];
+	};
+	static_assert(sizeof(header) == alignment);
+
+	constexpr std::size_t align(std::size_t offset) { return (offset + alignment - 1) / alignment * alignment; }
+
+	struct sections
+	{
+		std::size_t matrix_bytes;
+		std::size_t customers, manhattan, euclidean, neighbors, end;
+
+		sections(graph_file_format format, std::size_t nodes, std::size_t k)
+		{
+			std::size_t elements = format.symmetric ? basic_symmetric_matrix_view<float>::elements(nodes, nodes) : basic_matrix_view<float>::elements(nodes, nodes);
+			matrix_bytes = elements * format.element_size;
+			customers = sizeof(header);
+			manhattan = align(customers + nodes * 3 * sizeof(double));
+			euclidean = align(manhattan + matrix_bytes);
+			neighbors = align(euclidean + matrix_bytes);
+			end = neighbors + nodes * 2 * k * sizeof(std::uint32_t);
+		}
+	};
+}
+
+void write_graph_file(const std::filesystem::path &path, graph_file_format format, const customer_info &customers,
+                      std::span<const std::byte> manhattan, std::span<const std::byte> euclidean, const neighbor_lists &neighbors)
+{
+	std::size_t nodes = customers.size(), k = neighbors.empty() ? 0 : neighbors.k();
+	sections at(format, nodes, k);
+	if (manhattan.size() != at.matrix_bytes || euclidean.size() != at.matrix_bytes)
+		throw std::invalid_argument("Matrices do not match the customers");
+
+	header head{};
+	std::memcpy(head.magic, magic, sizeof(magic));
+	head.version = version;
+	head.byte_order = byte_order;
+	head.symmetric = format.symmetric;
+	head.element_size = format.element_size;
+	head.nodes = nodes;
+	head.k = k;
+
+	std::vector<double> points;
+	points.reserve(nodes * 3);
+	for (const customer &c : customers.nodes())
+		points.insert(points.end(), {c.pos().x, c.pos().y, c.demand()});
+
+	write_replacing(path, [&](std::ostream &out)
+	{
+		std::size_t written = 0;
+		auto write = [&](std::size_t offset, const void *data, std::size_t bytes)
+		{
+			static constexpr char zeros[alignment]{};
+			out.write(zeros, static_cast<std::streamsize>(offset - written));
+			out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+			written = offset + bytes;
+		};
+		write(0, &head, sizeof(head));
+		write(at.customers, points.data(), points.size() * sizeof(double));
+		write(at.manhattan, manhattan.data(), manhattan.size());
+		write(at.euclidean, euclidean.data(), euclidean.size());
+		write(at.neighbors, neighbors.data().data(), neighbors.data().size() * sizeof(std::uint32_t));
+	});
+}
+
+graph_file::graph_file(const std::filesystem::path &path, graph_file_format format) :
+	M_file(path), M_format{format}, M_size{}, M_k{}, M_manhattan{}, M_euclidean{}, M_neighbors{}
+{
+	auto fail = [&](const char *message) { throw std::runtime_error('"' + path.string() + "\" " + message); };
+
+	header head;
+	if (M_file.size() < sizeof(head))
+		fail("is not a graph file");
+	std::memcpy(&head, M_file.bytes().data(), sizeof(head));
+	if (std::memcmp(head.magic, magic, sizeof(magic)) != 0)
+		fail("is not a graph file");
+	if (head.version != version)
+		fail("has an unsupported graph file version");
+	if (head.byte_order != byte_order)
+		fail("was written on a machine of another byte order");
+	if (graph_file_format{.symmetric = head.symmetric != 0, .element_size = head.element_size} != format)
+		fail("stores its matrices in another layout");
+	if (head.nodes > max_nodes || (head.nodes && head.k >= head.nodes))
+		fail("is corrupt");
+
+	sections at(format, head.nodes, head.k);
+	if (at.end != M_file.size())
+		fail("is truncated or corrupt");
+
+	M_size = head.nodes;
+	M_k = head.k;
+	M_manhattan = at.manhattan;
+	M_euclidean = at.euclidean;
+	M_neighbors = at.neighbors;
+}
+
+customer_info graph_file::customers() const
+{
+	std::vector<customer> nodes;
+	nodes.reserve(M_size);
+	const std::byte *points = M_file.bytes().data() + sizeof(header);
+	for (std::size_t i = 0; i < M_size; ++i)
+	{
+		double point[3];
+		std::memcpy(point, points + i * sizeof(point), sizeof(point));
+		nodes.emplace_back(vec2{point[0], point[1]}, point[2]);
+	}
+	return customer_info(std::move(nodes));
+}
+
+neighbor_lists graph_file::neighbors() const
+{
+	if (!M_k)
+		return {};
+	return neighbor_lists(M_k, {reinterpret_cast<const std::uint32_t *>(M_file.bytes().data() + M_neighbors), M_size * 2 * M_k});
+}
+
+VRP_END
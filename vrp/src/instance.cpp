@@ -0,0 +1,374 @@
+#include "instance.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+VRP_BEG
+
+namespace
+{
+	// whitespace separated tokens and KEY : value lines straight out of the text, tracking the line for errors
+	class lexer
+	{
+	public:
+		lexer(std::string_view text, std::string_view source, bool comments) :
+			M_text{text}, M_source{source}, M_at{0}, M_line{1}, M_token_line{1}, M_comments{comments}
+		{
+		}
+
+		// next token, possibly on a later line, empty at the end of the text
+		std::string_view token()
+		{
+			skip(true);
+			M_token_line = M_line;
+			std::size_t begin = M_at;
+			while (M_at < M_text.size() && !blank(M_text[M_at]) && !comment(M_text[M_at]))
+				++M_at;
+			return M_text.substr(begin, M_at - begin);
+		}
+
+		template <typename T>
+		T number() { return to_number<T>(token()); }
+
+		// what is left of the current line, without surrounding blanks
+		std::string_view rest_of_line()
+		{
+			skip(false);
+			std::size_t begin = M_at;
+			while (M_at < M_text.size() && M_text[M_at] != '\n' && !comment(M_text[M_at]))
+				++M_at;
+			std::size_t end = M_at;
+			while (end > begin && blank(M_text[end - 1]))
+				--end;
+			return M_text.substr(begin, end - begin);
+		}
+
+		// a KEY : value or KEY: value line, the value of a section name is empty
+		std::pair<std::string_view, std::string_view> header()
+		{
+			skip(true);
+			M_token_line = M_line;
+			std::size_t begin = M_at;
+			while (M_at < M_text.size() && !blank(M_text[M_at]) && M_text[M_at] != ':')
+				++M_at;
+			std::string_view key = M_text.substr(begin, M_at - begin);
+			skip(false);
+			if (M_at < M_text.size() && M_text[M_at] == ':')
+				++M_at;
+			return {key, rest_of_line()};
+		}
+
+		bool done()
+		{
+			skip(true);
+			return M_at == M_text.size();
+		}
+
+		template <typename T>
+		T to_number(std::string_view text) const
+		{
+			T res{};
+			auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), res);
+			if (text.empty() || error != std::errc{} || end != text.data() + text.size())
+				fail(text.empty() ? std::string("expected a number") : "expected a number, found \"" + std::string(text) + '"');
+			return res;
+		}
+
+		[[noreturn]] void fail(const std::string &message) const
+		{
+			throw std::runtime_error(std::string(M_source) + ':' + std::to_string(M_token_line) + ": " + message);
+		}
+
+	private:
+		std::string_view M_text, M_source;
+		std::size_t M_at, M_line, M_token_line;
+		bool M_comments;
+
+		static bool blank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f'; }
+		bool comment(char c) const { return M_comments && c == '#'; }
+
+		void skip(bool newlines)
+		{
+			while (M_at < M_text.size())
+			{
+				char c = M_text[M_at];
+				if (c == '\n')
+				{
+					if (!newlines)
+						return;
+					++M_line;
+				}
+				else if (comment(c))
+				{
+					while (M_at < M_text.size() && M_text[M_at] != '\n')
+						++M_at;
+					continue;
+				}
+				else if (!blank(c))
+					return;
+				++M_at;
+			}
+		}
+	};
+
+	constexpr double unlimited = std::numeric_limits<double>::infinity();
+
+	// the k of a CVRPLIB name like X-n101-k25, 0 if there is none
+	std::size_t name_vehicles(std::string_view name)
+	{
+		std::size_t at = name.rfind("-k");
+		if (at == std::string_view::npos)
+			return 0;
+		std::size_t res = 0;
+		auto [end, error] = std::from_chars(name.data() + at + 2, name.data() + name.size(), res);
+		return error == std::errc{} && end == name.data() + name.size() ? res : 0;
+	}
+
+	instance parse_tsplib(lexer &in)
+	{
+		instance res;
+		bool tsp = false;
+		std::size_t dimension = 0, vehicles = 0;
+		double capacity = unlimited, range = unlimited;
+		std::vector<vec2> positions;
+		std::vector<double> demands;
+		std::size_t depot = 0;
+		bool has_depot = false;
+
+		// node ids run from 1 to DIMENSION
+		auto node = [&]()
+		{
+			auto id = in.number<std::size_t>();
+			if (id == 0 || id > dimension)
+				in.fail("node " + std::to_string(id) + " is not between 1 and DIMENSION");
+			return id - 1;
+		};
+		auto sized = [&](std::string_view section)
+		{
+			if (dimension == 0)
+				in.fail(std::string(section) + " before DIMENSION");
+		};
+
+		while (!in.done())
+		{
+			auto [key, value] = in.header();
+			if (key == "EOF")
+				break;
+			else if (key == "NAME")
+				res.name = value;
+			else if (key == "TYPE")
+			{
+				if (value != "CVRP" && value != "TSP")
+					in.fail("unsupported TYPE \"" + std::string(value) + '"');
+				tsp = value == "TSP";
+			}
+			else if (key == "DIMENSION")
+				dimension = in.to_number<std::size_t>(value);
+			else if (key == "CAPACITY")
+				capacity = in.to_number<double>(value);
+			else if (key == "DISTANCE")
+				range = in.to_number<double>(value);
+			else if (key == "VEHICLES")
+				vehicles = in.to_number<std::size_t>(value);
+			else if (key == "EDGE_WEIGHT_TYPE")
+			{
+				// routes are priced with the graph's manhattan distances, an instance meant for another metric would be
+				// solved for the wrong costs
+				if (value != "MAN_2D")
+					in.fail("unsupported EDGE_WEIGHT_TYPE \"" + std::string(value) + "\", only MAN_2D is supported");
+			}
+			else if (key == "NODE_COORD_SECTION")
+			{
+				sized(key);
+				positions.assign(dimension, vec2{});
+				for (std::size_t i = 0; i < dimension; ++i)
+				{
+					std::size_t id = node();
+					positions[id].x = in.number<double>();
+					positions[id].y = in.number<double>();
+				}
+			}
+			else if (key == "DEMAND_SECTION")
+			{
+				sized(key);
+				demands.assign(dimension, 0);
+				for (std::size_t i = 0; i < dimension; ++i)
+				{
+					std::size_t id = node();
+					demands[id] = in.number<double>();
+				}
+			}
+			else if (key == "DEPOT_SECTION")
+			{
+				sized(key);
+				while (true)
+				{
+					auto token = in.token();
+					if (token == "-1")
+						break;
+					auto id = in.to_number<std::size_t>(token);
+					if (id == 0 || id > dimension)
+						in.fail("depot " + std::to_string(id) + " is not between 1 and DIMENSION");
+					if (!has_depot) // the others are ordinary nodes
+						depot = id - 1;
+					has_depot = true;
+				}
+			}
+			else if (key.ends_with("_SECTION"))
+				in.fail("unsupported section " + std::string(key));
+			// other headers (COMMENT, NODE_COORD_TYPE, ...) change nothing
+		}
+
+		if (positions.empty())
+			in.fail("missing NODE_COORD_SECTION");
+		if (!tsp && demands.empty())
+			in.fail("missing DEMAND_SECTION");
+
+		std::vector<customer> nodes;
+		nodes.reserve(dimension);
+		nodes.emplace_back(positions[depot], 0);
+		double total = 0;
+		for (std::size_t i = 0; i < dimension; ++i)
+		{
+			if (i == depot)
+				continue;
+			double demand = demands.empty() ? 0 : demands[i];
+			nodes.emplace_back(positions[i], demand);
+			total += demand;
+		}
+		res.customers = customer_info(std::move(nodes));
+
+		cost_data none{};
+		if (tsp)
+			res.fleet = fleet_info(1, none, none, none, none, vehicle{.capacity = unlimited, .max_range = range, .cost = 0});
+		else
+		{
+			if (!vehicles)
+				vehicles = name_vehicles(res.name);
+			if (!vehicles) // one spare over the bin packing bound, which is seldom met
+				vehicles = std::isinf(capacity) ? 1 : static_cast<std::size_t>(std::ceil(total / capacity)) + 1;
+			res.fleet = fleet_info(vehicles, none, none, none, none, vehicle{.capacity = capacity, .max_range = range, .cost = 0});
+		}
+		return res;
+	}
+
+	template <std::size_t n>
+	std::size_t lookup(lexer &in, const std::array<std::string_view, n> &names, std::string_view what)
+	{
+		auto name = in.token();
+		auto it = std::find(names.begin(), names.end(), name);
+		if (it == names.end())
+			in.fail("unknown " + std::string(what) + " \"" + std::string(name) + '"');
+		return static_cast<std::size_t>(it - names.begin());
+	}
+
+	instance parse_native(lexer &in)
+	{
+		constexpr std::array<std::string_view, 4> cost_names{"labor", "electric", "fuel", "emissions"};
+		constexpr std::array<std::string_view, 5> vehicle_names{"base", "autonomous", "van", "drone", "truck_drone"};
+		constexpr std::array<std::string_view, 2> coordinate_names{"planar", "geographic"};
+
+		if (auto version = in.number<std::size_t>(); version != 1)
+			in.fail("unsupported version " + std::to_string(version));
+
+		instance res;
+		std::array<cost_data, 4> costs{};
+		std::array<std::size_t, 5> counts{};
+		std::array<vehicle, 5> vehicles{};
+		std::array<bool, 5> listed{};
+		bool geographic = false;
+		std::vector<customer> nodes;
+
+		while (!in.done())
+		{
+			auto directive = in.token();
+			if (directive == "NAME")
+				res.name = in.rest_of_line();
+			else if (directive == "COST")
+			{
+				cost_data &cost = costs[lookup(in, cost_names, "cost")];
+				cost.cost = in.number<double>();
+				cost.cost_rate = in.number<double>();
+			}
+			else if (directive == "VEHICLE")
+			{
+				std::size_t type = lookup(in, vehicle_names, "vehicle");
+				listed[type] = true;
+				counts[type] = in.number<std::size_t>();
+				vehicles[type].capacity = in.number<double>();
+				vehicles[type].max_range = in.number<double>();
+				vehicles[type].cost = in.number<double>();
+			}
+			else if (directive == "COORDINATES")
+				geographic = lookup(in, coordinate_names, "coordinates") == 1;
+			else if (directive == "NODES")
+			{
+				auto count = in.number<std::size_t>();
+				if (count == 0)
+					in.fail("NODES needs at least the depot");
+				nodes.clear();
+				nodes.reserve(count);
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					double x = in.number<double>(), y = in.number<double>(), demand = in.number<double>();
+					nodes.emplace_back(vec2{x, y}, i == 0 ? 0 : demand);
+				}
+			}
+			else
+				in.fail("unknown directive \"" + std::string(directive) + '"');
+		}
+
+		if (nodes.empty())
+			in.fail("missing NODES");
+		if (geographic)
+		{
+			geographic_vec2 center{nodes[0].pos().x, nodes[0].pos().y};
+			for (customer &node : nodes)
+				node = customer(equirectangular_projection({node.pos().x, node.pos().y}, center), node.demand());
+		}
+		res.customers = customer_info(std::move(nodes));
+
+		auto vehicle_index = [](vehicle_type type) { return static_cast<std::size_t>(type); };
+		bool typed = std::find(listed.begin() + 1, listed.end(), true) != listed.end();
+		if (listed[0] && typed)
+			in.fail("a base fleet cannot have other vehicle types");
+		if (!listed[0] && !typed)
+			in.fail("missing VEHICLE");
+		if (listed[0])
+			res.fleet = fleet_info(counts[0], costs[0], costs[1], costs[2], costs[3], vehicles[0]);
+		else
+		{
+			std::size_t autonomous = vehicle_index(vehicle_type::autonomous), van = vehicle_index(vehicle_type::van),
+			            drone = vehicle_index(vehicle_type::drone), truck_drone = vehicle_index(vehicle_type::truck_drone);
+			if (counts[van] + counts[drone] < counts[truck_drone])
+				in.fail("more truck_drone vehicles than van and drone ones");
+			res.fleet = fleet_info(counts[autonomous], counts[van], counts[drone], counts[truck_drone], costs[0], costs[1], costs[2], costs[3],
+			                       vehicles[autonomous], vehicles[van], vehicles[drone], vehicles[truck_drone]);
+		}
+		return res;
+	}
+}
+
+instance parse_instance(std::string_view text, std::string_view source)
+{
+	lexer native(text, source, true);
+	if (native.token() == "PSVRP")
+		return parse_native(native);
+
+	lexer tsplib(text, source, false);
+	return parse_tsplib(tsplib);
+}
+
+instance read_instance(const std::filesystem::path &path)
+{
+	mapped_file file(path);
+	return parse_instance(file.text(), path.string());
+}
+
+VRP_END
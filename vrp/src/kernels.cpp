@@ -0,0 +1,150 @@
+#include "kernels.h"
+
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+// built with -ffp-contract=off (see vrp/CMakeLists.txt): fused multiply-adds would round differently from the scalar
+// path, distances must be identical whichever kernel computes them so that matrices stay exactly symmetric
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VRP_X86 1
+#include <immintrin.h>
+#endif
+
+VRP_BEG
+
+namespace
+{
+	template <distance_type type, typename T>
+	void row_scalar(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, T *out)
+	{
+		vec2 pos{x[i], y[i]};
+		for (std::size_t j = begin; j < end; ++j)
+			out[j - begin] = static_cast<T>(distance<type>(pos, vec2{x[j], y[j]}));
+	}
+
+	#ifdef VRP_X86
+	template <distance_type type>
+	__attribute__((target("avx2"))) inline __m256d distance_avx2(__m256d dx, __m256d dy)
+	{
+		if constexpr (type == distance_type::euclidean)
+			return _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+		else
+		{
+			const __m256d sign = _mm256_set1_pd(-0.0);
+			return _mm256_add_pd(_mm256_andnot_pd(sign, dx), _mm256_andnot_pd(sign, dy));
+		}
+	}
+
+	template <distance_type type, typename T>
+	__attribute__((target("avx2"))) void row_avx2(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, T *out)
+	{
+		const __m256d xi = _mm256_set1_pd(x[i]);
+		const __m256d yi = _mm256_set1_pd(y[i]);
+
+		std::size_t j = begin;
+		for (; j + 4 <= end; j += 4)
+		{
+			__m256d d = distance_avx2<type>(_mm256_sub_pd(xi, _mm256_loadu_pd(x + j)), _mm256_sub_pd(yi, _mm256_loadu_pd(y + j)));
+			if constexpr (std::is_same_v<T, float>)
+				_mm_storeu_ps(out + (j - begin), _mm256_cvtpd_ps(d));
+			else
+				_mm256_storeu_pd(out + (j - begin), d);
+		}
+
+		row_scalar<type>(x, y, i, j, end, out + (j - begin));
+	}
+
+	// GCC 12 reports the undefined first operand its own _mm512_sqrt_pd and _mm512_cvtpd_ps pass to their builtins
+	#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+	#endif
+	template <distance_type type>
+	__attribute__((target("avx512f"))) inline __m512d distance_avx512(__m512d dx, __m512d dy)
+	{
+		if constexpr (type == distance_type::euclidean)
+			return _mm512_sqrt_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)));
+		else
+			return _mm512_add_pd(_mm512_abs_pd(dx), _mm512_abs_pd(dy));
+	}
+
+	template <distance_type type, typename T>
+	__attribute__((target("avx512f"))) void row_avx512(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, T *out)
+	{
+		const __m512d xi = _mm512_set1_pd(x[i]);
+		const __m512d yi = _mm512_set1_pd(y[i]);
+
+		std::size_t j = begin;
+		for (; j + 8 <= end; j += 8)
+		{
+			__m512d d = distance_avx512<type>(_mm512_sub_pd(xi, _mm512_loadu_pd(x + j)), _mm512_sub_pd(yi, _mm512_loadu_pd(y + j)));
+			if constexpr (std::is_same_v<T, float>)
+				_mm256_storeu_ps(out + (j - begin), _mm512_cvtpd_ps(d));
+			else
+				_mm512_storeu_pd(out + (j - begin), d);
+		}
+
+		row_scalar<type>(x, y, i, j, end, out + (j - begin));
+	}
+	#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic pop
+	#endif
+	#endif
+
+	std::atomic<simd_level> &current_level()
+	{
+		static std::atomic<simd_level> level{detected_simd_level()};
+		return level;
+	}
+
+	template <distance_type type, typename T>
+	void dispatch_row(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, T *out)
+	{
+		switch (current_level().load(std::memory_order_relaxed))
+		{
+		#ifdef VRP_X86
+		case simd_level::avx512:
+			row_avx512<type>(x, y, i, begin, end, out);
+			break;
+		case simd_level::avx2:
+			row_avx2<type>(x, y, i, begin, end, out);
+			break;
+		#endif
+		default:
+			row_scalar<type>(x, y, i, begin, end, out);
+			break;
+		}
+	}
+}
+
+simd_level detected_simd_level()
+{
+	#ifdef VRP_X86
+	if (__builtin_cpu_supports("avx512f"))
+		return simd_level::avx512;
+	if (__builtin_cpu_supports("avx2"))
+		return simd_level::avx2;
+	#endif
+	return simd_level::scalar;
+}
+
+simd_level active_simd_level() { return current_level().load(std::memory_order_relaxed); }
+
+void set_simd_level(simd_level level)
+{
+	current_level().store(std::min(level, detected_simd_level()), std::memory_order_relaxed);
+}
+
+template <distance_type type>
+void distance_row(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, double *out) { dispatch_row<type>(x, y, i, begin, end, out); }
+template <distance_type type>
+void distance_row(const double *x, const double *y, std::size_t i, std::size_t begin, std::size_t end, float *out) { dispatch_row<type>(x, y, i, begin, end, out); }
+
+template void distance_row<distance_type::euclidean>(const double *, const double *, std::size_t, std::size_t, std::size_t, double *);
+template void distance_row<distance_type::manhattan>(const double *, const double *, std::size_t, std::size_t, std::size_t, double *);
+template void distance_row<distance_type::euclidean>(const double *, const double *, std::size_t, std::size_t, std::size_t, float *);
+template void distance_row<distance_type::manhattan>(const double *, const double *, std::size_t, std::size_t, std::size_t, float *);
+
+VRP_END
@@ -0,0 +1,129 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+VRP_BEG
+
+mapped_file::mapped_file(const std::filesystem::path &path) : M_data{}, M_size{}
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("Cannot open \"" + path.string() + '"');
+
+	struct stat info;
+	if (::fstat(fd, &info) != 0)
+	{
+		::close(fd);
+		throw std::runtime_error("Cannot read \"" + path.string() + '"');
+	}
+
+	// an empty file cannot be mapped, it is just an empty view
+	if (info.st_size > 0)
+	{
+		void *data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			::close(fd);
+			throw std::runtime_error("Cannot map \"" + path.string() + '"');
+		}
+		M_data = data;
+		M_size = static_cast<std::size_t>(info.st_size);
+	}
+	::close(fd); // the mapping keeps the file alive
+}
+
+mapped_file::~mapped_file()
+{
+	if (M_data)
+		::munmap(M_data, M_size);
+}
+
+mapped_file::mapped_file(mapped_file &&other) noexcept : M_data{std::exchange(other.M_data, nullptr)}, M_size{std::exchange(other.M_size, 0)} {}
+
+mapped_file &mapped_file::operator=(mapped_file &&other) noexcept
+{
+	if (this != &other)
+	{
+		if (M_data)
+			::munmap(M_data, M_size);
+		M_data = std::exchange(other.M_data, nullptr);
+		M_size = std::exchange(other.M_size, 0);
+	}
+	return *this;
+}
+
+namespace
+{
+	// creates an empty file next to path, named after it, the process id and a random suffix, that no other writer in
+	// this process or another gets
+	std::filesystem::path create_temporary(const std::filesystem::path &path)
+	{
+		thread_local std::mt19937_64 gen{std::random_device{}()};
+		for (int attempt = 0; attempt < 16; ++attempt)
+		{
+			std::filesystem::path temporary = path;
+			temporary += '.' + std::to_string(::getpid()) + '.' + std::to_string(gen() & 0xffffffff) + ".tmp";
+			int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+			if (fd >= 0)
+			{
+				::close(fd);
+				return temporary;
+			}
+			if (errno != EEXIST)
+				break;
+		}
+		throw std::runtime_error("Cannot create a temporary file for \"" + path.string() + '"');
+	}
+
+	// flushes what was written to path to the disk, flags opens it as a file or as a directory
+	bool sync(const std::filesystem::path &path, int flags)
+	{
+		int fd = ::open(path.c_str(), flags);
+		if (fd < 0)
+			return false;
+		bool res = ::fsync(fd) == 0;
+		::close(fd);
+		return res;
+	}
+}
+
+void write_replacing(const std::filesystem::path &path, const std::function<void(std::ostream &)> &write)
+{
+	std::filesystem::path temporary = create_temporary(path);
+	try
+	{
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+			if (!out)
+				throw std::runtime_error("Cannot open \"" + temporary.string() + '"');
+			write(out);
+			if (!out.flush())
+				throw std::runtime_error("Cannot write \"" + temporary.string() + '"');
+		}
+		// on the disk before it is renamed, so a crash right after the rename cannot publish an empty file
+		if (!sync(temporary, O_RDONLY))
+			throw std::runtime_error("Cannot sync \"" + temporary.string() + '"');
+		std::filesystem::rename(temporary, path);
+	}
+	catch (...)
+	{
+		std::error_code ignored;
+		std::filesystem::remove(temporary, ignored);
+		throw;
+	}
+
+	// the rename itself, best effort since not every file system syncs directories
+	std::filesystem::path directory = path.parent_path();
+	sync(directory.empty() ? "." : directory, O_RDONLY | O_DIRECTORY);
+}
+
+VRP_END